@@ -36,9 +36,11 @@ umba-enum-gen %GEN_OPTS% %HEX2% %TPL_OVERRIDE% %SNIPPETOPTIONS_GEN_FLAGS%
     %UINT8% %HEX2%  -E=HexRecordType            -F=@HexRecordType.txt                  ^
     %UINT32% %HEX2% -E=ParsingResult            -F=@ParsingResult.txt                  ^
     %UINT32% %HEX2% -E=AddressMode              -F=@AddressMode.txt                    ^
+    %UINT32% %HEX2% -E=HexMergePolicy           -F=@HexMergePolicy.txt                 ^
     %FLAGS%                                                                            ^
     %UINT32% %HEX2% -E=ParsingOptions           -F=@ParsingOptions.txt                 ^
     %UINT32% %HEX2% -E=HexRecordsCheckCode      -F=@HexRecordsCheckCode.txt            ^
+    %UINT32% %HEX2% -E=HexWriterOptions         -F=@HexWriterOptions.txt               ^
 ..\enums.h
 
 
@@ -47,7 +49,9 @@ umba-enum-gen %GEN_OPTS% %HEX2% %TPL_OVERRIDE% %GEN_FLAGS% ^
     %UINT8% %HEX2%  -E=HexRecordType            -F=@HexRecordType.txt                  ^
     %UINT32% %HEX2% -E=ParsingResult            -F=@ParsingResult.txt                  ^
     %UINT32% %HEX2% -E=AddressMode              -F=@AddressMode.txt                    ^
+    %UINT32% %HEX2% -E=HexMergePolicy           -F=@HexMergePolicy.txt                 ^
     %FLAGS%                                                                            ^
     %UINT32% %HEX2% -E=ParsingOptions           -F=@ParsingOptions.txt                 ^
     %UINT32% %HEX2% -E=HexRecordsCheckCode      -F=@HexRecordsCheckCode.txt            ^
+    %UINT32% %HEX2% -E=HexWriterOptions         -F=@HexWriterOptions.txt               ^
 ..\enum_descriptions.h
@@ -0,0 +1,199 @@
+/*! \file
+    \brief Benchmark: BitVector word-scanning operations vs the previous bit-by-bit implementation
+
+    makeRanges over 4M bits at 2%, 50% and 98% density, and counting/setting a range: countSet and
+    setRange vs loops over getBit/setBit. Best time of 5 runs is reported. Results of both implementations
+    are compared, the exit code is 1 on mismatch.
+
+    Not built with the library. Build by hand, marty_cpp must be in the include path:
+        g++ -O2 -std=c++17 -I<path_to_marty_cpp_parent> bench_bit_vector.cpp
+ */
+
+#include "../bit_vector.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+
+using namespace marty::hex;
+
+using bit_vector_t      = BitVector<std::uint32_t>;
+using bit_index_range_t = bit_vector_t::bit_index_range_t;
+
+//----------------------------------------------------------------------------
+// Доступ к словам битового вектора - для предыдущей реализации makeRanges
+struct BitVectorWords : public bit_vector_t
+{
+    const std::vector<std::uint64_t>& words() const { return m_bits; }
+};
+
+//----------------------------------------------------------------------------
+// Предыдущая реализация makeRanges - полные слова целиком, остальные проверяются по одному биту
+namespace prev{
+
+inline
+void addRange(std::vector<bit_index_range_t> &resVec, bit_index_range_t r)
+{
+    if (!resVec.empty() && resVec.back().second==r.first) // Конец предыдущего равен началу добавляемого
+        resVec.back().second = r.second;
+    else
+        resVec.emplace_back(r);
+}
+
+inline
+void makeChunkRanges(std::uint32_t chunkBaseIndex, std::uint64_t chunk, std::vector<bit_index_range_t> &resVec)
+{
+    const std::uint32_t invalidIdx = std::uint32_t(-1);
+
+    std::uint64_t mask     = 1;
+    std::uint32_t beginIdx = invalidIdx;
+    std::uint32_t endIdx   = invalidIdx;
+
+    for(std::uint32_t idx=0u; mask!=0; mask<<=1, ++idx)
+    {
+        if (chunk&mask)
+        {
+            if (beginIdx==invalidIdx)
+                beginIdx = chunkBaseIndex + idx;
+            endIdx = chunkBaseIndex + idx+1;
+        }
+        else if (beginIdx!=invalidIdx)
+        {
+            addRange(resVec, std::make_pair(beginIdx, endIdx));
+            beginIdx = invalidIdx;
+            endIdx   = invalidIdx;
+        }
+    }
+
+    if (beginIdx!=invalidIdx)
+        addRange(resVec, std::make_pair(beginIdx, endIdx));
+}
+
+inline
+void makeRanges(const std::vector<std::uint64_t> &bits, std::uint32_t baseIndex, std::vector<bit_index_range_t> &resVec)
+{
+    std::size_t beginIdx = std::size_t(-1);
+    std::size_t endIdx   = std::size_t(-1);
+
+    for(std::size_t idx=0; idx!=bits.size(); ++idx)
+    {
+        if (bits[idx]==std::uint64_t(-1))
+        {
+            if (beginIdx==std::size_t(-1))
+                beginIdx = idx;
+            endIdx = idx+1;
+        }
+        else
+        {
+            if (beginIdx!=std::size_t(-1))
+            {
+                addRange(resVec, std::make_pair(std::uint32_t(baseIndex+(beginIdx<<6)), std::uint32_t(baseIndex+(endIdx<<6))));
+                beginIdx = std::size_t(-1);
+                endIdx   = std::size_t(-1);
+            }
+
+            if (bits[idx]!=0)
+                makeChunkRanges(std::uint32_t(baseIndex+(idx<<6)), bits[idx], resVec);
+        }
+    }
+
+    if (beginIdx!=std::size_t(-1))
+        addRange(resVec, std::make_pair(std::uint32_t(baseIndex+(beginIdx<<6)), std::uint32_t(baseIndex+(endIdx<<6))));
+}
+
+} // namespace prev
+
+//----------------------------------------------------------------------------
+template<typename F>
+static
+double measureBestMs(F f)
+{
+    double best = 0;
+    for(int i=0; i!=5; ++i)
+    {
+        const auto   t0 = std::chrono::steady_clock::now();
+        f();
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t0).count();
+        if (i==0 || ms<best)
+            best = ms;
+    }
+
+    return best;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    int numFails = 0;
+
+    const std::uint32_t numBits = 0x10000u*64u;
+
+    std::mt19937 rng(7);
+
+    for(int density : {2, 50, 98})
+    {
+        BitVectorWords bv;
+        for(std::uint32_t i=0; i!=numBits; ++i)
+        {
+            if (int(rng()%100u)<density)
+                bv.setBit(i, true);
+        }
+
+        std::vector<bit_index_range_t> prevRanges, curRanges;
+
+        const double prevMs = measureBestMs([&]() { prevRanges.clear(); prev::makeRanges(bv.words(), 0, prevRanges); });
+        const double curMs  = measureBestMs([&]() { curRanges .clear(); bv.makeRanges(curRanges, 0); });
+
+        const bool ok = prevRanges==curRanges;
+        std::printf("%s makeRanges, density %2d%%: %7.2f -> %7.2f ms, ranges: %u\n", ok ? "OK  " : "FAIL", density, prevMs, curMs, unsigned(curRanges.size()));
+        if (!ok)
+            ++numFails;
+
+        // Подсчёт установленных битов
+        std::size_t prevCount = 0, curCount = 0;
+        const double prevCountMs = measureBestMs([&]()
+        {
+            prevCount = 0;
+            for(std::uint32_t i=0; i!=numBits; ++i)
+                prevCount += bv.getBit(i) ? 1u : 0u;
+        });
+        const double curCountMs = measureBestMs([&]() { curCount = bv.countSet(); });
+
+        const bool countOk = prevCount==curCount;
+        std::printf("%s countSet,   density %2d%%: %7.2f -> %7.2f ms, bits: %u\n", countOk ? "OK  " : "FAIL", density, prevCountMs, curCountMs, unsigned(curCount));
+        if (!countOk)
+            ++numFails;
+    }
+
+    {
+        // Заполнение диапазонов, как при записи HEX записей - по 16 байт с невыровненного адреса
+        bit_vector_t prevBv, curBv;
+        const double prevMs = measureBestMs([&]()
+        {
+            for(std::uint32_t b=3; b+16u<=numBits; b+=16u)
+            {
+                for(std::uint32_t i=b; i!=b+16u; ++i)
+                    prevBv.setBit(i, true);
+            }
+        });
+        const double curMs = measureBestMs([&]()
+        {
+            for(std::uint32_t b=3; b+16u<=numBits; b+=16u)
+                curBv.setRange(b, b+16u);
+        });
+
+        std::vector<bit_index_range_t> prevRanges, curRanges;
+        prevBv.makeRanges(prevRanges, 0);
+        curBv .makeRanges(curRanges , 0);
+
+        const bool ok = prevRanges==curRanges && prevBv.size()==curBv.size();
+        std::printf("%s setRange by 16 bits:     %7.2f -> %7.2f ms\n", ok ? "OK  " : "FAIL", prevMs, curMs);
+        if (!ok)
+            ++numFails;
+    }
+
+    return numFails ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+/*! \file
+    \brief Benchmark: MemoryFillMap (page table + last page cache) vs the previous std::map based implementation
+
+    Dense image - 2 MB contiguous, scattered image - 1M random addresses over 256 pages spread over
+    the whole 32-bit space. Best time of 5 runs is reported. Results of both implementations are compared,
+    the exit code is 1 on mismatch.
+
+    Not built with the library. Build by hand, marty_cpp must be in the include path:
+        g++ -O2 -std=c++17 -I<path_to_marty_cpp_parent> bench_memory_fill_map.cpp
+ */
+
+#include "../memory_fill_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <vector>
+
+
+using namespace marty::hex;
+
+//----------------------------------------------------------------------------
+// Предыдущая реализация - страницы в std::map, поиск страницы на каждое обращение
+class MapMemoryFillMap
+{
+
+public:
+
+    using address_t      = std::uint32_t;
+    using bit_vector_t   = BitVector<address_t>;
+    using memory_range_t = typename bit_vector_t::bit_index_range_t;
+
+
+protected:
+
+    std::map<address_t, bit_vector_t >    m_fillMap;
+
+
+public:
+
+    bool getFilled(address_t byteAddr) const
+    {
+        address_t base = byteAddr&~0xFFFFu;
+        std::map<address_t, bit_vector_t >::const_iterator it = m_fillMap.find(base);
+        if (it==m_fillMap.end())
+            return false;
+
+        return it->second.getBit(byteAddr&0xFFFFu);
+    }
+
+    void setFilled(address_t byteAddr, bool bVal=true)
+    {
+        address_t base   = byteAddr&~0xFFFFu;
+        address_t offset = byteAddr& 0xFFFFu;
+        auto &bv = m_fillMap[base];
+        bv.setBit(offset, bVal);
+    }
+
+    bool testAndSetRange(address_t byteAddr, std::size_t size)
+    {
+        bool wasFilled = false;
+
+        while(size)
+        {
+            address_t   base   = byteAddr&~0xFFFFu;
+            address_t   offset = byteAddr& 0xFFFFu;
+            std::size_t chunk  = 0x10000u-std::size_t(offset);
+            if (chunk>size)
+                chunk = size;
+
+            auto &bv = m_fillMap[base];
+            if (bv.testAndSetRange(offset, address_t(offset+chunk)))
+                wasFilled = true;
+
+            byteAddr += address_t(chunk);
+            size     -= chunk;
+        }
+
+        return wasFilled;
+    }
+
+    std::vector<memory_range_t> makeRanges() const
+    {
+        std::vector<memory_range_t> resVec;
+        std::map<address_t, bit_vector_t >::const_iterator it = m_fillMap.begin();
+        for(; it!=m_fillMap.end(); ++it)
+        {
+            it->second.makeRanges(resVec, it->first);
+        }
+
+        return resVec;
+    }
+
+}; // class MapMemoryFillMap
+
+//----------------------------------------------------------------------------
+template<typename F>
+static
+double measureMs(F f)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t0).count();
+}
+
+//----------------------------------------------------------------------------
+struct BenchResult
+{
+    double                                       setMs    = 0;
+    double                                       getMs    = 0;
+    double                                       rangeMs  = 0;
+    std::size_t                                  numFound = 0;
+    std::vector<MemoryFillMap::memory_range_t>   ranges;
+
+}; // struct BenchResult
+
+//----------------------------------------------------------------------------
+// Побайтная запись и чтение, как в checkHexRecords, плюс запись записями по 16 байт
+template<typename FillMapType>
+static
+BenchResult runBench(const std::vector<std::uint32_t> &setAddrs, const std::vector<std::uint32_t> &getAddrs, const std::vector<std::uint32_t> &recordAddrs)
+{
+    BenchResult res;
+    FillMapType fillMap;
+
+    res.setMs = measureMs([&]()
+    {
+        for(auto a : setAddrs)
+            fillMap.setFilled(a);
+    });
+
+    res.getMs = measureMs([&]()
+    {
+        for(auto a : getAddrs)
+            res.numFound += fillMap.getFilled(a) ? 1u : 0u;
+    });
+
+    res.rangeMs = measureMs([&]()
+    {
+        for(auto a : recordAddrs)
+            res.numFound += fillMap.testAndSetRange(a, 16u) ? 1u : 0u;
+    });
+
+    res.ranges = fillMap.makeRanges();
+
+    return res;
+}
+
+//----------------------------------------------------------------------------
+// Первый прогон заметно медленнее из-за выделения памяти, поэтому берём лучшее время из нескольких
+template<typename FillMapType>
+static
+BenchResult runBenchBest(const std::vector<std::uint32_t> &setAddrs, const std::vector<std::uint32_t> &getAddrs, const std::vector<std::uint32_t> &recordAddrs)
+{
+    BenchResult best = runBench<FillMapType>(setAddrs, getAddrs, recordAddrs);
+    for(int i=0; i!=4; ++i)
+    {
+        const BenchResult r = runBench<FillMapType>(setAddrs, getAddrs, recordAddrs);
+        best.setMs   = std::min(best.setMs  , r.setMs  );
+        best.getMs   = std::min(best.getMs  , r.getMs  );
+        best.rangeMs = std::min(best.rangeMs, r.rangeMs);
+    }
+
+    return best;
+}
+
+//----------------------------------------------------------------------------
+static
+bool compareAndPrint(const char *title, const std::vector<std::uint32_t> &setAddrs, const std::vector<std::uint32_t> &getAddrs, const std::vector<std::uint32_t> &recordAddrs)
+{
+    const BenchResult prev = runBenchBest<MapMemoryFillMap>(setAddrs, getAddrs, recordAddrs);
+    const BenchResult cur  = runBenchBest<MemoryFillMap   >(setAddrs, getAddrs, recordAddrs);
+
+    const bool ok = prev.numFound==cur.numFound && prev.ranges==cur.ranges;
+
+    std::printf("%s %-10s: setFilled %7.2f -> %7.2f ms, getFilled %7.2f -> %7.2f ms, testAndSetRange %7.2f -> %7.2f ms, ranges: %u\n"
+               , ok ? "OK  " : "FAIL", title
+               , prev.setMs, cur.setMs, prev.getMs, cur.getMs, prev.rangeMs, cur.rangeMs, unsigned(cur.ranges.size())
+               );
+
+    return ok;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    int numFails = 0;
+
+    {
+        // Плотный образ - 2M подряд с 0x08000000, чтение с запасом по страничке с каждой стороны
+        const std::uint32_t base = 0x08000000u;
+        const std::uint32_t size = 0x200000u;
+
+        std::vector<std::uint32_t> setAddrs, getAddrs, recordAddrs;
+        for(std::uint32_t a=base; a!=base+size; ++a)
+            setAddrs.emplace_back(a);
+        for(std::uint32_t a=base-0x10000u; a!=base+size+0x10000u; ++a)
+            getAddrs.emplace_back(a);
+        for(std::uint32_t a=base+size; a!=base+2u*size; a+=16u)
+            recordAddrs.emplace_back(a);
+
+        if (!compareAndPrint("dense", setAddrs, getAddrs, recordAddrs))
+            ++numFails;
+    }
+
+    {
+        // Разреженный образ - 1M случайных адресов на 256 страницах, разбросанных по всему 32-битному пространству
+        std::mt19937 rng(1);
+        auto randomAddr = [&]() { return (std::uint32_t(rng()%256u)*0x01010000u) | std::uint32_t(rng()&0xFFFFu); };
+
+        std::vector<std::uint32_t> setAddrs(1000000u), getAddrs(1000000u), recordAddrs(100000u);
+        for(auto &a : setAddrs)
+            a = randomAddr();
+        for(auto &a : getAddrs)
+            a = randomAddr();
+        for(auto &a : recordAddrs)
+            a = randomAddr();
+
+        if (!compareAndPrint("scattered", setAddrs, getAddrs, recordAddrs))
+            ++numFails;
+    }
+
+    return numFails ? 1 : 0;
+}
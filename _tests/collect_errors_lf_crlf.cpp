@@ -0,0 +1,78 @@
+/*! \file
+    \brief Check: ParsingOptions::collectErrors gives the same error list for LF and CRLF line endings
+
+    Not built with the library. Build by hand, marty_cpp must be in the include path:
+        g++ -O2 -std=c++17 -I<path_to_marty_cpp_parent> collect_errors_lf_crlf.cpp
+ */
+
+#include "../marty_hex.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+using namespace marty::hex;
+
+//----------------------------------------------------------------------------
+static
+ParsingErrorsReport parseCollectingErrors(const std::string &text, std::size_t &numRecords)
+{
+    IntelHexParser parser;
+    std::vector<HexEntry> records;
+    parser.parseTextChunk(records, text, 0, ParsingOptions::collectErrors);
+    numRecords = records.size();
+    return parser.parsingErrors;
+}
+
+//----------------------------------------------------------------------------
+static
+std::string toCrLf(const std::string &text)
+{
+    std::string res;
+    for(char ch : text)
+    {
+        if (ch=='\n')
+            res.append(1, '\r');
+        res.append(1, ch);
+    }
+    return res;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    const char* const texts[] =
+    { ":ZZ\nXYZ\n:00000001FF\n"                                  // Мусор в строке после ошибки
+    , ":ZZ\nXYZ\n\x1A:00000001FF\n"                              // Ctrl+Z после ошибки
+    , ":0100000001FE\n: 1\n#a\nQ:0100000002FD\n:00000001FF\n"   // Пробел, комментарий без allowComments, мусор перед ':'
+    , ":01\nGG:\n:0000000\n:00000001FF\n"                        // Короткая запись, обрезанный байт
+    };
+
+    int numFails = 0;
+
+    for(const char *pText : texts)
+    {
+        const std::string lfText   = pText;
+        const std::string crlfText = toCrLf(lfText);
+
+        std::size_t lfRecords = 0, crlfRecords = 0;
+        const ParsingErrorsReport lfErrors   = parseCollectingErrors(lfText  , lfRecords  );
+        const ParsingErrorsReport crlfErrors = parseCollectingErrors(crlfText, crlfRecords);
+
+        bool ok = lfErrors.size()==crlfErrors.size() && lfRecords==crlfRecords;
+        for(std::size_t i=0; ok && i!=lfErrors.size(); ++i)
+        {
+            ok = lfErrors[i].result          ==crlfErrors[i].result
+              && lfErrors[i].filePosInfo.line==crlfErrors[i].filePosInfo.line;
+        }
+
+        std::printf("%s: errors LF/CRLF: %u/%u, records LF/CRLF: %u/%u\n", ok ? "OK  " : "FAIL"
+                   , unsigned(lfErrors.size()), unsigned(crlfErrors.size()), unsigned(lfRecords), unsigned(crlfRecords)
+                   );
+        if (!ok)
+            ++numFails;
+    }
+
+    return numFails ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+/*! \file
+    \brief Check: mergeHexRecords keeps a record crossing a 64K window split, so SBA output loads back to the same addresses
+
+    Not built with the library. Build by hand, marty_cpp must be in the include path:
+        g++ -O2 -std=c++17 -I<path_to_marty_cpp_parent> merge_window_split.cpp
+ */
+
+#include "../marty_hex.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+using namespace marty::hex;
+
+//----------------------------------------------------------------------------
+static
+std::vector<HexEntry> parseRecords(const std::string &text)
+{
+    IntelHexParser parser;
+    std::vector<HexEntry> records;
+    parser.parseTextChunk(records, text, 0, ParsingOptions::none);
+    updateHexEntriesAddressAndMode(records);
+    return records;
+}
+
+//----------------------------------------------------------------------------
+// Сравнивает образ памяти, загруженный из текста, с образом исходных записей
+static
+bool checkRoundTrip(const char *title, const std::vector<HexEntry> &input, const std::string &mergedText)
+{
+    MemoryImage expected, loaded;
+    expected.addRecords(input);
+    loaded.addRecords(parseRecords(mergedText));
+
+    const bool ok = expected.makeRanges()==loaded.makeRanges()
+                 && expected.read(0x1FFF8u, 16u)==loaded.read(0x1FFF8u, 16u);
+
+    std::printf("%s: %s\n", ok ? "OK  " : "FAIL", title);
+    if (!ok)
+        std::printf("%s", mergedText.c_str());
+
+    return ok;
+}
+
+//----------------------------------------------------------------------------
+int main()
+{
+    // ESA 0x1800 и 16 байт со смещения 0x7FF8 - адреса 0x1FFF8-0x20007, через границу окна 0x20000
+    const std::string text = ":020000021800E4\n"
+                             ":107FF800000102030405060708090A0B0C0D0E0F01\n"
+                             ":00000001FF\n"
+                             ;
+
+    const std::vector<HexEntry> input = parseRecords(text);
+
+    std::vector<const std::vector<HexEntry>*> inputs = { &input };
+
+    int numFails = 0;
+
+    std::vector<HexEntry> resVec;
+    if (!mergeHexRecords(inputs, HexMergePolicy::lastWins, resVec) || !checkRoundTrip("vector output", input, serializeHexRecords(resVec)))
+        ++numFails;
+
+    HexRecordTable resTbl;
+    if (!mergeHexRecords(inputs, HexMergePolicy::lastWins, resTbl) || !checkRoundTrip("table output", input, serializeHexRecords(resTbl)))
+        ++numFails;
+
+    return numFails ? 1 : 0;
+}
@@ -0,0 +1,368 @@
+/*! \file
+    \brief Streaming conversion of raw binary data to Intel HEX
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "hex_writer.h"
+#include "mapped_file.h"
+#include "parallel_utils.h"
+
+//----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/binary_to_hex.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Конвертация двоичного файла в HEX (см. _md/todo.md_). Адресация (LBA/SBA), переводы строк и регистр
+    цифр задаются опциями HexWriter, остальное - BinaryToHexParams.
+
+    Данные обрабатываются по 64K окнам адресного пространства, и каждое окно - независимо от остальных:
+    записи режутся от начала окна (или от конца пропущенной серии заполнителя), серии заполнителя ищутся
+    внутри окна. Поэтому окна можно форматировать на разных потоках, и результат совпадает с однопоточным
+    побайтно. Серия заполнителя, проходящая через границу окна, рассматривается как две отдельные серии.
+ */
+
+//----------------------------------------------------------------------------
+struct BinaryToHexParams
+{
+    std::uint32_t   loadAddress     = 0;     //!< Адрес первого байта
+    std::size_t     recordSize      = 16;    //!< Байт данных в записи, 1..255
+    bool            skipFill        = false; //!< Пропускать серии байта-заполнителя
+    std::uint8_t    fillByte        = 0xFFu;
+    std::size_t     minFillRun      = 16;    //!< Пропускаются только серии не короче этого - короткие остаются в данных
+    bool            hasStartAddress = false; //!< Записать SLA (SSA в режиме SBA) запись
+    std::uint32_t   startAddress    = 0;
+    std::size_t     numThreads      = 1;     //!< 0 - по числу ядер
+
+}; // struct BinaryToHexParams
+
+//----------------------------------------------------------------------------
+//! Вызывает fn(offset, size) для каждого куска данных, который надо записать, - то, что остаётся после
+//! выкидывания серий заполнителя длиной не меньше minFillRun (если skipFill)
+template<typename DataRunHandler>
+void forEachBinaryDataRun(const std::uint8_t *pData, std::size_t size, const BinaryToHexParams &params, DataRunHandler fn)
+{
+    if (!params.skipFill)
+    {
+        if (size)
+            fn(std::size_t(0), size);
+        return;
+    }
+
+    const std::size_t   minFillRun = params.minFillRun ? params.minFillRun : std::size_t(1u);
+    const std::uint8_t  fillByte   = params.fillByte;
+    std::uint64_t       fillWord   = 0;
+    std::memset(&fillWord, fillByte, sizeof(fillWord));
+
+    std::size_t dataStart = 0;
+    std::size_t pos       = 0;
+
+    while(pos!=size)
+    {
+        if (pData[pos]!=fillByte)
+        {
+            ++pos;
+            continue;
+        }
+
+        const std::size_t runStart = pos;
+
+        // Длинные серии проходим по 8 байт
+        for(; pos+8u<=size; pos+=8u)
+        {
+            std::uint64_t w;
+            std::memcpy(&w, pData+pos, sizeof(w));
+            if (w!=fillWord)
+                break;
+        }
+
+        while(pos!=size && pData[pos]==fillByte)
+            ++pos;
+
+        if (pos-runStart>=minFillRun)
+        {
+            if (runStart!=dataStart)
+                fn(dataStart, runStart-dataStart);
+            dataStart = pos;
+        }
+    }
+
+    if (size!=dataStart)
+        fn(dataStart, size-dataStart);
+}
+
+//------------------------------
+//! Записывает данные с адреса addr, окно за окном. Вызывается для кусков, начинающихся на границе окна
+//! (или с самого первого адреса) - так резка на записи не зависит от того, как данные поделены на куски
+inline
+bool writeBinaryWindows(HexWriter &writer, std::uint32_t addr, const std::uint8_t *pData, std::size_t size, const BinaryToHexParams &params)
+{
+    while(size)
+    {
+        std::size_t windowSize = 0x10000u - std::size_t(addr&0xFFFFu);
+        if (windowSize>size)
+            windowSize = size;
+
+        bool res = true;
+        forEachBinaryDataRun(pData, windowSize, params, [&](std::size_t offset, std::size_t runSize)
+        {
+            if (res)
+                res = writer.writeData(addr+std::uint32_t(offset), pData+offset, runSize);
+        });
+
+        if (!res)
+            return false;
+
+        addr  += std::uint32_t(windowSize);
+        pData += windowSize;
+        size  -= windowSize;
+    }
+
+    return writer.good();
+}
+
+//------------------------------
+//! Стартовый адрес, EOF и сброс буфера писателя
+inline
+bool finishBinaryToHex(HexWriter &writer, const BinaryToHexParams &params)
+{
+    if (params.hasStartAddress)
+        writer.writeStartAddress(params.startAddress);
+    return writer.finish();
+}
+
+//------------------------------
+//! Данные, начиная с loadAddress, должны помещаться в 32-битное адресное пространство, иначе записи с заворотом адреса затрут начало
+inline
+bool checkBinaryToHexSize(std::uint32_t loadAddress, std::uint64_t size)
+{
+    return std::uint64_t(loadAddress)+size<=0x100000000ull;
+}
+
+//----------------------------------------------------------------------------
+/*! Конвертирует буфер. При numThreads!=1 окна форматируются параллельно: данные режутся на задачи по 1M
+    (по границам окон), каждая задача пишет в свою строку своим писателем, и строки по порядку сливаются
+    в основной писатель. Задачи идут пачками по несколько на поток, так что памяти под текст нужно
+    несколько мегабайт на поток, а не под весь результат.
+
+    Писатель каждой задачи считает, что базовый адрес её первого окна уже задан. При склейке ELA/ESA
+    запись перед текстом задачи дописывается, только если базовый адрес действительно меняется - как это
+    сделал бы однопоточный писатель.
+ */
+inline
+bool convertBinaryToHex(HexWriter &writer, const std::uint8_t *pData, std::size_t size, const BinaryToHexParams &params)
+{
+    if (!checkBinaryToHexSize(params.loadAddress, size))
+        return false;
+
+    writer.setRecordSize(params.recordSize);
+
+    const std::size_t taskSize = 16u*0x10000u;
+    const std::size_t firstTaskSize = taskSize - std::size_t(params.loadAddress&0xFFFFu);
+
+    std::size_t numThreads = params.numThreads ? params.numThreads : utils::getHardwareThreadsCount();
+    if (numThreads<=1 || size<=firstTaskSize)
+    {
+        if (!writeBinaryWindows(writer, params.loadAddress, pData, size, params))
+            return false;
+        return finishBinaryToHex(writer, params);
+    }
+
+    const std::size_t numTasks = 1u + (size-firstTaskSize+taskSize-1u)/taskSize;
+    auto taskBegin = [&](std::size_t taskIdx) { return taskIdx ? std::size_t(firstTaskSize+(taskIdx-1u)*taskSize) : std::size_t(0); };
+    auto taskEnd   = [&](std::size_t taskIdx) { return taskIdx+1u==numTasks ? size : taskBegin(taskIdx+1u); };
+
+    struct TaskResult
+    {
+        std::string    text;
+        bool           res                = true;
+        bool           hasFirstWindowData = false; //!< В первом окне задачи что-то записано - перед текстом может понадобиться ELA/ESA
+        bool           hasData            = false;
+        std::uint16_t  lastBaseAddr       = 0;
+    };
+
+    const AddressMode   addressMode    = writer.getAddressMode();
+    const HexRecordType baseRecordType = addressMode==AddressMode::sba ? HexRecordType::extendedSegmentAddress : HexRecordType::extendedLinearAddress;
+
+    const std::size_t batchSize = numThreads*4u;
+    std::vector<TaskResult> results(batchSize);
+
+    for(std::size_t batchBegin=0; batchBegin<numTasks; batchBegin+=batchSize)
+    {
+        const std::size_t batchEnd = batchBegin+batchSize<numTasks ? batchBegin+batchSize : numTasks;
+
+        utils::parallelFor(batchEnd-batchBegin, numThreads, [&](std::size_t idx)
+        {
+            const std::size_t   taskIdx   = batchBegin+idx;
+            const std::size_t   b         = taskBegin(taskIdx);
+            const std::size_t   e         = taskEnd(taskIdx);
+            const std::uint32_t taskAddr  = params.loadAddress+std::uint32_t(b);
+            const std::uint16_t firstBase = getNormalizedBaseAddress(taskAddr, addressMode);
+
+            TaskResult &result = results[idx];
+            result.text.clear();
+            result.text.reserve((e-b)*3u);
+
+            HexWriter taskWriter(writer.getOptions(), 0x10000u);
+            taskWriter.setOutput(result.text);
+            taskWriter.setLineEnd(writer.getLineEnd());
+            taskWriter.setRecordSize(writer.getRecordSize());
+            taskWriter.setCurrentBaseAddress(firstBase);
+
+            // Первое окно задачи отдельно - чтобы знать, было ли в нём что-то записано
+            std::size_t firstWindowSize = 0x10000u - std::size_t(taskAddr&0xFFFFu);
+            if (firstWindowSize>e-b)
+                firstWindowSize = e-b;
+
+            result.res = writeBinaryWindows(taskWriter, taskAddr, pData+b, firstWindowSize, params);
+            result.hasFirstWindowData = taskWriter.getWrittenSize()!=0;
+            if (result.res)
+                result.res = writeBinaryWindows(taskWriter, taskAddr+std::uint32_t(firstWindowSize), pData+b+firstWindowSize, e-b-firstWindowSize, params);
+
+            result.hasData      = taskWriter.getWrittenSize()!=0;
+            result.lastBaseAddr = taskWriter.getCurrentBaseAddress();
+            if (result.res)
+                result.res = taskWriter.flush();
+        });
+
+        for(std::size_t idx=0; idx!=batchEnd-batchBegin; ++idx)
+        {
+            const TaskResult &result = results[idx];
+            if (!result.res)
+                return false;
+
+            if (!result.hasData)
+                continue;
+
+            if (result.hasFirstWindowData)
+            {
+                const std::uint16_t firstBase = getNormalizedBaseAddress(params.loadAddress+std::uint32_t(taskBegin(batchBegin+idx)), addressMode);
+                if (firstBase!=writer.getCurrentBaseAddress())
+                {
+                    const std::uint8_t baseAddrBytes[2] = { std::uint8_t(firstBase>>8), std::uint8_t(firstBase) };
+                    writer.writeRecord(baseRecordType, 0, &baseAddrBytes[0], 2u);
+                }
+            }
+
+            if (!writer.writeText(result.text))
+                return false;
+
+            writer.setCurrentBaseAddress(result.lastBaseAddr);
+        }
+    }
+
+    return finishBinaryToHex(writer, params);
+}
+
+//------------------------------
+inline
+bool convertBinaryToHex(HexWriter &writer, const std::vector<std::uint8_t> &data, const BinaryToHexParams &params)
+{
+    return convertBinaryToHex(writer, data.data(), data.size(), params);
+}
+
+//------------------------------
+/*! Конвертирует двоичный файл. Однопоточно файл читается блоками по 1M через буфер постоянного размера,
+    так что подходит для файлов любого размера и для пайпов. Многопоточно файл отображается в память
+    (MappedFile) и конвертируется как буфер
+ */
+inline
+bool convertBinaryFileToHex(HexWriter &writer, const std::string &binFileName, const BinaryToHexParams &params)
+{
+    if (params.numThreads!=1)
+    {
+        MappedFile mappedFile;
+        if (!mappedFile.open(binFileName))
+            return false;
+        return convertBinaryToHex(writer, (const std::uint8_t*)mappedFile.data(), mappedFile.size(), params);
+    }
+
+    std::FILE *pFile = std::fopen(binFileName.c_str(), "rb");
+    if (!pFile)
+        return false;
+
+    writer.setRecordSize(params.recordSize);
+
+    // Блоки заканчиваются на границе окна - тогда каждый следующий блок начинается с начала окна
+    const std::size_t blockSize = 16u*0x10000u;
+    std::vector<std::uint8_t> buf(blockSize);
+
+    std::uint32_t addr      = params.loadAddress;
+    std::uint64_t totalSize = 0;
+    std::size_t   readSize  = blockSize - std::size_t(addr&0xFFFFu);
+    bool          res       = true;
+
+    for(;;)
+    {
+        const std::size_t numRead = std::fread(buf.data(), 1u, readSize, pFile);
+        totalSize += numRead;
+
+        if (!checkBinaryToHexSize(params.loadAddress, totalSize) || !writeBinaryWindows(writer, addr, buf.data(), numRead, params))
+        {
+            res = false;
+            break;
+        }
+
+        addr += std::uint32_t(numRead);
+
+        if (numRead!=readSize)
+        {
+            res = std::ferror(pFile)==0;
+            break;
+        }
+
+        readSize = blockSize;
+    }
+
+    std::fclose(pFile);
+
+    return res && finishBinaryToHex(writer, params);
+}
+
+//------------------------------
+//! Конвертирует двоичный файл в HEX файл
+inline
+bool convertBinaryFileToHex( const std::string       &binFileName
+                           , const std::string       &hexFileName
+                           , const BinaryToHexParams &params
+                           , HexWriterOptions         writerOptions = HexWriterOptions::none
+                           )
+{
+    HexWriter writer(writerOptions);
+    if (!writer.open(hexFileName))
+        return false;
+
+    if (!convertBinaryFileToHex(writer, binFileName, params))
+        return false;
+
+    return writer.close();
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/binary_to_hex.h
+
@@ -63,45 +63,24 @@ protected:
         return bit_chunk_t(1) << (bitIndex&0x3F);
     }
 
+    //! Диапазоны установленных битов слова. Идём не по всем 64 битам, а прыжками от серии к серии через ctz,
+    //! так что цена пропорциональна числу серий
     template<typename OutputIteratorType>
     static
     OutputIteratorType makeChunkRanges(bit_index_t chunkBaseIndex, bit_chunk_t chunk, OutputIteratorType oit)
     {
-        bit_chunk_t mask = 1;
-
-        //std::pair<bit_index_t, bit_index_t> curRange;
-        //bool crValid = false;
-
-        bit_index_t beginIdx = invalid_bit_index;
-        bit_index_t endIdx   = invalid_bit_index;
-
-        for(bit_index_t idx=0u; mask!=0; mask<<=1, ++idx)
+        while(chunk)
         {
-            if (chunk&mask)
-            {
-                // Бит установлен
+            const unsigned beginBit = utils::countTrailingZeros64(chunk);  // Начало серии единиц
+            const bit_chunk_t rest  = ~(chunk>>beginBit);                  // Единицы там, где серия кончилась
+            const unsigned endBit   = rest ? beginBit+utils::countTrailingZeros64(rest) : 64u;
 
-                if (beginIdx==invalid_bit_index)
-                {
-                    beginIdx = chunkBaseIndex + idx; // Устанавливаем начало диапазона, раз было не задано
-                }
+            *oit++ = std::make_pair(bit_index_t(chunkBaseIndex+beginBit), bit_index_t(chunkBaseIndex+endBit));
 
-                endIdx = chunkBaseIndex + idx+1; // Обновляем конец диапазона
-            }
-            else // Бит сброшен
-            {
-                if (beginIdx!=invalid_bit_index) // Диапазон был задан
-                {
-                    *oit++ = std::make_pair(beginIdx, endIdx);
-                    beginIdx = invalid_bit_index;
-                    endIdx   = invalid_bit_index;
-                }
-            }
-        }
+            if (endBit>=64u)
+                break;
 
-        if (beginIdx!=invalid_bit_index) // Диапазон был задан
-        {
-            *oit++ = std::make_pair(beginIdx, endIdx);
+            chunk &= bit_chunk_t(-1) << endBit; // Убираем обработанную серию
         }
 
         return oit;
@@ -218,6 +197,135 @@ public:
     }
 
 
+    //! Резервирует место под numBits бит, размер не меняется. Для страниц памяти - чтобы не расти по одному слову
+    void reserve(bit_index_t numBits)
+    {
+        m_bits.reserve((std::size_t(numBits)+63u)>>6);
+    }
+
+    //! Количество установленных битов
+    std::size_t countSet() const
+    {
+        std::size_t res = 0;
+        for(auto chunk : m_bits)
+            res += utils::popCount64(chunk);
+        return res;
+    }
+
+    //! Установлены ли все биты [beginIdx, endIdx). Проверка целыми словами по маскам, до первого сброшенного бита.
+    //! За пределами хранимых слов биты нулевые. Пустой диапазон - true
+    bool isRangeSet(bit_index_t beginIdx, bit_index_t endIdx) const
+    {
+        if (beginIdx>=endIdx)
+            return true;
+
+        const std::size_t firstChunkIdx = calcChunkIndex(beginIdx);
+        const std::size_t lastChunkIdx  = calcChunkIndex(bit_index_t(endIdx-1u));
+        if (lastChunkIdx>=m_bits.size())
+            return false;
+
+        const bit_chunk_t firstMask = bit_chunk_t(-1) << (beginIdx&0x3F);
+        const bit_chunk_t lastMask  = bit_chunk_t(-1) >> (0x3F-((endIdx-1u)&0x3F));
+
+        if (firstChunkIdx==lastChunkIdx)
+            return (m_bits[firstChunkIdx]&firstMask&lastMask)==(firstMask&lastMask);
+
+        if ((m_bits[firstChunkIdx]&firstMask)!=firstMask)
+            return false;
+
+        for(std::size_t chunkIdx=firstChunkIdx+1u; chunkIdx!=lastChunkIdx; ++chunkIdx)
+        {
+            if (m_bits[chunkIdx]!=bit_chunk_t(-1))
+                return false;
+        }
+
+        return (m_bits[lastChunkIdx]&lastMask)==lastMask;
+    }
+
+    //! Устанавливает биты [beginIdx, endIdx) целыми 64-битными словами по маскам.
+    //! Возвращает true, если хоть один из этих битов уже был установлен
+    bool testAndSetRange(bit_index_t beginIdx, bit_index_t endIdx)
+    {
+        if (beginIdx>=endIdx)
+            return false;
+
+        const std::size_t firstChunkIdx = calcChunkIndex(beginIdx);
+        const std::size_t lastChunkIdx  = calcChunkIndex(bit_index_t(endIdx-1u));
+        if (lastChunkIdx>=m_bits.size())
+        {
+            m_bits.resize(lastChunkIdx+1u, 0u);
+        }
+
+        if (m_size<std::size_t(endIdx))
+            m_size = std::size_t(endIdx);
+
+        const bit_chunk_t firstMask = bit_chunk_t(-1) << (beginIdx&0x3F);
+        const bit_chunk_t lastMask  = bit_chunk_t(-1) >> (0x3F-((endIdx-1u)&0x3F));
+
+        bit_chunk_t wasSet = 0;
+
+        if (firstChunkIdx==lastChunkIdx)
+        {
+            const bit_chunk_t mask = firstMask&lastMask;
+            wasSet = m_bits[firstChunkIdx]&mask;
+            m_bits[firstChunkIdx] |= mask;
+            return wasSet!=0;
+        }
+
+        wasSet |= m_bits[firstChunkIdx]&firstMask;
+        m_bits[firstChunkIdx] |= firstMask;
+
+        for(std::size_t chunkIdx=firstChunkIdx+1u; chunkIdx!=lastChunkIdx; ++chunkIdx)
+        {
+            wasSet |= m_bits[chunkIdx];
+            m_bits[chunkIdx] = bit_chunk_t(-1);
+        }
+
+        wasSet |= m_bits[lastChunkIdx]&lastMask;
+        m_bits[lastChunkIdx] |= lastMask;
+
+        return wasSet!=0;
+    }
+
+    //! Устанавливает биты [beginIdx, endIdx), размер растёт как у setBit
+    void setRange(bit_index_t beginIdx, bit_index_t endIdx)
+    {
+        testAndSetRange(beginIdx, endIdx);
+    }
+
+    //! Сбрасывает биты [beginIdx, endIdx). За пределами хранимых слов биты и так нулевые, поэтому размер не растёт
+    void clearRange(bit_index_t beginIdx, bit_index_t endIdx)
+    {
+        if (beginIdx>=endIdx)
+            return;
+
+        const std::size_t firstChunkIdx = calcChunkIndex(beginIdx);
+        if (firstChunkIdx>=m_bits.size())
+            return;
+
+        std::size_t lastChunkIdx = calcChunkIndex(bit_index_t(endIdx-1u));
+        bit_chunk_t lastMask     = bit_chunk_t(-1) >> (0x3F-((endIdx-1u)&0x3F));
+        if (lastChunkIdx>=m_bits.size())
+        {
+            lastChunkIdx = m_bits.size()-1u;
+            lastMask     = bit_chunk_t(-1);
+        }
+
+        const bit_chunk_t firstMask = bit_chunk_t(-1) << (beginIdx&0x3F);
+
+        if (firstChunkIdx==lastChunkIdx)
+        {
+            m_bits[firstChunkIdx] &= ~(firstMask&lastMask);
+            return;
+        }
+
+        m_bits[firstChunkIdx] &= ~firstMask;
+        for(std::size_t chunkIdx=firstChunkIdx+1u; chunkIdx!=lastChunkIdx; ++chunkIdx)
+            m_bits[chunkIdx] = 0;
+        m_bits[lastChunkIdx] &= ~lastMask;
+    }
+
+
     void makeRanges(std::vector<bit_index_range_t> &resVec, bit_index_t baseIndex) const
     {
         makeRanges(baseIndex, BitIndexRangesBackInsertIterator(resVec));
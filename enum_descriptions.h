@@ -66,7 +66,10 @@ std::map<ParsingResult, std::string> m =
 { ParsingResult::mismatchAddressMode         , "Address mode mismatch to previously assigned address mode (mixed segment and linear address records)" },
 { ParsingResult::mismatchStartAddressMode    , "Start address mode mismatch to address mode (mixed segment and linear address records)" },
 { ParsingResult::multipleStartAddress        , "Start address already defined" },
-{ ParsingResult::memoryOverlaps              , "Multiple records adress the same memory" }
+{ ParsingResult::memoryOverlaps              , "Multiple records adress the same memory" },
+{ ParsingResult::fileReadError               , "File read error" },
+{ ParsingResult::dumpAddressMissing          , "Dump data encountered before any address was set" },
+{ ParsingResult::dumpAddressTooBig           , "Dump address is too big (address or segment/offset too wide, or data does not fit the address space)" }
 };
 return m;
 } // inline std::map<ParsingResult, std::string> makeParsingResultDescriptionMap()
@@ -103,6 +106,27 @@ inline const std::map<AddressMode, std::string>& getAddressModeDescriptionMap()
 
 
 
+inline std::map<HexMergePolicy, std::string> makeHexMergePolicyDescriptionMap()
+{
+std::map<HexMergePolicy, std::string> m =
+{
+{ HexMergePolicy::errorOnOverlap  , "Any overlap of data is an error" },
+{ HexMergePolicy::allowIdentical  , "Overlap is allowed if overlapping bytes are identical" },
+{ HexMergePolicy::lastWins        , "Overlapping bytes are taken from the latter input" },
+{ HexMergePolicy::firstWins       , "Overlapping bytes are taken from the former input" }
+};
+return m;
+} // inline std::map<HexMergePolicy, std::string> makeHexMergePolicyDescriptionMap()
+
+inline const std::map<HexMergePolicy, std::string>& getHexMergePolicyDescriptionMap()
+{
+    static auto m = makeHexMergePolicyDescriptionMap();
+    return m;
+}
+
+
+
+
 inline std::map<ParsingOptions, std::string> makeParsingOptionsDescriptionMap()
 {
 std::map<ParsingOptions, std::string> m =
@@ -110,7 +134,8 @@ std::map<ParsingOptions, std::string> m =
 { ParsingOptions::none           , "" },
 { ParsingOptions::allowComments  , "Allow comments (lines with '#' character first)" },
 { ParsingOptions::allowSpaces    , "Allow spaces in HEX lines" },
-{ ParsingOptions::allowMultiHex  , "Normal HEX ends with EOF record. If we need read multiple HEXes from single text, we set this option" }
+{ ParsingOptions::allowMultiHex  , "Normal HEX ends with EOF record. If we need read multiple HEXes from single text, we set this option" },
+{ ParsingOptions::collectErrors  , "Don't stop at the first error - report it, skip to the next record and continue parsing" }
 };
 return m;
 } // inline std::map<ParsingOptions, std::string> makeParsingOptionsDescriptionMap()
@@ -144,6 +169,26 @@ inline const std::map<HexRecordsCheckCode, std::string>& getHexRecordsCheckCodeD
 
 
 
+
+inline std::map<HexWriterOptions, std::string> makeHexWriterOptionsDescriptionMap()
+{
+std::map<HexWriterOptions, std::string> m =
+{
+{ HexWriterOptions::none                , "" },
+{ HexWriterOptions::crlf                , "Use CR LF line endings (LF by default)" },
+{ HexWriterOptions::lowercase           , "Use lowercase hex digits" },
+{ HexWriterOptions::segmentAddressMode  , "Emit ESA records instead of ELA when address crosses 64K boundary (addresses up to 1M)" }
+};
+return m;
+} // inline std::map<HexWriterOptions, std::string> makeHexWriterOptionsDescriptionMap()
+
+inline const std::map<HexWriterOptions, std::string>& getHexWriterOptionsDescriptionMap()
+{
+    static auto m = makeHexWriterOptionsDescriptionMap();
+    return m;
+}
+
+
 } // namespace hex
 } // namespace marty
 
@@ -87,7 +87,10 @@ enum class ParsingResult : std::uint32_t
     mismatchAddressMode          = 0x0D /*!< Address mode mismatch to previously assigned address mode (mixed segment and linear address records) */,
     mismatchStartAddressMode     = 0x0E /*!< Start address mode mismatch to address mode (mixed segment and linear address records) */,
     multipleStartAddress         = 0x0F /*!< Start address already defined */,
-    memoryOverlaps               = 0x10 /*!< Multiple records adress the same memory */
+    memoryOverlaps               = 0x10 /*!< Multiple records adress the same memory */,
+    fileReadError                = 0x11 /*!< File read error */,
+    dumpAddressMissing           = 0x12 /*!< Dump data encountered before any address was set */,
+    dumpAddressTooBig            = 0x13 /*!< Dump address is too big (address or segment/offset too wide, or data does not fit the address space) */
 
 }; // enum 
 //#!
@@ -95,6 +98,9 @@ enum class ParsingResult : std::uint32_t
 MARTY_CPP_MAKE_ENUM_IS_FLAGS_FOR_NON_FLAGS_ENUM(ParsingResult)
 
 MARTY_CPP_ENUM_CLASS_SERIALIZE_BEGIN( ParsingResult, std::map, 1 )
+    MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( ParsingResult::dumpAddressTooBig            , "DumpAddressTooBig"          );
+    MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( ParsingResult::dumpAddressMissing           , "DumpAddressMissing"         );
+    MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( ParsingResult::fileReadError                , "FileReadError"              );
     MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( ParsingResult::memoryOverlaps               , "MemoryOverlaps"             );
     MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( ParsingResult::multipleStartAddress         , "MultipleStartAddress"       );
     MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( ParsingResult::mismatchStartAddressMode     , "MismatchStartAddressMode"   );
@@ -115,6 +121,15 @@ MARTY_CPP_ENUM_CLASS_SERIALIZE_BEGIN( ParsingResult, std::map, 1 )
 MARTY_CPP_ENUM_CLASS_SERIALIZE_END( ParsingResult, std::map, 1 )
 
 MARTY_CPP_ENUM_CLASS_DESERIALIZE_BEGIN( ParsingResult, std::map, 1 )
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::dumpAddressTooBig            , "dump-address-too-big"            );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::dumpAddressTooBig            , "dump_address_too_big"            );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::dumpAddressTooBig            , "dumpaddresstoobig"               );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::dumpAddressMissing           , "dump-address-missing"            );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::dumpAddressMissing           , "dump_address_missing"            );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::dumpAddressMissing           , "dumpaddressmissing"              );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::fileReadError                , "file-read-error"                 );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::fileReadError                , "file_read_error"                 );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::fileReadError                , "filereaderror"                   );
     MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::memoryOverlaps               , "memory-overlaps"                 );
     MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::memoryOverlaps               , "memory_overlaps"                 );
     MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( ParsingResult::memoryOverlaps               , "memoryoverlaps"                  );
@@ -203,13 +218,50 @@ MARTY_CPP_ENUM_CLASS_DESERIALIZE_BEGIN( AddressMode, std::map, 1 )
 MARTY_CPP_ENUM_CLASS_DESERIALIZE_END( AddressMode, std::map, 1 )
 
 
+//#!HexMergePolicy
+enum class HexMergePolicy : std::uint32_t
+{
+    errorOnOverlap   = 0x00 /*!< Any overlap of data is an error */,
+    allowIdentical   = 0x01 /*!< Overlap is allowed if overlapping bytes are identical */,
+    lastWins         = 0x02 /*!< Overlapping bytes are taken from the latter input */,
+    firstWins        = 0x03 /*!< Overlapping bytes are taken from the former input */
+
+}; // enum 
+//#!
+
+MARTY_CPP_MAKE_ENUM_IS_FLAGS_FOR_NON_FLAGS_ENUM(HexMergePolicy)
+
+MARTY_CPP_ENUM_CLASS_SERIALIZE_BEGIN( HexMergePolicy, std::map, 1 )
+    MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( HexMergePolicy::firstWins        , "FirstWins"      );
+    MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( HexMergePolicy::lastWins         , "LastWins"       );
+    MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( HexMergePolicy::allowIdentical   , "AllowIdentical" );
+    MARTY_CPP_ENUM_CLASS_SERIALIZE_ITEM( HexMergePolicy::errorOnOverlap   , "ErrorOnOverlap" );
+MARTY_CPP_ENUM_CLASS_SERIALIZE_END( HexMergePolicy, std::map, 1 )
+
+MARTY_CPP_ENUM_CLASS_DESERIALIZE_BEGIN( HexMergePolicy, std::map, 1 )
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::firstWins        , "first-wins"       );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::firstWins        , "first_wins"       );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::firstWins        , "firstwins"        );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::lastWins         , "last-wins"        );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::lastWins         , "last_wins"        );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::lastWins         , "lastwins"         );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::allowIdentical   , "allow-identical"  );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::allowIdentical   , "allow_identical"  );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::allowIdentical   , "allowidentical"   );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::errorOnOverlap   , "error-on-overlap" );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::errorOnOverlap   , "error_on_overlap" );
+    MARTY_CPP_ENUM_CLASS_DESERIALIZE_ITEM( HexMergePolicy::errorOnOverlap   , "erroronoverlap"   );
+MARTY_CPP_ENUM_CLASS_DESERIALIZE_END( HexMergePolicy, std::map, 1 )
+
+
 //#!ParsingOptions
 enum class ParsingOptions : std::uint32_t
 {
     none            = 0x00 /*!<  */,
     allowComments   = 0x01 /*!< Allow comments (lines with '#' character first) */,
     allowSpaces     = 0x02 /*!< Allow spaces in HEX lines */,
-    allowMultiHex   = 0x04 /*!< Normal HEX ends with EOF record. If we need read multiple HEXes from single text, we set this option */
+    allowMultiHex   = 0x04 /*!< Normal HEX ends with EOF record. If we need read multiple HEXes from single text, we set this option */,
+    collectErrors   = 0x08 /*!< Don't stop at the first error - report it, skip to the next record and continue parsing */
 
 }; // enum 
 //#!
@@ -217,6 +269,7 @@ enum class ParsingOptions : std::uint32_t
 MARTY_CPP_MAKE_ENUM_FLAGS(ParsingOptions)
 
 MARTY_CPP_ENUM_FLAGS_SERIALIZE_BEGIN( ParsingOptions, std::map, 1 )
+    MARTY_CPP_ENUM_FLAGS_SERIALIZE_ITEM( ParsingOptions::collectErrors   , "CollectErrors" );
     MARTY_CPP_ENUM_FLAGS_SERIALIZE_ITEM( ParsingOptions::allowMultiHex   , "AllowMultiHex" );
     MARTY_CPP_ENUM_FLAGS_SERIALIZE_ITEM( ParsingOptions::allowSpaces     , "AllowSpaces"   );
     MARTY_CPP_ENUM_FLAGS_SERIALIZE_ITEM( ParsingOptions::allowComments   , "AllowComments" );
@@ -224,6 +277,9 @@ MARTY_CPP_ENUM_FLAGS_SERIALIZE_BEGIN( ParsingOptions, std::map, 1 )
 MARTY_CPP_ENUM_FLAGS_SERIALIZE_END( ParsingOptions, std::map, 1 )
 
 MARTY_CPP_ENUM_FLAGS_DESERIALIZE_BEGIN( ParsingOptions, std::map, 1 )
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( ParsingOptions::collectErrors   , "collect-errors"  );
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( ParsingOptions::collectErrors   , "collect_errors"  );
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( ParsingOptions::collectErrors   , "collecterrors"   );
     MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( ParsingOptions::allowMultiHex   , "allow-multi-hex" );
     MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( ParsingOptions::allowMultiHex   , "allow_multi_hex" );
     MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( ParsingOptions::allowMultiHex   , "allowmultihex"   );
@@ -270,6 +326,35 @@ MARTY_CPP_ENUM_FLAGS_DESERIALIZE_BEGIN( HexRecordsCheckCode, std::map, 1 )
     MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( HexRecordsCheckCode::none                       , "none"                        );
 MARTY_CPP_ENUM_FLAGS_DESERIALIZE_END( HexRecordsCheckCode, std::map, 1 )
 
+//#!HexWriterOptions
+enum class HexWriterOptions : std::uint32_t
+{
+    none                 = 0x00 /*!<  */,
+    crlf                 = 0x01 /*!< Use CR LF line endings (LF by default) */,
+    lowercase            = 0x02 /*!< Use lowercase hex digits */,
+    segmentAddressMode   = 0x04 /*!< Emit ESA records instead of ELA when address crosses 64K boundary (addresses up to 1M) */
+
+}; // enum 
+//#!
+
+MARTY_CPP_MAKE_ENUM_FLAGS(HexWriterOptions)
+
+MARTY_CPP_ENUM_FLAGS_SERIALIZE_BEGIN( HexWriterOptions, std::map, 1 )
+    MARTY_CPP_ENUM_FLAGS_SERIALIZE_ITEM( HexWriterOptions::segmentAddressMode   , "SegmentAddressMode" );
+    MARTY_CPP_ENUM_FLAGS_SERIALIZE_ITEM( HexWriterOptions::lowercase            , "Lowercase"          );
+    MARTY_CPP_ENUM_FLAGS_SERIALIZE_ITEM( HexWriterOptions::crlf                 , "Crlf"               );
+    MARTY_CPP_ENUM_FLAGS_SERIALIZE_ITEM( HexWriterOptions::none                 , "None"               );
+MARTY_CPP_ENUM_FLAGS_SERIALIZE_END( HexWriterOptions, std::map, 1 )
+
+MARTY_CPP_ENUM_FLAGS_DESERIALIZE_BEGIN( HexWriterOptions, std::map, 1 )
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( HexWriterOptions::segmentAddressMode   , "segment-address-mode" );
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( HexWriterOptions::segmentAddressMode   , "segment_address_mode" );
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( HexWriterOptions::segmentAddressMode   , "segmentaddressmode"   );
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( HexWriterOptions::lowercase            , "lowercase"            );
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( HexWriterOptions::crlf                 , "crlf"                 );
+    MARTY_CPP_ENUM_FLAGS_DESERIALIZE_ITEM( HexWriterOptions::none                 , "none"                 );
+MARTY_CPP_ENUM_FLAGS_DESERIALIZE_END( HexWriterOptions, std::map, 1 )
+
 } // namespace hex
 } // namespace marty
 
@@ -0,0 +1,344 @@
+/*! \file
+    \brief Address to record lookup index (Eytzinger layout)
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "utils.h"
+
+//----------------------------------------------------------------------------
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_address_lookup.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//! Попадание адреса в запись: индекс записи и индекс байта данных в ней
+struct HexAddressLookupHit
+{
+    std::size_t     recordIndex = std::size_t(-1);
+    std::size_t     byteIndex   = 0;
+
+    bool isValid() const { return recordIndex!=std::size_t(-1); }
+
+}; // struct HexAddressLookupHit
+
+//! Пересечение диапазона адресов с записью: с какого адреса, сколько байт и откуда в данных записи
+struct HexAddressLookupRangeHit
+{
+    std::size_t     recordIndex = std::size_t(-1);
+    std::size_t     byteIndex   = 0;
+    std::uint32_t   address     = 0;
+    std::size_t     size        = 0;
+
+}; // struct HexAddressLookupRangeHit
+
+//----------------------------------------------------------------------------
+//! Неизменяемый индекс "адрес -> запись", строится один раз по набору записей.
+/*!
+    Каждая запись данных даёт один непрерывный кусок адресов, или два, если адрес заворачивается
+    (SBA - внутри 64K сегмента, иначе - 32-битный адрес). Куски сортируются по первому адресу,
+    первые адреса раскладываются в порядке обхода в ширину (Eytzinger) - спуск по такому массиву
+    идёт без ветвлений и хорошо ложится в кэш: первые уровни дерева лежат рядом.
+
+    Перекрывающиеся записи тоже находятся: к отсортированным кускам считается префиксный максимум
+    последнего адреса, и от найденной верхней границы назад перебираются куски, пока этот
+    максимум не меньше искомого адреса. Без перекрытий это один-два куска.
+
+    Попадания отдаются в порядке записей, последнее - "победившее" (как при последовательной
+    загрузке в MemoryImage и при слиянии lastWins).
+
+    HexRecordsType - std::vector<HexEntry> или HexRecordTable (или что-то ещё с перегрузками getHexRecord*)
+ */
+class HexAddressLookup
+{
+
+protected:
+
+    struct Piece
+    {
+        std::uint32_t   first       = 0;
+        std::uint32_t   last        = 0; // Включительно
+        std::uint32_t   recordIndex = 0;
+        std::uint32_t   dataOffset  = 0;
+    };
+
+    std::vector<Piece>          pieces      ; // По возрастанию first, при равных - в порядке записей
+    std::vector<std::uint32_t>  maxLast     ; // Префиксный максимум last по pieces
+    std::vector<std::uint32_t>  eytKeys     ; // first в порядке Eytzinger, с индекса 1
+    std::vector<std::uint32_t>  eytToPiece  ; // Индекс в pieces для узла Eytzinger
+
+    static const std::size_t    batchLanes = 8;
+
+
+    //! Заполнение узлов Eytzinger обходом дерева в порядке in-order
+    void fillEytzinger(std::size_t &pieceIdx, std::size_t k)
+    {
+        if (k>pieces.size())
+            return;
+
+        fillEytzinger(pieceIdx, 2u*k);
+        eytKeys   [k] = pieces[pieceIdx].first;
+        eytToPiece[k] = std::uint32_t(pieceIdx);
+        ++pieceIdx;
+        fillEytzinger(pieceIdx, 2u*k+1u);
+    }
+
+    //! Подтягиваем в кэш узлы на четыре уровня ниже: их 16 подряд, как раз кэш-линия
+    static
+    void prefetchNode(const std::uint32_t *pKeys, std::size_t k, std::size_t n)
+    {
+    #if defined(__GNUC__) || defined(__clang__)
+        if (16u*k<=n)
+            __builtin_prefetch(pKeys+16u*k);
+    #else
+        (void)pKeys; (void)k; (void)n;
+    #endif
+    }
+
+    //! Узел Eytzinger после спуска -> индекс первого куска с first>address (или pieces.size())
+    std::size_t eytNodeToUpperBound(std::size_t k) const
+    {
+        k >>= utils::countTrailingZeros64(~std::uint64_t(k))+1u;
+        return k ? std::size_t(eytToPiece[k]) : pieces.size();
+    }
+
+    //! Индекс первого куска с first>address
+    std::size_t upperBound(std::uint32_t address) const
+    {
+        const std::size_t n = pieces.size();
+        const std::uint32_t *pKeys = eytKeys.data();
+
+        std::size_t k = 1;
+        while(k<=n)
+        {
+            prefetchNode(pKeys, k, n);
+            k = 2u*k + std::size_t(pKeys[k]<=address);
+        }
+
+        return eytNodeToUpperBound(k);
+    }
+
+    //! Вызывает handler(pieceIdx) для кусков, пересекающихся с [first, last], в порядке убывания first
+    template<typename Handler>
+    void forEachPiece(std::uint32_t first, std::uint32_t last, Handler handler) const
+    {
+        for(std::size_t i=upperBound(last); i!=0 && maxLast[i-1u]>=first; --i)
+        {
+            if (pieces[i-1u].last>=first)
+                handler(i-1u);
+        }
+    }
+
+
+public:
+
+    template<typename HexRecordsType>
+    void build(const HexRecordsType &records)
+    {
+        pieces.clear();
+
+        const std::size_t numRecords = getHexRecordsCount(records);
+        for(std::size_t idx=0; idx!=numRecords; ++idx)
+        {
+            if (getHexRecordType(records, idx)!=HexRecordType::data)
+                continue;
+
+            forEachHexRecordDataSegment(records, idx, [&](std::uint32_t addr, std::size_t dataOffset, std::size_t size)
+            {
+                Piece piece;
+                piece.first       = addr;
+                piece.last        = addr+std::uint32_t(size-1u);
+                piece.recordIndex = std::uint32_t(idx);
+                piece.dataOffset  = std::uint32_t(dataOffset);
+                pieces.emplace_back(piece);
+            });
+        }
+
+        // Устойчивая - при равных адресах куски остаются в порядке записей
+        utils::radixSortByKey32(pieces, [](const Piece &piece) { return piece.first; });
+
+        maxLast.resize(pieces.size());
+        std::uint32_t curMaxLast = 0;
+        for(std::size_t i=0; i!=pieces.size(); ++i)
+        {
+            curMaxLast = std::max(curMaxLast, pieces[i].last);
+            maxLast[i] = curMaxLast;
+        }
+
+        eytKeys   .assign(pieces.size()+1u, 0);
+        eytToPiece.assign(pieces.size()+1u, 0);
+        std::size_t pieceIdx = 0;
+        fillEytzinger(pieceIdx, 1);
+    }
+
+    bool        empty() const { return pieces.empty(); }
+    std::size_t getPiecesCount() const { return pieces.size(); }
+
+    //! Все записи, содержащие адрес, в порядке записей. Возвращает число попаданий
+    std::size_t find(std::uint32_t address, std::vector<HexAddressLookupHit> &hits) const
+    {
+        const std::size_t prevSize = hits.size();
+        forEachPiece(address, address, [&](std::size_t pieceIdx)
+        {
+            const Piece &piece = pieces[pieceIdx];
+            hits.emplace_back(HexAddressLookupHit{piece.recordIndex, std::size_t(piece.dataOffset)+std::size_t(address-piece.first)});
+        });
+
+        std::sort(hits.begin()+std::ptrdiff_t(prevSize), hits.end(), [](const HexAddressLookupHit &h1, const HexAddressLookupHit &h2)
+        {
+            return h1.recordIndex<h2.recordIndex;
+        });
+
+        return hits.size()-prevSize;
+    }
+
+    //! Последняя (по порядку записей) запись, содержащая адрес - её байт и лежит по адресу после загрузки
+    HexAddressLookupHit findLast(std::uint32_t address) const
+    {
+        HexAddressLookupHit hit;
+        forEachPiece(address, address, [&](std::size_t pieceIdx)
+        {
+            const Piece &piece = pieces[pieceIdx];
+            if (!hit.isValid() || std::size_t(piece.recordIndex)>hit.recordIndex)
+            {
+                hit.recordIndex = piece.recordIndex;
+                hit.byteIndex   = std::size_t(piece.dataOffset)+std::size_t(address-piece.first);
+            }
+        });
+
+        return hit;
+    }
+
+    //! Все пересечения диапазона [address, address+size) с записями, в порядке записей
+    std::size_t findRange(std::uint32_t address, std::size_t size, std::vector<HexAddressLookupRangeHit> &hits) const
+    {
+        if (!size)
+            return 0;
+
+        const std::uint64_t end  = std::min(std::uint64_t(address)+std::uint64_t(size), std::uint64_t(0x100000000ull));
+        const std::uint32_t last = std::uint32_t(end-1u);
+
+        const std::size_t prevSize = hits.size();
+        forEachPiece(address, last, [&](std::size_t pieceIdx)
+        {
+            const Piece &piece = pieces[pieceIdx];
+            const std::uint32_t hitFirst = std::max(piece.first, address);
+            const std::uint32_t hitLast  = std::min(piece.last , last);
+
+            HexAddressLookupRangeHit hit;
+            hit.recordIndex = piece.recordIndex;
+            hit.byteIndex   = std::size_t(piece.dataOffset)+std::size_t(hitFirst-piece.first);
+            hit.address     = hitFirst;
+            hit.size        = std::size_t(hitLast-hitFirst)+1u;
+            hits.emplace_back(hit);
+        });
+
+        std::sort(hits.begin()+std::ptrdiff_t(prevSize), hits.end(), [](const HexAddressLookupRangeHit &h1, const HexAddressLookupRangeHit &h2)
+        {
+            return h1.recordIndex!=h2.recordIndex ? h1.recordIndex<h2.recordIndex : h1.address<h2.address;
+        });
+
+        return hits.size()-prevSize;
+    }
+
+    //! Пакетный поиск: для каждого адреса - последняя содержащая его запись (или невалидное попадание).
+    //! Спуск по дереву идёт сразу для batchLanes адресов вперемешку - промахи кэша разных адресов
+    //! перекрываются, а не ждут друг друга
+    void findLastBatch(const std::uint32_t *pAddresses, std::size_t numAddresses, HexAddressLookupHit *pHits) const
+    {
+        const std::size_t n = pieces.size();
+        const std::uint32_t *pKeys = eytKeys.data();
+
+        // Уровни, которые есть у дерева целиком - по ним спускаемся без проверок
+        std::size_t fullLevels = 0;
+        while((std::size_t(2)<<fullLevels)-1u<=n)
+            ++fullLevels;
+
+        std::size_t k[batchLanes];
+
+        for(std::size_t base=0; base<numAddresses; base+=batchLanes)
+        {
+            const std::size_t numLanes = std::min(batchLanes, numAddresses-base);
+            const std::uint32_t *pAddr = pAddresses+base;
+
+            for(std::size_t lane=0; lane!=numLanes; ++lane)
+                k[lane] = 1;
+
+            for(std::size_t level=0; level!=fullLevels; ++level)
+            {
+                for(std::size_t lane=0; lane!=numLanes; ++lane)
+                {
+                    prefetchNode(pKeys, k[lane], n);
+                    k[lane] = 2u*k[lane] + std::size_t(pKeys[k[lane]]<=pAddr[lane]);
+                }
+            }
+
+            for(std::size_t lane=0; lane!=numLanes; ++lane)
+            {
+                if (k[lane]<=n) // Неполный последний уровень
+                    k[lane] = 2u*k[lane] + std::size_t(pKeys[k[lane]]<=pAddr[lane]);
+
+                const std::uint32_t address = pAddr[lane];
+                HexAddressLookupHit hit;
+                for(std::size_t i=eytNodeToUpperBound(k[lane]); i!=0 && maxLast[i-1u]>=address; --i)
+                {
+                    const Piece &piece = pieces[i-1u];
+                    if (piece.last>=address && (!hit.isValid() || std::size_t(piece.recordIndex)>hit.recordIndex))
+                    {
+                        hit.recordIndex = piece.recordIndex;
+                        hit.byteIndex   = std::size_t(piece.dataOffset)+std::size_t(address-piece.first);
+                    }
+                }
+
+                pHits[base+lane] = hit;
+            }
+        }
+    }
+
+    std::vector<HexAddressLookupHit> findLastBatch(const std::vector<std::uint32_t> &addresses) const
+    {
+        std::vector<HexAddressLookupHit> res(addresses.size());
+        findLastBatch(addresses.data(), addresses.size(), res.data());
+        return res;
+    }
+
+}; // class HexAddressLookup
+
+//----------------------------------------------------------------------------
+//! Строит индекс по записям - для вызова в одну строку
+template<typename HexRecordsType>
+HexAddressLookup makeHexAddressLookup(const HexRecordsType &records)
+{
+    HexAddressLookup lookup;
+    lookup.build(records);
+    return lookup;
+}
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_address_lookup.h
+
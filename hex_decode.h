@@ -0,0 +1,469 @@
+/*! \file
+    \brief Fast hex digits decoding (SSE2/AVX2 with scalar fallback)
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "utils.h"
+//
+#include <cstddef>
+#include <cstdint>
+
+//----------------------------------------------------------------------------
+// Векторизацию можно запретить, определив MARTY_HEX_NO_SIMD
+#if !defined(MARTY_HEX_NO_SIMD)
+
+    #if defined(__AVX2__)
+        #define MARTY_HEX_USE_AVX2
+    #endif
+
+    #if defined(__SSSE3__) || defined(__AVX__)
+        #define MARTY_HEX_USE_SSSE3
+    #endif
+
+    #if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+        #define MARTY_HEX_USE_SSE2
+    #endif
+
+#endif
+
+#if defined(MARTY_HEX_USE_SSE2)
+    #include <emmintrin.h>
+#endif
+
+#if defined(MARTY_HEX_USE_SSSE3)
+    #include <tmmintrin.h>
+#endif
+
+#if defined(MARTY_HEX_USE_AVX2)
+    #include <immintrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_decode.h
+// marty::hex::utils::
+namespace marty{
+namespace hex{
+namespace utils {
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    В отличие от charToDigit, тут за шестнадцатиричную цифру считаются только [0-9A-Fa-f].
+    Всё остальное (в том числе буквы за пределами 'F', которые charToDigit пропускает)
+    обрабатывается штатным посимвольным разбором, поэтому результаты разбора не меняются.
+ */
+
+//! Таблица значений шестнадцатиричных цифр, 0xFF - не цифра
+struct HexDigitTable
+{
+    std::uint8_t values[256];
+
+    constexpr HexDigitTable() : values{}
+    {
+        for(unsigned i=0; i!=256u; ++i)
+        {
+            if (i>='0' && i<='9')
+                values[i] = std::uint8_t(i-'0');
+            else if (i>='A' && i<='F')
+                values[i] = std::uint8_t(i-'A'+10);
+            else if (i>='a' && i<='f')
+                values[i] = std::uint8_t(i-'a'+10);
+            else
+                values[i] = 0xFFu;
+        }
+    }
+
+}; // struct HexDigitTable
+
+//------------------------------
+inline
+const HexDigitTable& getHexDigitTable()
+{
+    static constexpr const HexDigitTable t = HexDigitTable();
+    return t;
+}
+
+//----------------------------------------------------------------------------
+#if defined(MARTY_HEX_USE_SSE2)
+
+//! Маска 0xFF в позициях, где стоят шестнадцатиричные цифры
+inline
+__m128i hexDigitsMask16(__m128i v)
+{
+    // Сравнение знаковое, символы >=0x80 получаются отрицательными и в диапазоны не попадают
+    const __m128i isDigit = _mm_and_si128( _mm_cmpgt_epi8(v, _mm_set1_epi8('0'-1))
+                                         , _mm_cmplt_epi8(v, _mm_set1_epi8('9'+1))
+                                         );
+    const __m128i lower   = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    const __m128i isAlpha = _mm_and_si128( _mm_cmpgt_epi8(lower, _mm_set1_epi8('a'-1))
+                                         , _mm_cmplt_epi8(lower, _mm_set1_epi8('f'+1))
+                                         );
+    return _mm_or_si128(isDigit, isAlpha);
+}
+
+//! Значения тетрад для заведомо корректных цифр: (ch&0x0F) + (ch&0x40 ? 9 : 0)
+inline
+__m128i hexDigitsValues16(__m128i v)
+{
+    const __m128i low   = _mm_and_si128(v, _mm_set1_epi8(0x0F));
+    const __m128i alpha = _mm_and_si128( _mm_cmpeq_epi8(_mm_and_si128(v, _mm_set1_epi8(0x40)), _mm_set1_epi8(0x40))
+                                       , _mm_set1_epi8(9)
+                                       );
+    return _mm_add_epi8(low, alpha);
+}
+
+//! Склеивает пары тетрад в байты - в каждом 16ти-битном слове получаем байт в младшей половине
+inline
+__m128i hexNibblePairsToWords16(__m128i nibbles)
+{
+    const __m128i hi = _mm_slli_epi16(nibbles, 4);
+    const __m128i lo = _mm_srli_epi16(nibbles, 8);
+    return _mm_and_si128(_mm_or_si128(hi, lo), _mm_set1_epi16(0x00FF));
+}
+
+#endif
+
+//----------------------------------------------------------------------------
+#if defined(MARTY_HEX_USE_AVX2)
+
+inline
+__m256i hexDigitsMask32(__m256i v)
+{
+    const __m256i isDigit = _mm256_and_si256( _mm256_cmpgt_epi8(v, _mm256_set1_epi8('0'-1))
+                                            , _mm256_cmpgt_epi8(_mm256_set1_epi8('9'+1), v)
+                                            );
+    const __m256i lower   = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    const __m256i isAlpha = _mm256_and_si256( _mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a'-1))
+                                            , _mm256_cmpgt_epi8(_mm256_set1_epi8('f'+1), lower)
+                                            );
+    return _mm256_or_si256(isDigit, isAlpha);
+}
+
+inline
+__m256i hexDigitsValues32(__m256i v)
+{
+    const __m256i low   = _mm256_and_si256(v, _mm256_set1_epi8(0x0F));
+    const __m256i alpha = _mm256_and_si256( _mm256_cmpeq_epi8(_mm256_and_si256(v, _mm256_set1_epi8(0x40)), _mm256_set1_epi8(0x40))
+                                          , _mm256_set1_epi8(9)
+                                          );
+    return _mm256_add_epi8(low, alpha);
+}
+
+#endif
+
+//----------------------------------------------------------------------------
+//! Возвращает длину последовательности шестнадцатиричных цифр, начинающейся с pText
+inline
+std::size_t countHexDigits(const char *pText, std::size_t size)
+{
+    std::size_t idx = 0;
+
+#if defined(MARTY_HEX_USE_AVX2)
+    for(; idx+32u<=size; idx+=32u)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pText+idx));
+        const std::uint32_t mask = std::uint32_t(_mm256_movemask_epi8(hexDigitsMask32(v)));
+        if (mask!=0xFFFFFFFFu)
+            return idx + countTrailingZeros32(~mask);
+    }
+#endif
+
+#if defined(MARTY_HEX_USE_SSE2)
+    for(; idx+16u<=size; idx+=16u)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pText+idx));
+        const std::uint32_t mask = std::uint32_t(_mm_movemask_epi8(hexDigitsMask16(v)));
+        if (mask!=0xFFFFu)
+            return idx + countTrailingZeros32(~mask);
+    }
+#endif
+
+    const HexDigitTable &t = getHexDigitTable();
+    for(; idx!=size; ++idx)
+    {
+        if (t.values[(std::uint8_t)pText[idx]]==0xFFu)
+            break;
+    }
+
+    return idx;
+}
+
+//----------------------------------------------------------------------------
+//! Сумма байт (по модулю 2^32 - для КС Intel HEX нужен только младший байт). Векторная версия - psadbw:
+//! сумма модулей разностей с нулём складывает по 8 байт в 64х-битное слово, без переполнений
+inline
+std::uint32_t sumBytes(const std::uint8_t *pData, std::size_t size)
+{
+    std::size_t   idx = 0;
+    std::uint32_t sum = 0;
+
+#if defined(MARTY_HEX_USE_AVX2)
+    if (size>=32u)
+    {
+        __m256i acc = _mm256_setzero_si256();
+        for(; idx+32u<=size; idx+=32u)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pData+idx));
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, _mm256_setzero_si256()));
+        }
+
+        const __m128i acc128 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum += std::uint32_t(_mm_cvtsi128_si32(acc128)) + std::uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(acc128, 8)));
+    }
+#endif
+
+#if defined(MARTY_HEX_USE_SSE2)
+    if (idx+16u<=size)
+    {
+        __m128i acc = _mm_setzero_si128();
+        for(; idx+16u<=size; idx+=16u)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pData+idx));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(v, _mm_setzero_si128()));
+        }
+
+        sum += std::uint32_t(_mm_cvtsi128_si32(acc)) + std::uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+    }
+#endif
+
+    for(; idx!=size; ++idx)
+        sum += pData[idx];
+
+    return sum;
+}
+
+//------------------------------
+//! Контрольная сумма Intel HEX для байт записи (заголовок и данные) - дополнение суммы до нуля
+inline
+std::uint8_t calcIntelHexChecksum(const std::uint8_t *pData, std::size_t size)
+{
+    return std::uint8_t(0u-sumBytes(pData, size));
+}
+
+//----------------------------------------------------------------------------
+//! Декодирует numBytes пар шестнадцатиричных цифр и возвращает сумму декодированных байт (как sumBytes).
+//! Сумма считается в том же проходе: слова с байтами в младших половинах сразу уходят в psadbw.
+//! Цифры должны быть заранее проверены (countHexDigits)
+inline
+std::uint32_t decodeHexPairsSum(const char *pText, std::size_t numBytes, std::uint8_t *pOut)
+{
+    std::size_t   idx = 0;
+    std::uint32_t sum = 0;
+
+#if defined(MARTY_HEX_USE_AVX2)
+    if (numBytes>=16u)
+    {
+        __m256i acc = _mm256_setzero_si256();
+        for(; idx+16u<=numBytes; idx+=16u)
+        {
+            const __m256i v     = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pText+2u*idx));
+            const __m256i nibs  = hexDigitsValues32(v);
+            const __m256i words = _mm256_and_si256( _mm256_or_si256(_mm256_slli_epi16(nibs, 4), _mm256_srli_epi16(nibs, 8))
+                                                  , _mm256_set1_epi16(0x00FF)
+                                                  );
+            acc = _mm256_add_epi64(acc, _mm256_sad_epu8(words, _mm256_setzero_si256()));
+            // packus работает внутри 128ми-битных половин - собираем нужные четвёрки слов в младшую половину
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOut+idx), _mm256_castsi256_si128(packed));
+        }
+
+        const __m128i acc128 = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum += std::uint32_t(_mm_cvtsi128_si32(acc128)) + std::uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(acc128, 8)));
+    }
+#endif
+
+#if defined(MARTY_HEX_USE_SSE2)
+    if (idx+8u<=numBytes)
+    {
+        __m128i acc = _mm_setzero_si128();
+        for(; idx+8u<=numBytes; idx+=8u)
+        {
+            const __m128i v     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pText+2u*idx));
+            const __m128i words = hexNibblePairsToWords16(hexDigitsValues16(v));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(words, _mm_setzero_si128()));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pOut+idx), _mm_packus_epi16(words, words));
+        }
+
+        sum += std::uint32_t(_mm_cvtsi128_si32(acc)) + std::uint32_t(_mm_cvtsi128_si32(_mm_srli_si128(acc, 8)));
+    }
+#endif
+
+    const HexDigitTable &t = getHexDigitTable();
+    for(; idx!=numBytes; ++idx)
+    {
+        const std::uint8_t b = std::uint8_t( (t.values[(std::uint8_t)pText[2u*idx]]<<4)
+                                           |  t.values[(std::uint8_t)pText[2u*idx+1u]]
+                                           );
+        pOut[idx] = b;
+        sum += b;
+    }
+
+    return sum;
+}
+
+//------------------------------
+//! Декодирует numBytes пар шестнадцатиричных цифр. Цифры должны быть заранее проверены (countHexDigits)
+inline
+void decodeHexPairs(const char *pText, std::size_t numBytes, std::uint8_t *pOut)
+{
+    std::size_t idx = 0;
+
+#if defined(MARTY_HEX_USE_AVX2)
+    for(; idx+16u<=numBytes; idx+=16u)
+    {
+        const __m256i v     = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pText+2u*idx));
+        const __m256i nibs  = hexDigitsValues32(v);
+        const __m256i words = _mm256_and_si256( _mm256_or_si256(_mm256_slli_epi16(nibs, 4), _mm256_srli_epi16(nibs, 8))
+                                              , _mm256_set1_epi16(0x00FF)
+                                              );
+        // packus работает внутри 128ми-битных половин - собираем нужные четвёрки слов в младшую половину
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pOut+idx), _mm256_castsi256_si128(packed));
+    }
+#endif
+
+#if defined(MARTY_HEX_USE_SSE2)
+    for(; idx+8u<=numBytes; idx+=8u)
+    {
+        const __m128i v     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pText+2u*idx));
+        const __m128i words = hexNibblePairsToWords16(hexDigitsValues16(v));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(pOut+idx), _mm_packus_epi16(words, words));
+    }
+#endif
+
+    const HexDigitTable &t = getHexDigitTable();
+    for(; idx!=numBytes; ++idx)
+    {
+        pOut[idx] = std::uint8_t( (t.values[(std::uint8_t)pText[2u*idx]]<<4)
+                                |  t.values[(std::uint8_t)pText[2u*idx+1u]]
+                                );
+    }
+}
+
+//----------------------------------------------------------------------------
+#if defined(MARTY_HEX_USE_SSE2)
+
+//! Маски позиций для 48ми символов (16ти троек "HH "): бит на символ, три 16ти-битных слова подряд
+constexpr const std::uint64_t spacedHexPairsDigitsMask = 0x6DB6DB6DB6DBull; // 011 011 ... (младший бит - первый символ)
+constexpr const std::uint64_t spacedHexPairsSpacesMask = 0x124924924924ull; // 100 100 ... без последнего, 47го символа
+
+//! Проверяет, что 47 символов - это 15 троек "HH " и пара "HH". Значения тетрад кладёт в nibbles.
+//! В lastChar - что за последней парой: 1 - пробел, 0 - не цифра, -1 - цифра
+inline
+bool checkSpacedHexPairs48(const char *pText, __m128i nibbles[3], int &lastChar)
+{
+    std::uint64_t digitsMask = 0;
+    std::uint64_t spacesMask = 0;
+
+    for(unsigned i=0; i!=3u; ++i)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pText+16u*i));
+        digitsMask |= std::uint64_t(std::uint32_t(_mm_movemask_epi8(hexDigitsMask16(v))))<<(16u*i);
+        spacesMask |= std::uint64_t(std::uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')))))<<(16u*i);
+        nibbles[i]  = hexDigitsValues16(v);
+    }
+
+    lastChar = (spacesMask>>47)!=0 ? 1 : (digitsMask>>47)!=0 ? -1 : 0;
+
+    return (digitsMask&spacedHexPairsDigitsMask)==spacedHexPairsDigitsMask
+        && (spacesMask&spacedHexPairsSpacesMask)==spacedHexPairsSpacesMask;
+}
+
+#endif
+
+//----------------------------------------------------------------------------
+/*! Декодирует байты, записанные парами цифр через один пробел - так выглядят колонки байт в дампах.
+    Съедает тройки "HH ", и последнюю пару без пробела, если за ней не цифра (перевод строки, двоеточие и т.п.,
+    сам этот символ не съедается). Останавливается на первой паре другого вида, и на паре, про которую
+    не ясно, кончилась ли она (текст кончился сразу за ней). Не больше maxBytes байт.
+    Возвращает количество декодированных байт, в numChars - количество съеденных символов.
+
+    Пары проверяются по 16 штук за раз (SSE2), тетрады из трёх 16ти-байтных векторов собираются
+    через pshufb (SSSE3), без SSSE3 - склеиваются из уже посчитанных значений тетрад.
+ */
+inline
+std::size_t decodeSpacedHexPairs(const char *pText, std::size_t size, std::uint8_t *pOut, std::size_t maxBytes, std::size_t &numChars)
+{
+    std::size_t numBytes = 0;
+    numChars = 0;
+
+#if defined(MARTY_HEX_USE_SSE2)
+    for(; numBytes+16u<=maxBytes && numChars+48u<=size; numBytes+=16u)
+    {
+        __m128i nibbles[3];
+        int lastChar = 0;
+        if (!checkSpacedHexPairs48(pText+numChars, nibbles, lastChar) || lastChar<0)
+            break;
+
+    #if defined(MARTY_HEX_USE_SSSE3)
+        // Старшие тетрады - символы 0, 3, 6 ... 45, младшие - 1, 4, 7 ... 46. -1 (0x80) в маске даёт ноль
+        const __m128i hi = _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8(nibbles[0], _mm_setr_epi8( 0, 3, 6, 9,12,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1))
+                                                     , _mm_shuffle_epi8(nibbles[1], _mm_setr_epi8(-1,-1,-1,-1,-1,-1, 2, 5, 8,11,14,-1,-1,-1,-1,-1))
+                                                     )
+                                       , _mm_shuffle_epi8(nibbles[2], _mm_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 1, 4, 7,10,13))
+                                       );
+        const __m128i lo = _mm_or_si128( _mm_or_si128( _mm_shuffle_epi8(nibbles[0], _mm_setr_epi8( 1, 4, 7,10,13,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1))
+                                                     , _mm_shuffle_epi8(nibbles[1], _mm_setr_epi8(-1,-1,-1,-1,-1, 0, 3, 6, 9,12,15,-1,-1,-1,-1,-1))
+                                                     )
+                                       , _mm_shuffle_epi8(nibbles[2], _mm_setr_epi8(-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, 2, 5, 8,11,14))
+                                       );
+        // Тетрады не больше 15, так что сдвиг 16ти-битных слов не переносит биты между байтами
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pOut+numBytes), _mm_or_si128(_mm_slli_epi16(hi, 4), lo));
+    #else
+        std::uint8_t values[48];
+        for(unsigned i=0; i!=3u; ++i)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&values[16u*i]), nibbles[i]);
+        for(std::size_t i=0; i!=16u; ++i)
+            pOut[numBytes+i] = std::uint8_t((values[3u*i]<<4) | values[3u*i+1u]);
+    #endif
+
+        if (lastChar==0) // Последняя пара в строке
+            return numChars += 47u, numBytes+16u;
+
+        numChars += 48u;
+    }
+#endif
+
+    const HexDigitTable &t = getHexDigitTable();
+    for(; numBytes!=maxBytes && numChars+3u<=size; ++numBytes)
+    {
+        const char *p = pText+numChars;
+        const std::uint8_t hi = t.values[(std::uint8_t)p[0]];
+        const std::uint8_t lo = t.values[(std::uint8_t)p[1]];
+        if (hi==0xFFu || lo==0xFFu)
+            break;
+
+        if (p[2]!=' ')
+        {
+            if (t.values[(std::uint8_t)p[2]]!=0xFFu)
+                break;
+
+            pOut[numBytes] = std::uint8_t((hi<<4) | lo);
+            numChars += 2u;
+            return numBytes+1u;
+        }
+
+        pOut[numBytes] = std::uint8_t((hi<<4) | lo);
+        numChars += 3u;
+    }
+
+    return numBytes;
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace utils
+} // namespace hex
+} // namespace marty
+// marty::hex::utils::
+// marty_hex/hex_decode.h
+
@@ -0,0 +1,712 @@
+/*! \file
+    \brief HexDocument - HEX-текст с построчным индексом и инкрементальным переразбором после правок
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+// HexDocument использует updateHexEntriesAddressAndMode из marty_hex.h, поэтому сам в marty_hex.h
+// не включается - подключаем его отдельно, когда нужна модель редактируемого документа
+#include "marty_hex.h"
+
+//
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+// marty_hex/hex_document.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//! Правка текста - замена диапазона [offset, offset+size) текстом text. Смещения - в тексте до правки
+struct HexDocumentEdit
+{
+    std::size_t   offset = 0;
+    std::size_t   size   = 0;
+    std::string   text;
+
+}; // struct HexDocumentEdit
+
+//! Сколько работы было сделано при последнем обновлении документа
+struct HexDocumentUpdateStats
+{
+    std::size_t   reparsedLines       = 0; //!< Строк разобрано заново
+    std::size_t   addressUpdatedLines = 0; //!< Строк, у которых пересчитывались базовый адрес и режим адресации
+    bool          hexInfoUpdated      = false;
+
+}; // struct HexDocumentUpdateStats
+
+//----------------------------------------------------------------------------
+//! Документ - HEX-текст, индекс начал строк и разобранная запись на каждую строку.
+/*!
+    Строк в документе всегда на одну больше, чем символов '\n' - последняя строка может быть пустой.
+    Пустые строки, комментарии и строки с ошибками хранят запись с типом HexRecordType::invalid,
+    код ошибки строки - в getLineResult.
+
+    При правке заново разбираются только строки, которые правка задела. Базовые адреса и режим
+    адресации последующих записей пересчитываются, пока состояние на входе в строку отличается
+    от прежнего - обычно это до ближайшей ELA/ESA записи или до первой строки данных после правки.
+    HexInfo пересобирается по списку строк с адресными записями (ELA/ESA/SLA/SSA), и только
+    если правка такие записи задела.
+
+    Строки хранятся блоками примерно по blockLines строк. Смещения строк в блоке отсчитываются от
+    начала блока, номер строки в filePosInfo записи проставляется при чтении по её индексу, поэтому
+    правка, меняющая длину текста или число строк, перестраивает только задетые блоки и сдвигает
+    заголовки последующих блоков - O(blockLines + число блоков), а не O(число строк). Сам текст
+    хранится одной строкой, вставка и удаление сдвигают его хвост (memmove) - это тоже O(размер файла),
+    но с очень маленькой константой. Номера адресных строк (ELA/ESA/SLA/SSA) после правки сдвигаются
+    линейно по их списку - таких строк обычно одна на 64K данных.
+
+    Разбираются все строки, в том числе после EOF записи - документ показывает текст целиком.
+ */
+class HexDocument
+{
+
+protected:
+
+    //! Подряд идущие строки документа
+    struct LineBlock
+    {
+        std::size_t                          textOffset  = 0; //!< Смещение первой строки блока в text
+        std::size_t                          firstLine   = 0; //!< Номер первой строки блока
+        std::vector<std::size_t>             lineOffsets; //!< Начала строк, от textOffset
+        mutable std::vector<HexEntry>        lineRecords; //!< Запись строки, адреса уже обновлены; filePosInfo.line проставляется при чтении
+        std::vector<ParsingResult>           lineResults; //!< Результат разбора строки
+        std::vector<HexEntriesAddressState>  lineStates ; //!< Состояние адресации на входе в строку
+
+        std::size_t size() const { return lineRecords.size(); }
+
+    }; // struct LineBlock
+
+    //! Строки, собранные из нескольких блоков и новых строк, перед нарезкой на блоки. Смещения - абсолютные
+    struct LinesRange
+    {
+        std::vector<std::size_t>             lineOffsets;
+        std::vector<HexEntry>                lineRecords;
+        std::vector<ParsingResult>           lineResults;
+        std::vector<HexEntriesAddressState>  lineStates ;
+
+        std::size_t size() const { return lineRecords.size(); }
+
+    }; // struct LinesRange
+
+    static const std::size_t blockLines    = 512u;          //!< Строк в блоке при нарезке
+    static const std::size_t minBlockLines = blockLines/4u; //!< Блок меньше этого при правке сливается со следующим
+
+
+    std::string                          text;
+    std::vector<LineBlock>               blocks      ; //!< Всегда хотя бы один, непустой
+    std::size_t                          linesCount  = 0;
+    std::vector<std::size_t>             addressLines; //!< Строки с ELA/ESA/SLA/SSA записями, по возрастанию
+
+    std::size_t                          errorsCount    = 0;
+    HexInfo                              hexInfo;
+    ParsingResult                        hexInfoResult  = ParsingResult::ok;
+    std::size_t                          hexInfoErrorLine = std::size_t(-1);
+
+    ParsingOptions                       parsingOptions = ParsingOptions::none;
+    std::size_t                          fileId         = std::size_t(-1);
+
+    IntelHexParser                       parser;
+    std::string                          lineBuf; // Строка с добавленным в конце '\n'
+    HexDocumentUpdateStats               lastUpdateStats;
+
+
+    static
+    bool isAddressRecordType(HexRecordType rt)
+    {
+        return rt==HexRecordType::extendedSegmentAddress
+            || rt==HexRecordType::startSegmentAddress
+            || rt==HexRecordType::extendedLinearAddress
+            || rt==HexRecordType::startLinearAddress
+             ;
+    }
+
+    static
+    bool isErrorResult(ParsingResult r)
+    {
+        return r!=ParsingResult::ok && r!=ParsingResult::unexpectedEnd;
+    }
+
+    static
+    bool isSameAddressState(const HexEntriesAddressState &s1, const HexEntriesAddressState &s2)
+    {
+        return s1.baseAddress==s2.baseAddress && s1.nextAddress==s2.nextAddress && s1.addressMode==s2.addressMode;
+    }
+
+    //! Блок, в котором лежит строка
+    std::size_t findBlock(std::size_t lineIdx) const
+    {
+        auto it = std::upper_bound( blocks.begin(), blocks.end(), lineIdx
+                                  , [](std::size_t l, const LineBlock &b) { return l<b.firstLine; }
+                                  );
+        return std::size_t(it-blocks.begin())-1u;
+    }
+
+    //! Запись строки без проставления номера строки - для внутреннего использования
+    const HexEntry& lineRecordRaw(std::size_t lineIdx) const
+    {
+        const LineBlock &b = blocks[findBlock(lineIdx)];
+        return b.lineRecords[lineIdx-b.firstLine];
+    }
+
+    //! Разбирает одну строку [b, e) (без '\n'). Парсер отдаёт запись по концу строки, поэтому '\n' добавляем
+    ParsingResult parseLine(const char* b, const char* e, HexEntry &resEntry)
+    {
+        resEntry = HexEntry();
+
+        lineBuf.assign(b, e);
+        lineBuf.append(1, '\n');
+
+        parser.reset();
+        parser.trackHexInfo = false; // Режимы проверяем сами, по списку адресных строк
+        parser.setFileId(fileId);
+
+        bool hasRecord = false;
+        ParsingResult r = parser.parseTextChunk( [&](const HexRecordRef &rec)
+                                                 {
+                                                     resEntry  = rec.pEntry->makeFitCopy();
+                                                     hasRecord = true;
+                                                 }
+                                               , lineBuf.data(), lineBuf.size(), 0
+                                               , parsingOptions|ParsingOptions::allowMultiHex
+                                               );
+
+        if (isErrorResult(r))
+        {
+            resEntry = HexEntry();
+        }
+        else
+        {
+            r = ParsingResult::ok;
+            if (hasRecord)
+            {
+                resEntry.filePosInfo.line = 0; // Проставляется при чтении
+                resEntry.filePosInfo.pos  = 0;
+                resEntry.filePosInfo.file = fileId;
+            }
+        }
+
+        return r;
+    }
+
+    //! Разбирает строки текста [textBegin, textEnd), в конце каждой, кроме, возможно, последней - '\n'.
+    //! Состояния адресации новых строк - пустые, их заполняет updateAddresses
+    void parseLines(std::size_t textBegin, std::size_t textEnd, bool lastIsOpen, LinesRange &lines)
+    {
+        const char* pText = text.data();
+        std::size_t pos   = textBegin;
+
+        while(true)
+        {
+            const char* pLineEnd = (const char*)std::memchr(pText+pos, '\n', textEnd-pos);
+            if (!pLineEnd && !lastIsOpen)
+                break;
+
+            std::size_t lineEnd = pLineEnd ? std::size_t(pLineEnd-pText) : textEnd;
+
+            HexEntry he;
+            lines.lineOffsets.emplace_back(pos);
+            lines.lineResults.emplace_back(parseLine(pText+pos, pText+lineEnd, he));
+            lines.lineRecords.emplace_back(std::move(he));
+            lines.lineStates .emplace_back(HexEntriesAddressState());
+
+            if (!pLineEnd)
+                break;
+
+            pos = lineEnd+1;
+        }
+    }
+
+    //! Дописывает строки [lineBegin, lineEnd) блока в lines, сдвигая их смещения на textDelta
+    static
+    void appendBlockLines(LineBlock &b, std::size_t lineBegin, std::size_t lineEnd, std::size_t textDelta, LinesRange &lines)
+    {
+        const auto itB = std::ptrdiff_t(lineBegin);
+        const auto itE = std::ptrdiff_t(lineEnd);
+
+        for(std::size_t i=lineBegin; i!=lineEnd; ++i)
+            lines.lineOffsets.emplace_back(b.textOffset+b.lineOffsets[i]+textDelta);
+
+        lines.lineRecords.insert(lines.lineRecords.end(), std::make_move_iterator(b.lineRecords.begin()+itB), std::make_move_iterator(b.lineRecords.begin()+itE));
+        lines.lineResults.insert(lines.lineResults.end(), b.lineResults.begin()+itB, b.lineResults.begin()+itE);
+        lines.lineStates .insert(lines.lineStates .end(), b.lineStates .begin()+itB, b.lineStates .begin()+itE);
+    }
+
+    //! Нарезает строки на блоки примерно по blockLines строк
+    static
+    void splitLinesToBlocks(LinesRange &lines, std::size_t firstLine, std::vector<LineBlock> &resBlocks)
+    {
+        const std::size_t numLines  = lines.size();
+        const std::size_t numBlocks = numLines ? (numLines+blockLines-1u)/blockLines : 0u;
+
+        std::size_t lineBegin = 0;
+        for(std::size_t n=0; n!=numBlocks; ++n)
+        {
+            // Делим поровну, чтобы после вставки одной строки в полный блок не получить блок из одной строки
+            const std::size_t lineEnd = numLines*(n+1u)/numBlocks;
+            const auto        itB     = std::ptrdiff_t(lineBegin);
+            const auto        itE     = std::ptrdiff_t(lineEnd);
+
+            LineBlock b;
+            b.textOffset = lines.lineOffsets[lineBegin];
+            b.firstLine  = firstLine+lineBegin;
+
+            b.lineOffsets.reserve(lineEnd-lineBegin);
+            for(std::size_t i=lineBegin; i!=lineEnd; ++i)
+                b.lineOffsets.emplace_back(lines.lineOffsets[i]-b.textOffset);
+
+            b.lineRecords.assign(std::make_move_iterator(lines.lineRecords.begin()+itB), std::make_move_iterator(lines.lineRecords.begin()+itE));
+            b.lineResults.assign(lines.lineResults.begin()+itB, lines.lineResults.begin()+itE);
+            b.lineStates .assign(lines.lineStates .begin()+itB, lines.lineStates .begin()+itE);
+
+            resBlocks.emplace_back(std::move(b));
+            lineBegin = lineEnd;
+        }
+    }
+
+    //! Сдвигает смещения блоков с blockIdx на textDelta, номера их первых строк берутся от предыдущего блока
+    void shiftBlocks(std::size_t blockIdx, std::size_t textDelta)
+    {
+        for(std::size_t i=blockIdx; i!=blocks.size(); ++i)
+        {
+            blocks[i].firstLine   = blocks[i-1u].firstLine+blocks[i-1u].size();
+            blocks[i].textOffset += textDelta;
+        }
+    }
+
+    //! Замена строк внутри одного блока на месте - если блок после неё не опустеет, не станет слишком
+    //! маленьким и не разрастётся больше, чем вдвое. Иначе - false, и блок перестраивается целиком
+    static
+    bool replaceBlockLines(LineBlock &b, std::size_t firstLine, std::size_t oldNumLines, LinesRange &newLines, std::size_t textDelta)
+    {
+        const std::size_t newNumLines = newLines.size();
+        const std::size_t newSize     = b.size()-oldNumLines+newNumLines;
+        if (newSize==0 || newSize>2u*blockLines || (newSize<minBlockLines && newNumLines<oldNumLines))
+            return false;
+
+        // Начало первой задетой строки правка не сдвигает, так что смещение блока остаётся прежним
+        const std::size_t first     = firstLine-b.firstLine;
+        const std::size_t numCommon = std::min(oldNumLines, newNumLines);
+        const auto        firstIt   = std::ptrdiff_t(first);
+        const auto        commonIt  = std::ptrdiff_t(numCommon);
+
+        for(auto &o : newLines.lineOffsets)
+            o -= b.textOffset;
+
+        std::move(newLines.lineOffsets.begin(), newLines.lineOffsets.begin()+commonIt, b.lineOffsets.begin()+firstIt);
+        std::move(newLines.lineRecords.begin(), newLines.lineRecords.begin()+commonIt, b.lineRecords.begin()+firstIt);
+        std::move(newLines.lineResults.begin(), newLines.lineResults.begin()+commonIt, b.lineResults.begin()+firstIt);
+        std::move(newLines.lineStates .begin(), newLines.lineStates .begin()+commonIt, b.lineStates .begin()+firstIt);
+
+        const auto tailIt = firstIt+commonIt;
+        if (newNumLines>oldNumLines)
+        {
+            b.lineOffsets.insert(b.lineOffsets.begin()+tailIt, newLines.lineOffsets.begin()+commonIt, newLines.lineOffsets.end());
+            b.lineRecords.insert(b.lineRecords.begin()+tailIt, std::make_move_iterator(newLines.lineRecords.begin()+commonIt), std::make_move_iterator(newLines.lineRecords.end()));
+            b.lineResults.insert(b.lineResults.begin()+tailIt, newLines.lineResults.begin()+commonIt, newLines.lineResults.end());
+            b.lineStates .insert(b.lineStates .begin()+tailIt, newLines.lineStates .begin()+commonIt, newLines.lineStates .end());
+        }
+        else if (newNumLines<oldNumLines)
+        {
+            const auto oldEndIt = std::ptrdiff_t(first+oldNumLines);
+            b.lineOffsets.erase(b.lineOffsets.begin()+tailIt, b.lineOffsets.begin()+oldEndIt);
+            b.lineRecords.erase(b.lineRecords.begin()+tailIt, b.lineRecords.begin()+oldEndIt);
+            b.lineResults.erase(b.lineResults.begin()+tailIt, b.lineResults.begin()+oldEndIt);
+            b.lineStates .erase(b.lineStates .begin()+tailIt, b.lineStates .begin()+oldEndIt);
+        }
+
+        if (textDelta!=0)
+        {
+            for(std::size_t i=first+newNumLines; i!=b.size(); ++i)
+                b.lineOffsets[i] += textDelta;
+        }
+
+        return true;
+    }
+
+    //! Заменяет строки [firstLine, firstLine+oldNumLines) строками newLines (смещения - в тексте после правки).
+    //! Перестраиваются только задетые блоки (и, если они стали слишком маленькими, следующий), у последующих
+    //! блоков сдвигаются смещение и номер первой строки
+    void replaceLines(std::size_t firstLine, std::size_t oldNumLines, LinesRange &newLines, std::size_t textDelta)
+    {
+        const std::size_t blockFirst = findBlock(firstLine);
+        std::size_t       blockEnd   = findBlock(firstLine+oldNumLines-1u)+1u;
+
+        linesCount = linesCount-oldNumLines+newLines.size();
+
+        if (blockFirst+1u==blockEnd && replaceBlockLines(blocks[blockFirst], firstLine, oldNumLines, newLines, textDelta))
+        {
+            shiftBlocks(blockFirst+1u, textDelta);
+            return;
+        }
+
+        const std::size_t newFirstLine = blocks[blockFirst].firstLine;
+
+        LinesRange lines;
+        appendBlockLines(blocks[blockFirst], 0, firstLine-newFirstLine, 0, lines);
+
+        lines.lineOffsets.insert(lines.lineOffsets.end(), newLines.lineOffsets.begin(), newLines.lineOffsets.end());
+        lines.lineRecords.insert(lines.lineRecords.end(), std::make_move_iterator(newLines.lineRecords.begin()), std::make_move_iterator(newLines.lineRecords.end()));
+        lines.lineResults.insert(lines.lineResults.end(), newLines.lineResults.begin(), newLines.lineResults.end());
+        lines.lineStates .insert(lines.lineStates .end(), newLines.lineStates .begin(), newLines.lineStates .end());
+
+        LineBlock &lastBlock = blocks[blockEnd-1u];
+        appendBlockLines(lastBlock, firstLine+oldNumLines-lastBlock.firstLine, lastBlock.size(), textDelta, lines);
+
+        while(lines.size()<minBlockLines && blockEnd!=blocks.size())
+        {
+            appendBlockLines(blocks[blockEnd], 0, blocks[blockEnd].size(), textDelta, lines);
+            ++blockEnd;
+        }
+
+        std::vector<LineBlock> newBlocks;
+        splitLinesToBlocks(lines, newFirstLine, newBlocks);
+
+        const std::size_t numNewBlocks = newBlocks.size();
+        blocks.erase(blocks.begin()+std::ptrdiff_t(blockFirst), blocks.begin()+std::ptrdiff_t(blockEnd));
+        blocks.insert(blocks.begin()+std::ptrdiff_t(blockFirst), std::make_move_iterator(newBlocks.begin()), std::make_move_iterator(newBlocks.end()));
+
+        shiftBlocks(blockFirst+numNewBlocks, textDelta);
+    }
+
+    //! Пересобирает HexInfo по адресным строкам
+    void rebuildHexInfo()
+    {
+        hexInfo          = HexInfo();
+        hexInfoResult    = ParsingResult::ok;
+        hexInfoErrorLine = std::size_t(-1);
+
+        for(auto lineIdx : addressLines)
+        {
+            ParsingResult r = ParsingResult::ok;
+            if (!lineRecordRaw(lineIdx).updateHexInfo(r, hexInfo))
+            {
+                hexInfoResult    = r;
+                hexInfoErrorLine = lineIdx;
+                break;
+            }
+        }
+    }
+
+    //! Пересчитывает адреса с firstLine; за пределами изменённых строк (с stableLine) останавливается,
+    //! как только состояние на входе в строку совпадает с прежним
+    std::size_t updateAddresses(std::size_t firstLine, std::size_t stableLine, HexEntriesAddressState state)
+    {
+        std::size_t lineIdx = firstLine;
+        for(std::size_t blockIdx=findBlock(firstLine); blockIdx!=blocks.size(); ++blockIdx)
+        {
+            LineBlock &b = blocks[blockIdx];
+            for(std::size_t i=lineIdx-b.firstLine; i!=b.size(); ++i, ++lineIdx)
+            {
+                if (lineIdx>=stableLine && isSameAddressState(b.lineStates[i], state))
+                    return lineIdx-firstLine;
+
+                b.lineStates[i] = state;
+                state = updateHexEntriesAddressAndMode(b.lineRecords.begin()+std::ptrdiff_t(i), b.lineRecords.begin()+std::ptrdiff_t(i+1), state);
+            }
+        }
+
+        return lineIdx-firstLine;
+    }
+
+    //! Одна правка. Смещения - в текущем тексте
+    bool applyEditImpl(std::size_t offset, std::size_t size, const char* pNewText, std::size_t newTextSize)
+    {
+        if (offset>text.size() || size>text.size()-offset)
+            return false;
+
+        // Задетые строки - от строки с началом правки до строки с её концом включительно
+        const std::size_t firstLine   = findLine(offset);
+        const std::size_t lastLine    = findLine(offset+size);
+        const bool        lastIsOpen  = lastLine+1==linesCount; // Последняя строка документа, без '\n'
+        const std::size_t regionBegin = getLineOffset(firstLine);
+        const std::size_t regionEnd   = lastIsOpen ? text.size() : getLineOffset(lastLine+1);
+        const std::size_t oldNumLines = lastLine-firstLine+1;
+
+        // До замены запоминаем, были ли в задетых строках адресные записи
+        bool hexInfoChanged = false;
+        for(std::size_t i=firstLine; i!=lastLine+1; ++i)
+        {
+            if (isAddressRecordType(lineRecordRaw(i).recordType))
+                hexInfoChanged = true;
+            if (isErrorResult(getLineResult(i)))
+                --errorsCount;
+        }
+
+        // Состояние на входе в первую задетую строку от правки не зависит
+        const LineBlock              &inBlock = blocks[findBlock(firstLine)];
+        const HexEntriesAddressState  inState = inBlock.lineStates[firstLine-inBlock.firstLine];
+
+        text.replace(offset, size, pNewText, newTextSize);
+        const std::size_t newRegionEnd = regionEnd-size+newTextSize;
+
+        LinesRange newLines;
+        parseLines(regionBegin, newRegionEnd, lastIsOpen, newLines);
+
+        const std::size_t newNumLines = newLines.size();
+
+        for(std::size_t i=0; i!=newNumLines; ++i)
+        {
+            if (isErrorResult(newLines.lineResults[i]))
+                ++errorsCount;
+            if (isAddressRecordType(newLines.lineRecords[i].recordType))
+                hexInfoChanged = true;
+        }
+
+        // Смещения и номера строк после правки сдвигаются по модулю 2^N, при сложении всё сойдётся
+        const std::size_t textDelta  = newTextSize-size;
+        const std::size_t lineDelta  = newNumLines-oldNumLines;
+        const std::size_t stableLine = firstLine+newNumLines;
+
+        replaceLines(firstLine, oldNumLines, newLines, textDelta);
+
+        // Список адресных строк
+        if (hexInfoChanged || lineDelta!=0)
+        {
+            auto eraseBegin = std::lower_bound(addressLines.begin(), addressLines.end(), firstLine);
+            auto eraseEnd   = std::lower_bound(eraseBegin, addressLines.end(), firstLine+oldNumLines);
+            auto insPos     = addressLines.erase(eraseBegin, eraseEnd);
+
+            for(auto it=insPos; it!=addressLines.end(); ++it)
+                *it += lineDelta;
+
+            std::vector<std::size_t> newAddressLines;
+            for(std::size_t i=0; i!=newNumLines; ++i)
+            {
+                if (isAddressRecordType(lineRecordRaw(firstLine+i).recordType))
+                    newAddressLines.emplace_back(firstLine+i);
+            }
+
+            addressLines.insert(insPos, newAddressLines.begin(), newAddressLines.end());
+        }
+
+        lastUpdateStats.reparsedLines       += newNumLines;
+        lastUpdateStats.addressUpdatedLines += updateAddresses(firstLine, stableLine, inState);
+
+        if (hexInfoChanged)
+        {
+            rebuildHexInfo();
+            lastUpdateStats.hexInfoUpdated = true;
+        }
+        else if (hexInfoErrorLine!=std::size_t(-1) && hexInfoErrorLine>=firstLine)
+        {
+            // Строка с ошибкой режима адресации правкой не задета (иначе hexInfoChanged), только сдвинута
+            hexInfoErrorLine += lineDelta;
+        }
+
+        return true;
+    }
+
+
+public:
+
+    HexDocument() { setText(std::string()); }
+
+    explicit
+    HexDocument(std::string hexText, ParsingOptions opts=ParsingOptions::none, std::size_t fileId_=std::size_t(-1))
+    : parsingOptions(opts)
+    , fileId(fileId_)
+    {
+        setText(std::move(hexText));
+    }
+
+    //! Опции разбора строк. Вступают в силу при следующем setText
+    void setParsingOptions(ParsingOptions opts) { parsingOptions = opts; }
+    ParsingOptions getParsingOptions() const    { return parsingOptions; }
+
+    void setFileId(std::size_t fileId_)         { fileId = fileId_; }
+
+    //! Полностью заменяет текст и разбирает его целиком
+    void setText(std::string hexText)
+    {
+        text = std::move(hexText);
+
+        blocks.clear();
+        addressLines.clear();
+        errorsCount = 0;
+
+        const std::size_t numLines = std::size_t(std::count(text.begin(), text.end(), '\n'))+1u;
+
+        LinesRange lines;
+        lines.lineOffsets.reserve(numLines);
+        lines.lineRecords.reserve(numLines);
+        lines.lineResults.reserve(numLines);
+        lines.lineStates .reserve(numLines);
+
+        parseLines(0, text.size(), true, lines);
+
+        linesCount = lines.size();
+
+        for(std::size_t i=0; i!=linesCount; ++i)
+        {
+            if (isErrorResult(lines.lineResults[i]))
+                ++errorsCount;
+            if (isAddressRecordType(lines.lineRecords[i].recordType))
+                addressLines.emplace_back(i);
+        }
+
+        blocks.reserve(linesCount/blockLines+1u);
+        splitLinesToBlocks(lines, 0, blocks);
+
+        lastUpdateStats = HexDocumentUpdateStats();
+        lastUpdateStats.reparsedLines       = linesCount;
+        lastUpdateStats.addressUpdatedLines = updateAddresses(0, linesCount, HexEntriesAddressState());
+        lastUpdateStats.hexInfoUpdated      = true;
+
+        rebuildHexInfo();
+    }
+
+    //! Заменяет [offset, offset+size) на newText и переразбирает задетые строки
+    bool replaceText(std::size_t offset, std::size_t size, const std::string &newText)
+    {
+        lastUpdateStats = HexDocumentUpdateStats();
+        return applyEditImpl(offset, size, newText.data(), newText.size());
+    }
+
+    //! Набор правок, смещения - в тексте до правок. Правки не должны пересекаться.
+    //! Применяются с конца текста, так что смещения более ранних правок остаются верными
+    bool applyEdits(std::vector<HexDocumentEdit> edits)
+    {
+        lastUpdateStats = HexDocumentUpdateStats();
+
+        std::sort(edits.begin(), edits.end(), [](const HexDocumentEdit &e1, const HexDocumentEdit &e2) { return e1.offset<e2.offset; });
+
+        for(std::size_t i=0; i!=edits.size(); ++i)
+        {
+            if (edits[i].offset>text.size() || edits[i].size>text.size()-edits[i].offset)
+                return false;
+            if (i && edits[i-1].offset+edits[i-1].size>edits[i].offset)
+                return false;
+        }
+
+        for(std::size_t i=edits.size(); i!=0; --i)
+        {
+            const HexDocumentEdit &e = edits[i-1];
+            if (!applyEditImpl(e.offset, e.size, e.text.data(), e.text.size()))
+                return false;
+        }
+
+        return true;
+    }
+
+    const std::string& getText() const                        { return text; }
+    std::size_t getLinesCount() const                         { return linesCount; }
+
+    std::size_t getLineOffset(std::size_t lineIdx) const
+    {
+        const LineBlock &b = blocks[findBlock(lineIdx)];
+        return b.textOffset+b.lineOffsets[lineIdx-b.firstLine];
+    }
+
+    //! Длина строки без '\n'
+    std::size_t getLineSize(std::size_t lineIdx) const
+    {
+        const std::size_t lineEnd = lineIdx+1==linesCount ? text.size() : getLineOffset(lineIdx+1)-1u;
+        return lineEnd-getLineOffset(lineIdx);
+    }
+
+    std::string getLineText(std::size_t lineIdx) const        { return text.substr(getLineOffset(lineIdx), getLineSize(lineIdx)); }
+
+    //! Строка, в которую попадает смещение (смещение '\n' относится к строке, которую он завершает)
+    std::size_t findLine(std::size_t offset) const
+    {
+        auto blockIt = std::upper_bound( blocks.begin(), blocks.end(), offset
+                                       , [](std::size_t o, const LineBlock &b) { return o<b.textOffset; }
+                                       );
+        const LineBlock &b = *(blockIt-1);
+
+        auto it = std::upper_bound(b.lineOffsets.begin(), b.lineOffsets.end(), offset-b.textOffset);
+        return b.firstLine+std::size_t(it-b.lineOffsets.begin())-1u;
+    }
+
+    bool            hasLineRecord(std::size_t lineIdx) const  { return lineRecordRaw(lineIdx).recordType!=HexRecordType::invalid; }
+
+    //! Ссылка действительна до следующей правки
+    const HexEntry& getLineRecord(std::size_t lineIdx) const
+    {
+        const LineBlock &b  = blocks[findBlock(lineIdx)];
+        HexEntry        &he = b.lineRecords[lineIdx-b.firstLine];
+        if (he.recordType!=HexRecordType::invalid)
+            he.filePosInfo.line = lineIdx;
+        return he;
+    }
+
+    ParsingResult   getLineResult(std::size_t lineIdx) const
+    {
+        const LineBlock &b = blocks[findBlock(lineIdx)];
+        return b.lineResults[lineIdx-b.firstLine];
+    }
+
+    std::size_t     getErrorsCount() const                    { return errorsCount; }
+
+    //! Первая строка с ошибкой разбора, или -1. Линейный поиск - для показа, не для горячего пути
+    std::size_t findFirstErrorLine(std::size_t fromLine=0) const
+    {
+        if (!errorsCount || fromLine>=linesCount)
+            return std::size_t(-1);
+
+        for(std::size_t blockIdx=findBlock(fromLine); blockIdx!=blocks.size(); ++blockIdx)
+        {
+            const LineBlock &b = blocks[blockIdx];
+            for(std::size_t i=fromLine>b.firstLine ? fromLine-b.firstLine : 0u; i!=b.size(); ++i)
+            {
+                if (isErrorResult(b.lineResults[i]))
+                    return b.firstLine+i;
+            }
+        }
+
+        return std::size_t(-1);
+    }
+
+    //! HexInfo и результат проверки режимов адресации (mismatchAddressMode/mismatchStartAddressMode) по всему документу
+    const HexInfo& getHexInfo() const                         { return hexInfo; }
+    ParsingResult  getHexInfoResult() const                   { return hexInfoResult; }
+    std::size_t    getHexInfoErrorLine() const                { return hexInfoErrorLine; }
+
+    const HexDocumentUpdateStats& getLastUpdateStats() const  { return lastUpdateStats; }
+
+    //! Все записи документа по порядку строк
+    std::vector<HexEntry> getRecords() const
+    {
+        std::vector<HexEntry> res;
+        res.reserve(linesCount);
+        for(const auto &b : blocks)
+        {
+            for(std::size_t i=0; i!=b.size(); ++i)
+            {
+                if (b.lineRecords[i].recordType==HexRecordType::invalid)
+                    continue;
+                res.emplace_back(b.lineRecords[i]);
+                res.back().filePosInfo.line = b.firstLine+i;
+            }
+        }
+
+        return res;
+    }
+
+}; // class HexDocument
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_document.h
+
@@ -0,0 +1,761 @@
+/*! \file
+    \brief Plain hex dump text ("XXXXXXXX: XX XX XX") parsing
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "file_pos_info.h"
+#include "hex_decode.h"
+#include "hex_entry.h"
+#include "hex_record_ref.h"
+#include "hex_record_table.h"
+#include "hex_writer.h"
+#include "memory_image.h"
+#include "utils.h"
+
+//----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_dump_parser.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Разбор простых дампов (см. _md/todo.md_, `--convert-dump`):
+
+        00001000: 01 02 03 04 05 06 07 08
+        1000:0100: 01 02 03
+        00 00 10 00: 01 02
+        09 0A 0B
+
+    Строка - это необязательный адрес и байты дампа. Адрес всегда заканчивается двоеточием и может быть разбит
+    пробелами побайтно, поэтому, адрес это или байты, становится ясно только на двоеточии - всё, что было
+    в строке до двоеточия, это адрес. Первое двоеточие задаёт смещение, второе - перекидывает смещение
+    в сегмент, а новым смещением становится то, что между двоеточиями (SBA: SSSS:OOOO:). Сегмент и смещение -
+    не шире 16ти разрядов, разрядность считается по количеству цифр, даже если ведущие - нули.
+    Линейный адрес - не шире 64х разрядов. Строка без адреса продолжает предыдущую, адрес первой строки
+    можно задать заранее (setBaseAddress). Байты - пары цифр, разделитель - пробелы/табуляции, группа
+    из нескольких пар подряд (01020304) - это несколько байт.
+
+    Байты копятся до конца строки, и только тогда отдаются дальше - в приёмник записей (как у IntelHexParser,
+    void(const HexRecordRef&)) или в образ памяти. Для приёмника записей данные режутся на записи по
+    recordSize байт (не через границу 64K), перед ними, когда нужно, вставляются ELA/ESA записи.
+    Режим адресации задаётся явно (setAddressMode), или выбирается по первым данным: SBA, если до них
+    встретился сегментный адрес, иначе LBA. В режиме SBA линейный адрес - это эффективный адрес.
+
+    Колонки "HH HH HH" декодируются сразу по 16 байт (utils::decodeSpacedHexPairs), посимвольный
+    автомат разбирает только адреса, концы строк и всё нестандартное.
+
+    Разбор кусками, как у IntelHexParser: состояние (в том числе недоразобранная строка) переносится
+    между вызовами parseTextChunk, конец текста - parseFinalize. Весь дамп в памяти держать не нужно,
+    см. loadHexDumpFile.
+ */
+
+//----------------------------------------------------------------------------
+class HexDumpParser
+{
+
+public:
+
+    static constexpr const std::uint64_t unknownAddress = std::uint64_t(-1);
+
+
+protected:
+
+    enum State
+    {
+        waitToken         ,
+        readToken         ,
+        skipCommentLine   ,
+        waitLf
+    };
+
+    State st = waitToken;
+
+    // Настройки
+    std::uint64_t  baseAddress = unknownAddress;
+    AddressMode    addressMode = AddressMode::none;
+    std::size_t    recordSize  = 16u;
+
+    // Текущая строка
+    std::vector<std::uint8_t>  lineBytes;          // Байты с последнего двоеточия
+    std::uint64_t  lineValue          = 0;         // Цифры с последнего двоеточия одним числом (пока их не больше 16ти)
+    std::size_t    lineDigits         = 0;
+    bool           lineHasOddToken    = false;
+    std::size_t    tokenDigits        = 0;
+    std::uint8_t   pendingNibble      = 0;
+    std::size_t    numColons          = 0;
+    std::uint64_t  offsetValue        = 0;
+    std::size_t    offsetDigits       = 0;
+    std::uint64_t  segmentValue       = 0;
+    std::size_t    segmentDigits      = 0;
+
+    // Адрес и записи
+    std::uint64_t  curAddress         = unknownAddress;
+    bool           hasSegmentAddress  = false;
+    AddressMode    outAddressMode     = AddressMode::none;
+    std::uint16_t  curBaseAddr        = 0;
+    std::uint64_t  curEntryAddress    = 0;
+    HexEntry       curEntry;
+
+
+public:
+
+    FilePosInfo    filePosInfo;
+
+
+    HexDumpParser()
+    {
+        lineBytes.reserve(256u);
+    }
+
+    void reset()
+    {
+        st = waitToken;
+        resetLine();
+        curAddress        = baseAddress;
+        hasSegmentAddress = false;
+        outAddressMode    = AddressMode::none;
+        curBaseAddr       = 0;
+        curEntryAddress   = 0;
+        curEntry.clear();
+        filePosInfo.line  = 0;
+        filePosInfo.pos   = 0;
+    }
+
+    void clear() { reset(); }
+
+    void setFileId(std::size_t fileId)
+    {
+        filePosInfo.file = fileId;
+    }
+
+    //! Адрес первого байта дампа, если первая строка с байтами идёт без адреса (`--convert-dump` с адресом)
+    void setBaseAddress(std::uint64_t addr)
+    {
+        baseAddress = addr;
+        curAddress  = addr;
+    }
+
+    //! AddressMode::none - выбрать по дампу (`--address-mode`)
+    void setAddressMode(AddressMode mode) { addressMode = mode; }
+
+    //! Размер записей данных, 1..255
+    bool setRecordSize(std::size_t sz)
+    {
+        if (sz<1u || sz>255u)
+            return false;
+        recordSize = sz;
+        return true;
+    }
+
+    std::uint64_t getCurrentAddress() const { return curAddress; }
+
+    //! Режим адресации записей результата. До первых данных - none
+    AddressMode getAddressMode() const { return outAddressMode; }
+
+    //! Парсер стоит в начале строки
+    bool isAtLineStart() const { return st==waitToken && lineDigits==0 && numColons==0 && !lineHasOddToken; }
+
+
+protected:
+
+    void resetLine()
+    {
+        lineBytes.clear();
+        lineValue       = 0;
+        lineDigits      = 0;
+        lineHasOddToken = false;
+        tokenDigits     = 0;
+        pendingNibble   = 0;
+        numColons       = 0;
+        offsetValue     = 0;
+        offsetDigits    = 0;
+        segmentValue    = 0;
+        segmentDigits   = 0;
+    }
+
+    void appendDigit(std::uint8_t d)
+    {
+        if (lineDigits<16u)
+            lineValue = (lineValue<<4) | d;
+        ++lineDigits;
+
+        if ((++tokenDigits&1u)!=0)
+            pendingNibble = d;
+        else
+            lineBytes.emplace_back(std::uint8_t((pendingNibble<<4) | d));
+    }
+
+    //! Байты, декодированные пачкой - то же самое, что appendDigit по каждой цифре
+    void appendDecodedBytes(const std::uint8_t *pBytes, std::size_t numBytes)
+    {
+        std::size_t i = 0;
+        for(; i!=numBytes && lineDigits<16u; ++i)
+        {
+            lineValue   = (lineValue<<8) | pBytes[i];
+            lineDigits += 2u;
+        }
+
+        lineDigits += 2u*(numBytes-i);
+    }
+
+    void finishToken()
+    {
+        if ((tokenDigits&1u)!=0)
+            lineHasOddToken = true;
+        tokenDigits = 0;
+    }
+
+    bool processColon(ParsingResult &r)
+    {
+        if (lineDigits==0) // Двоеточие без адреса
+            return r=ParsingResult::invalidRecord, false;
+
+        if (numColons==0)
+        {
+            offsetValue  = lineValue;
+            offsetDigits = lineDigits;
+        }
+        else if (numColons==1)
+        {
+            segmentValue  = offsetValue;
+            segmentDigits = offsetDigits;
+            offsetValue   = lineValue;
+            offsetDigits  = lineDigits;
+        }
+        else
+        {
+            return r=ParsingResult::invalidRecord, false;
+        }
+
+        ++numColons;
+        lineBytes.clear();
+        lineValue       = 0;
+        lineDigits      = 0;
+        lineHasOddToken = false;
+        return true;
+    }
+
+    //! Строка закончилась - применяем адрес и отдаём байты в onData(std::uint64_t addr, const std::uint8_t *pData, std::size_t size) -> ParsingResult
+    template<typename DataHandler>
+    ParsingResult finishLine(DataHandler &onData)
+    {
+        finishToken();
+
+        if (numColons==1)
+        {
+            if (offsetDigits>16u)
+                return ParsingResult::dumpAddressTooBig;
+            curAddress = offsetValue;
+        }
+        else if (numColons==2)
+        {
+            if (segmentDigits>4u || offsetDigits>4u)
+                return ParsingResult::dumpAddressTooBig;
+            curAddress = (segmentValue<<4) + offsetValue;
+            hasSegmentAddress = true;
+        }
+
+        if (lineHasOddToken)
+            return ParsingResult::brokenByte;
+
+        ParsingResult res = ParsingResult::ok;
+        if (!lineBytes.empty())
+        {
+            if (curAddress==unknownAddress)
+                return ParsingResult::dumpAddressMissing;
+
+            res = onData(curAddress, lineBytes.data(), lineBytes.size());
+            curAddress += lineBytes.size();
+        }
+
+        resetLine();
+        return res;
+    }
+
+    void decideAddressMode()
+    {
+        if (outAddressMode==AddressMode::none)
+            outAddressMode = addressMode!=AddressMode::none ? addressMode : hasSegmentAddress ? AddressMode::sba : AddressMode::lba;
+    }
+
+    std::uint64_t getAddressLimit() const
+    {
+        return outAddressMode==AddressMode::sba ? std::uint64_t(0x10FFF0u) : std::uint64_t(0x100000000ull);
+    }
+
+    template<typename RecordSink>
+    void flushCurEntry(RecordSink &sink)
+    {
+        if (curEntry.data.empty())
+            return;
+
+        const std::uint16_t baseAddr = getNormalizedBaseAddress(std::uint32_t(curEntryAddress), outAddressMode);
+        if (baseAddr!=curBaseAddr)
+        {
+            HexEntry baseEntry(outAddressMode==AddressMode::sba ? HexRecordType::extendedSegmentAddress : HexRecordType::extendedLinearAddress, baseAddr);
+            baseEntry.filePosInfo = filePosInfo;
+            sink(HexRecordRef(baseEntry));
+            curBaseAddr = baseAddr;
+        }
+
+        curEntry.recordType   = HexRecordType::data;
+        curEntry.address      = getNormalizedAddressOffset(std::uint32_t(curEntryAddress), baseAddr, outAddressMode);
+        curEntry.numDataBytes = std::uint8_t(curEntry.data.size());
+        curEntry.filePosInfo  = filePosInfo;
+        sink(HexRecordRef(curEntry));
+        curEntry.clear();
+    }
+
+    //! Дописывает байты в записи. Запись продолжается, пока адреса идут подряд, она не заполнена, и не кончилось 64K окно
+    template<typename RecordSink>
+    ParsingResult appendRecordsData(RecordSink &sink, std::uint64_t addr, const std::uint8_t *pData, std::size_t size)
+    {
+        decideAddressMode();
+        if (addr>=getAddressLimit() || size>getAddressLimit()-addr)
+            return ParsingResult::dumpAddressTooBig;
+
+        while(size)
+        {
+            const std::size_t curSize = curEntry.data.size();
+            if (curSize!=0 && (curEntryAddress+curSize!=addr || curSize==recordSize || (addr&0xFFFFu)==0))
+                flushCurEntry(sink);
+
+            if (curEntry.data.empty())
+                curEntryAddress = addr;
+
+            std::size_t chunk = recordSize-curEntry.data.size();
+            const std::size_t windowTail = 0x10000u - std::size_t(addr&0xFFFFu);
+            if (chunk>windowTail)
+                chunk = windowTail;
+            if (chunk>size)
+                chunk = size;
+
+            curEntry.data.insert(curEntry.data.end(), pData, pData+chunk);
+
+            addr  += chunk;
+            pData += chunk;
+            size  -= chunk;
+        }
+
+        return ParsingResult::ok;
+    }
+
+    static
+    auto makeVectorSink(std::vector<HexEntry> &resVec)
+    {
+        return [&resVec](const HexRecordRef &rec)
+        {
+            resVec.emplace_back(rec.pEntry->makeFitCopy());
+        };
+    }
+
+    static
+    auto makeImageHandler(MemoryImage &img)
+    {
+        return [&img](std::uint64_t addr, const std::uint8_t *pData, std::size_t size)
+        {
+            if (addr>=0x100000000ull || size>0x100000000ull-addr)
+                return ParsingResult::dumpAddressTooBig;
+            img.write(MemoryImage::address_t(addr), pData, size);
+            return ParsingResult::ok;
+        };
+    }
+
+    //! Общий цикл разбора. Байты каждой строки уходят в onData(std::uint64_t addr, const std::uint8_t *pData, std::size_t size) -> ParsingResult
+    template<typename DataHandler>
+    ParsingResult parseTextChunkImpl( DataHandler &&onData
+                                    , const char* pData
+                                    , std::size_t size
+                                    , std::size_t startIdx
+                                    , ParsingOptions parsingOptions
+                                    , std::size_t *pErrorOffset
+                                    )
+    {
+        std::size_t idx = startIdx;
+
+        const bool allowComments = (parsingOptions&ParsingOptions::allowComments)!=0;
+
+        auto returnError = [&](ParsingResult e)
+        {
+            if (pErrorOffset)
+                *pErrorOffset = idx;
+            return e;
+        };
+
+        if (!pData || startIdx>size)
+            return returnError(ParsingResult::invalidArgument);
+
+        const utils::HexDigitTable &digitTable = utils::getHexDigitTable();
+        ParsingResult r = ParsingResult::ok;
+
+        for(; idx!=size; ++idx)
+        {
+            const char ch = pData[idx];
+
+            switch(st)
+            {
+                case waitToken:
+                case readToken:
+                {
+                    const std::uint8_t d = digitTable.values[(std::uint8_t)ch];
+                    if (d!=0xFFu)
+                    {
+                        if (st==waitToken)
+                        {
+                            // Колонка байт "HH HH HH" - декодируем пачками
+                            std::size_t numChars = 0;
+                            do
+                            {
+                                std::uint8_t buf[64];
+                                const std::size_t numBytes = utils::decodeSpacedHexPairs(pData+idx, size-idx, &buf[0], sizeof(buf), numChars);
+                                if (!numBytes)
+                                    break;
+                                lineBytes.insert(lineBytes.end(), &buf[0], &buf[numBytes]);
+                                appendDecodedBytes(&buf[0], numBytes);
+                                idx             += numChars;
+                                filePosInfo.pos += numChars;
+                            }
+                            while(numChars==3u*64u);
+
+                            if (idx==size)
+                                return returnError(ParsingResult::ok);
+
+                            const std::uint8_t d2 = digitTable.values[(std::uint8_t)pData[idx]];
+                            if (d2==0xFFu)
+                            {
+                                --idx; // Разберём символ после последней тройки как обычно
+                                break;
+                            }
+
+                            appendDigit(d2);
+                            ++filePosInfo.pos;
+                            st = readToken;
+                            break;
+                        }
+
+                        appendDigit(d);
+                        ++filePosInfo.pos;
+                        break;
+                    }
+
+                    finishToken();
+                    st = waitToken;
+                    ++filePosInfo.pos;
+
+                    if (ch==' ' || ch=='\t')
+                        break;
+
+                    else if (ch==':')
+                    {
+                        if (!processColon(r))
+                            return returnError(r);
+                        break;
+                    }
+
+                    else if (ch=='\r' || ch=='\n')
+                    {
+                        r = finishLine(onData);
+                        if (r!=ParsingResult::ok)
+                            return returnError(r);
+
+                        if (ch=='\r')
+                        {
+                            st = waitLf;
+                        }
+                        else
+                        {
+                            ++filePosInfo.line;
+                            filePosInfo.pos = 0;
+                        }
+                        break;
+                    }
+
+                    else if ((ch=='#' || ch==';') && allowComments)
+                    {
+                        st = skipCommentLine;
+                        break;
+                    }
+
+                    --filePosInfo.pos;
+                    return returnError(ParsingResult::notDigit);
+                }
+
+                case skipCommentLine:
+                {
+                    if (ch=='\r' || ch=='\n')
+                    {
+                        st = waitToken;
+                        --idx; // Конец строки обрабатываем как обычно
+                        break;
+                    }
+
+                    ++filePosInfo.pos;
+                    break;
+                }
+
+                case waitLf:
+                {
+                    ++filePosInfo.line;
+                    filePosInfo.pos = 0;
+                    st = waitToken;
+
+                    if (ch!='\n') // Одиночный \r - разбираем символ как начало следующей строки
+                        --idx;
+                    break;
+                }
+            }
+        }
+
+        return returnError(ParsingResult::ok);
+    }
+
+
+public:
+
+    //! Разбор куска текста с выдачей записей в приёмник (sink) - void(const HexRecordRef&).
+    //! Записи выдаются без адресной информации, как у IntelHexParser
+    template<typename RecordSink>
+    ParsingResult parseTextChunk( RecordSink &&sink
+                                , const char* pData
+                                , std::size_t size
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunkImpl( [&](std::uint64_t addr, const std::uint8_t *pBytes, std::size_t numBytes)
+                                   {
+                                       return appendRecordsData(sink, addr, pBytes, numBytes);
+                                   }
+                                 , pData, size, startIdx, parsingOptions, pErrorOffset
+                                 );
+    }
+
+    template<typename RecordSink>
+    ParsingResult parseTextChunk( RecordSink &&sink
+                                , const std::string &dumpText
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunk(sink, dumpText.data(), dumpText.size(), startIdx, parsingOptions, pErrorOffset);
+    }
+
+    ParsingResult parseTextChunk( std::vector<HexEntry> &resVec
+                                , const char* pData
+                                , std::size_t size
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunk(makeVectorSink(resVec), pData, size, startIdx, parsingOptions, pErrorOffset);
+    }
+
+    ParsingResult parseTextChunk( std::vector<HexEntry> &resVec
+                                , const std::string &dumpText
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunk(makeVectorSink(resVec), dumpText.data(), dumpText.size(), startIdx, parsingOptions, pErrorOffset);
+    }
+
+    ParsingResult parseTextChunk( HexRecordTable &recordTable
+                                , const char* pData
+                                , std::size_t size
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunk<HexRecordTable&>(recordTable, pData, size, startIdx, parsingOptions, pErrorOffset);
+    }
+
+    ParsingResult parseTextChunk( HexRecordTable &recordTable
+                                , const std::string &dumpText
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunk<HexRecordTable&>(recordTable, dumpText.data(), dumpText.size(), startIdx, parsingOptions, pErrorOffset);
+    }
+
+    //! Байты пишутся прямо в образ памяти, записи не создаются
+    ParsingResult parseTextChunk( MemoryImage &img
+                                , const char* pData
+                                , std::size_t size
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunkImpl(makeImageHandler(img), pData, size, startIdx, parsingOptions, pErrorOffset);
+    }
+
+    ParsingResult parseTextChunk( MemoryImage &img
+                                , const std::string &dumpText
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunk(img, dumpText.data(), dumpText.size(), startIdx, parsingOptions, pErrorOffset);
+    }
+
+
+    //! Конец текста: разбирает последнюю строку без перевода строки, выдаёт недописанную запись и EOF запись
+    template<typename RecordSink>
+    ParsingResult parseFinalize(RecordSink &&sink)
+    {
+        auto onData = [&](std::uint64_t addr, const std::uint8_t *pBytes, std::size_t numBytes)
+        {
+            return appendRecordsData(sink, addr, pBytes, numBytes);
+        };
+
+        if (st!=waitLf)
+        {
+            const ParsingResult r = finishLine(onData);
+            if (r!=ParsingResult::ok)
+                return r;
+        }
+
+        st = waitToken;
+        decideAddressMode();
+        flushCurEntry(sink);
+
+        HexEntry eofEntry(HexRecordType::eof);
+        eofEntry.filePosInfo = filePosInfo;
+        sink(HexRecordRef(eofEntry));
+
+        return ParsingResult::ok;
+    }
+
+    ParsingResult parseFinalize(std::vector<HexEntry> &resVec)
+    {
+        return parseFinalize(makeVectorSink(resVec));
+    }
+
+    ParsingResult parseFinalize(HexRecordTable &recordTable)
+    {
+        return parseFinalize<HexRecordTable&>(recordTable);
+    }
+
+    ParsingResult parseFinalize(MemoryImage &img)
+    {
+        auto onData = makeImageHandler(img);
+        const ParsingResult r = st!=waitLf ? finishLine(onData) : ParsingResult::ok;
+        st = waitToken;
+        return r;
+    }
+
+}; // class HexDumpParser
+
+//----------------------------------------------------------------------------
+/*! Потоковая загрузка дампа: файл читается блоками по chunkSize, каждый блок сразу разбирается,
+    так что в памяти никогда не лежит больше одного блока текста. Target - std::vector<HexEntry>,
+    HexRecordTable, MemoryImage или приёмник записей. В *pErrorOffset - смещение ошибки от начала файла
+ */
+template<typename TargetType>
+ParsingResult loadHexDumpFile( HexDumpParser &parser
+                             , TargetType &&target
+                             , const std::string &fileName
+                             , ParsingOptions parsingOptions = ParsingOptions::none
+                             , std::size_t *pErrorOffset=0
+                             , std::size_t chunkSize=0x100000u
+                             )
+{
+    if (pErrorOffset)
+        *pErrorOffset = 0;
+
+    std::FILE *fp = std::fopen(fileName.c_str(), "rb");
+    if (!fp)
+        return ParsingResult::fileReadError;
+
+    if (chunkSize<4096u)
+        chunkSize = 4096u;
+
+    std::vector<char> buf(chunkSize);
+    std::size_t   fileOffset = 0;
+    ParsingResult res        = ParsingResult::ok;
+
+    for(;;)
+    {
+        const std::size_t numRead = std::fread(buf.data(), 1, buf.size(), fp);
+        if (!numRead)
+        {
+            if (std::ferror(fp))
+                res = ParsingResult::fileReadError;
+            break;
+        }
+
+        std::size_t errorOffset = 0;
+        res = parser.parseTextChunk(target, buf.data(), numRead, 0, parsingOptions, &errorOffset);
+        if (res!=ParsingResult::ok)
+        {
+            if (pErrorOffset)
+                *pErrorOffset = fileOffset+errorOffset;
+            break;
+        }
+
+        fileOffset += numRead;
+    }
+
+    std::fclose(fp);
+
+    if (res!=ParsingResult::ok)
+        return res;
+
+    if (pErrorOffset)
+        *pErrorOffset = fileOffset;
+
+    return parser.parseFinalize(target);
+}
+
+//------------------------------
+inline
+ParsingResult loadHexDumpFile( std::vector<HexEntry> &resVec
+                             , const std::string &fileName
+                             , std::uint64_t baseAddress = HexDumpParser::unknownAddress
+                             , AddressMode addressMode = AddressMode::none
+                             , ParsingOptions parsingOptions = ParsingOptions::none
+                             , std::size_t *pErrorOffset=0
+                             , std::size_t fileId=std::size_t(-1)
+                             )
+{
+    HexDumpParser parser;
+    parser.setFileId(fileId);
+    parser.setBaseAddress(baseAddress);
+    parser.setAddressMode(addressMode);
+    return loadHexDumpFile(parser, resVec, fileName, parsingOptions, pErrorOffset);
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_dump_parser.h
+
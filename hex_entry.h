@@ -7,6 +7,7 @@
 //----------------------------------------------------------------------------
 #include "enums.h"
 #include "file_pos_info.h"
+#include "hex_decode.h"
 #include "hex_info.h"
 #include "utils.h"
 #include "types.h"
@@ -85,6 +86,9 @@ namespace hex{
 //! При разборе сначала все байты кладутся в массив data, и только по окончании строки производится разбор на составляющие (перед этим проверяется КС), и лишнее удаляется
 struct HexEntry
 {
+    //! Размер заголовка записи - LL AAAA TT
+    static constexpr const std::size_t recordHeaderSize = 4u;
+
     std::uint8_t      numDataBytes = 0;
     std::uint16_t     address      = 0;
     HexRecordType     recordType   = HexRecordType::invalid;
@@ -182,26 +186,17 @@ struct HexEntry
         intVectorAppendHelper(data, b);
     }
 
+    //! Копия с данными ровно по размеру. Конструктор копирования и так выделяет память под size(), а не под capacity(),
+    //! так что копирование данных тут одно
     HexEntry makeFitCopy() const
     {
-        HexEntry res = *this;
-        //res.data.shrink_to_fit();
-        byte_vector dataTmp = byte_vector(res.data.begin(), res.data.end());
-        res.data.swap(dataTmp);
-        return res;
+        return HexEntry(*this);
     }
 
     static
     std::uint8_t calcChecksum(const std::uint8_t *pData, std::size_t size)
     {
-        std::uint8_t csum = 0;
-        for(auto idx=0u; idx!=size; ++idx)
-        {
-            std::uint8_t b = pData[idx];
-            csum += b;
-        }
-    
-        return (std::uint8_t)(0u - (unsigned)csum);
+        return utils::calcIntelHexChecksum(pData, size);
     }
 
     bool isEof() const
@@ -330,6 +325,55 @@ public:
         return calcDataByteAddress(byteIndex, baseAddress , addressMode);
     }
 
+    //! Вызывает fn(std::uint32_t addr, std::size_t dataOffset, std::size_t size) для каждого непрерывного куска
+    //! адресного пространства, в который ложатся dataSize байт записи. Обычно кусок один, но в режиме SBA
+    //! смещение заворачивается внутри 64K сегмента, а в остальных режимах - 32-битный адрес. Тогда кусков два.
+    //! Адреса получаются те же, что и у getDataByteAddress
+    template<typename SegmentHandler>
+    static
+    void forEachDataSegment( std::uint16_t a_address
+                           , std::uint16_t a_baseAddr
+                           , AddressMode a_addressMode
+                           , std::size_t dataSize
+                           , SegmentHandler fn
+                           )
+    {
+        if (!dataSize)
+            return;
+
+        std::uint32_t startAddr = 0;
+        std::size_t   firstSize = dataSize;
+
+        if (a_addressMode==AddressMode::sba)
+        {
+            startAddr = (std::uint32_t(a_baseAddr)<<4) + std::uint32_t(a_address);
+            const std::size_t segmentTail = 0x10000u - std::size_t(a_address);
+            if (firstSize>segmentTail)
+                firstSize = segmentTail;
+            fn(startAddr, std::size_t(0), firstSize);
+            if (firstSize!=dataSize)
+                fn(std::uint32_t(a_baseAddr)<<4, firstSize, dataSize-firstSize);
+            return;
+        }
+
+        startAddr = (std::uint32_t(a_baseAddr)<<16) + a_address;
+        const std::uint64_t spaceTail = 0x100000000ull - std::uint64_t(startAddr);
+        if (std::uint64_t(firstSize)>spaceTail)
+            firstSize = std::size_t(spaceTail);
+        fn(startAddr, std::size_t(0), firstSize);
+        if (firstSize!=dataSize)
+            fn(std::uint32_t(0), firstSize, dataSize-firstSize);
+    }
+
+    //! Для записей данных - см. статическую версию. Адресная информация (baseAddress, addressMode) должна быть заполнена
+    template<typename SegmentHandler>
+    void forEachDataSegment(SegmentHandler fn) const
+    {
+        if (recordType!=HexRecordType::data)
+            return;
+        forEachDataSegment(address, baseAddress, addressMode, data.size(), fn);
+    }
+
     std::uint32_t getEffectiveBaseAddress() const
     {
         switch(addressMode)
@@ -389,56 +433,28 @@ public:
     //     если просуммировать все пары шестнадцатеричных чисел, включая LL, AA, TT, DD, CC, получится 0.
 
 
-    std::string serialize(bool dontPrependColon=false)
+    //! Сериализует запись, дописывая её в конец res (без перевода строки). Для invalid ничего не дописывает
+    static
+    void serializeRecord( std::string &res
+                        , HexRecordType recordType
+                        , std::uint16_t address
+                        , const std::uint8_t *pData
+                        , std::size_t dataSize
+                        , bool dontPrependColon=false
+                        )
     {
-        //if (recordType==HexRecordType::invalid)
-
-        std::string res; res.reserve(1u+2u*(5u+data.size())); // +colon
-        if (!dontPrependColon)
-            res = ":";
-
-        std::uint8_t cs = 0;
-        auto oit = utils::HexOutputIterator(res, cs);
-
-        switch(recordType)
-        {
-            case HexRecordType::invalid: return std::string();
-
-            case HexRecordType::data:
-                 *oit++ = std::uint8_t(data.size()); // Переменное количество байт данных
-                 *oit++ = std::uint8_t(address>>8);
-                 *oit++ = std::uint8_t(address   );
-                 break;
-
-            case HexRecordType::eof:
-                 *oit++ = std::uint8_t(0); *oit++ = std::uint8_t(0); *oit++ = std::uint8_t(0); // Нет данных всегда
-                 break;
-
-            case HexRecordType::extendedSegmentAddress:
-                 *oit++ = std::uint8_t(2u); *oit++ = std::uint8_t(0); *oit++ = std::uint8_t(0); // Два байта данных всегда
-                 break;
-
-            case HexRecordType::startSegmentAddress:
-                 *oit++ = std::uint8_t(4u); *oit++ = std::uint8_t(0); *oit++ = std::uint8_t(0); // Четыре байта данных всегда
-                 break;
-
-            case HexRecordType::extendedLinearAddress:
-                 *oit++ = std::uint8_t(2u); *oit++ = std::uint8_t(0); *oit++ = std::uint8_t(0); // Два байта данных всегда
-                 break;
-
-            case HexRecordType::startLinearAddress:
-                 *oit++ = std::uint8_t(4u); *oit++ = std::uint8_t(0); *oit++ = std::uint8_t(0); // Четыре байта данных всегда
-                 break;
-        }
-
-        *oit++ = std::uint8_t(recordType);
-
-        for(auto &&b : data)
-            *oit++ = b;
+        if (recordType==HexRecordType::invalid)
+            return;
 
-        cs = (std::uint8_t)(0u - (unsigned)cs);
-        *oit++ = cs;
+        const std::size_t orgSize = res.size();
+        res.resize(orgSize+utils::calcHexRecordTextSize(dataSize, dontPrependColon));
+        utils::formatHexRecord(&res[orgSize], recordType, address, pData, dataSize, utils::getHexDigitPairs(), dontPrependColon);
+    }
 
+    std::string serialize(bool dontPrependColon=false) const
+    {
+        std::string res;
+        serializeRecord(res, recordType, address, data.data(), data.size(), dontPrependColon);
         return res;
     }
 
@@ -510,30 +526,122 @@ public:
 
 
 
+    //! Проверка режимов адресации и обновление HexInfo. Вызывается для уже разобранной записи.
+    //! Вынесено отдельно, чтобы при параллельном разборе можно было прогнать записи через HexInfo потом, по порядку
+    // TODO: Надо сделать проверки на повторное задание стартового адреса
+    bool updateHexInfo(ParsingResult &r, HexInfo &hexInfo) const
+    {
+        switch(recordType)
+        {
+            case HexRecordType::extendedSegmentAddress:
+                 if (hexInfo.addressMode!=AddressMode::none && hexInfo.addressMode!=AddressMode::sba)
+                     return r=ParsingResult::mismatchAddressMode, false;
+
+                 if (hexInfo.startAddressMode!=AddressMode::none && hexInfo.startAddressMode!=AddressMode::sba)
+                     return r=ParsingResult::mismatchStartAddressMode, false;
+
+                 hexInfo.addressMode = AddressMode::sba;
+                 if (hexInfo.baseAddress==std::uint32_t(-1))
+                     hexInfo.baseAddress = std::uint32_t(extractBaseAddressFromDataBytes())<<16;
+                 break;
+
+            case HexRecordType::startSegmentAddress:
+                 if (hexInfo.addressMode!=AddressMode::none && hexInfo.addressMode!=AddressMode::sba)
+                     return r=ParsingResult::mismatchAddressMode, false;
+
+                 if (hexInfo.startAddressMode!=AddressMode::none && hexInfo.startAddressMode!=AddressMode::sba)
+                     return r=ParsingResult::mismatchStartAddressMode, false;
+
+                 hexInfo.startAddressMode = AddressMode::sba;
+
+                 if (hexInfo.startAddress==std::uint32_t(-1))
+                     hexInfo.startAddress = extractStartAddressFromDataBytes();
+                 break;
+
+            case HexRecordType::extendedLinearAddress:
+                 if (hexInfo.addressMode!=AddressMode::none && hexInfo.addressMode!=AddressMode::lba)
+                     return r=ParsingResult::mismatchAddressMode, false;
+
+                 if (hexInfo.startAddressMode!=AddressMode::none && hexInfo.startAddressMode!=AddressMode::lba)
+                     return r=ParsingResult::mismatchStartAddressMode, false;
+
+                 hexInfo.addressMode = AddressMode::lba;
+                 if (hexInfo.baseAddress==std::uint32_t(-1))
+                     hexInfo.baseAddress = std::uint32_t(extractBaseAddressFromDataBytes())<<16;
+                 break;
+
+            case HexRecordType::startLinearAddress:
+                 if (hexInfo.startAddress==std::uint32_t(-1))
+                 {
+                     if (hexInfo.addressMode!=AddressMode::none && hexInfo.addressMode!=AddressMode::lba)
+                         return r=ParsingResult::mismatchAddressMode, false;
+
+                     if (hexInfo.startAddressMode!=AddressMode::none && hexInfo.startAddressMode!=AddressMode::lba)
+                         return r=ParsingResult::mismatchStartAddressMode, false;
+
+                     hexInfo.startAddressMode = AddressMode::lba;
+
+                     if (hexInfo.startAddress==std::uint32_t(-1))
+                         hexInfo.startAddress = extractStartAddressFromDataBytes();
+                 }
+                 break;
+
+            default: break;
+        }
+
+        return true;
+    }
+
+    //! Разбор записи, у которой все байты (заголовок, данные и КС) лежат в data
     bool parseRawData(ParsingResult &r, HexInfo *pHexInfo)
     {
-        if (data.size()<5)
+        if (data.size()<recordHeaderSize+1u)
+            return r=ParsingResult::tooFewBytes, false;
+
+        std::uint8_t header[recordHeaderSize];
+        for(std::size_t i=0; i!=recordHeaderSize; ++i)
+            header[i] = data[i];
+
+        intVectorEraseHelper( data, 0, recordHeaderSize);
+
+        return parseRawRecord(r, pHexInfo, header, recordHeaderSize);
+    }
+
+    //! Разбор записи, заголовок (LL AAAA TT) которой лежит отдельно, а в data - данные и КС.
+    //! Данные никуда не сдвигаются, с конца только отрезается КС
+    bool parseRawRecord(ParsingResult &r, HexInfo *pHexInfo, const std::uint8_t *pHeader, std::size_t headerSize)
+    {
+        if (headerSize+data.size()<recordHeaderSize+1u)
+            return r=ParsingResult::tooFewBytes, false;
+
+        const std::uint32_t bytesSum = utils::sumBytes(pHeader, recordHeaderSize) + utils::sumBytes(data.data(), data.size());
+        return parseRawRecord(r, pHexInfo, pHeader, headerSize, std::uint8_t(bytesSum));
+    }
+
+    //! То же, но сумма всех байт записи (заголовок, данные и КС) уже посчитана - обычно прямо при декодировании
+    //! цифр (utils::decodeHexPairsSum), так что проверка КС не перечитывает данные
+    bool parseRawRecord(ParsingResult &r, HexInfo *pHexInfo, const std::uint8_t *pHeader, std::size_t headerSize, std::uint8_t bytesSum)
+    {
+        if (headerSize+data.size()<recordHeaderSize+1u)
             return r=ParsingResult::tooFewBytes, false;
 
-        //std::uint8_t 
-        csumCalculated = calcChecksum(data.data(), data.size()-1);
         //std::uint8_t 
         csumReaded     = data.back();
+        //std::uint8_t 
+        csumCalculated = (std::uint8_t)(0u - (unsigned)std::uint8_t(bytesSum-csumReaded));
         if (csumCalculated!=csumReaded)
             return r=ParsingResult::checksumMismatch, false;
 
         //checksum = csumCalculated;
-        intVectorEraseHelper( data, data.size()-1,1);
+        data.pop_back();
 
-        numDataBytes = data[0];
+        numDataBytes = pHeader[0];
 
-        address = (std::uint16_t)data[1];
+        address = (std::uint16_t)pHeader[1];
         address <<= 8;
-        address |= (std::uint16_t)data[2];
-
-        recordType = (HexRecordType)data[3];
+        address |= (std::uint16_t)pHeader[2];
 
-        intVectorEraseHelper( data, 0, 4);
+        recordType = (HexRecordType)pHeader[3];
 
         if (data.size()>(std::size_t)numDataBytes)
             return r=ParsingResult::tooManyDataBytes, false;
@@ -552,8 +660,6 @@ public:
 
 
         // Проверяем количество байт данных типу записи
-        // Извлекаем адреса, если заданы
-        // TODO: Надо сделать проверки на типы адресов и на повторное задание стартового адреса
         switch(recordType)
         {
             case HexRecordType::invalid: break;
@@ -568,74 +674,21 @@ public:
             case HexRecordType::extendedSegmentAddress:
                  if (numDataBytes!=2)
                      return r=ParsingResult::dataSizeNotMatchRecordType, false;
-
-                 if (pHexInfo)
-                 {
-                     if (pHexInfo->addressMode!=AddressMode::none && pHexInfo->addressMode!=AddressMode::sba)
-                         return r=ParsingResult::mismatchAddressMode, false;
-
-                     if (pHexInfo->startAddressMode!=AddressMode::none && pHexInfo->startAddressMode!=AddressMode::sba)
-                         return r=ParsingResult::mismatchStartAddressMode, false;
-
-                     pHexInfo->addressMode = AddressMode::sba;
-                     if (pHexInfo->baseAddress==std::uint32_t(-1))
-                         pHexInfo->baseAddress = std::uint32_t(extractBaseAddressFromDataBytes())<<16;
-                 }
-
                  break;
 
             case HexRecordType::startSegmentAddress:
                  if (numDataBytes!=4)
                      return r=ParsingResult::dataSizeNotMatchRecordType, false;
-                 if (pHexInfo)
-                 {
-                     if (pHexInfo->addressMode!=AddressMode::none && pHexInfo->addressMode!=AddressMode::sba)
-                         return r=ParsingResult::mismatchAddressMode, false;
-
-                     if (pHexInfo->startAddressMode!=AddressMode::none && pHexInfo->startAddressMode!=AddressMode::sba)
-                         return r=ParsingResult::mismatchStartAddressMode, false;
-
-                     pHexInfo->startAddressMode = AddressMode::sba;
-
-                     if (pHexInfo->startAddress==std::uint32_t(-1))
-                         pHexInfo->startAddress = extractStartAddressFromDataBytes();
-                 }
-
                  break;
 
             case HexRecordType::extendedLinearAddress:
                  if (numDataBytes!=2)
                      return r=ParsingResult::dataSizeNotMatchRecordType, false;
-                 if (pHexInfo)
-                 {
-                     if (pHexInfo->addressMode!=AddressMode::none && pHexInfo->addressMode!=AddressMode::lba)
-                         return r=ParsingResult::mismatchAddressMode, false;
-
-                     if (pHexInfo->startAddressMode!=AddressMode::none && pHexInfo->startAddressMode!=AddressMode::lba)
-                         return r=ParsingResult::mismatchStartAddressMode, false;
-
-                     pHexInfo->addressMode = AddressMode::lba;
-                     if (pHexInfo->baseAddress==std::uint32_t(-1))
-                         pHexInfo->baseAddress = std::uint32_t(extractBaseAddressFromDataBytes())<<16;
-                 }
                  break;
 
             case HexRecordType::startLinearAddress:
                  if (numDataBytes!=4)
                      return r=ParsingResult::dataSizeNotMatchRecordType, false;
-                 if (pHexInfo && pHexInfo->startAddress==std::uint32_t(-1))
-                 {
-                     if (pHexInfo->addressMode!=AddressMode::none && pHexInfo->addressMode!=AddressMode::lba)
-                         return r=ParsingResult::mismatchAddressMode, false;
-
-                     if (pHexInfo->startAddressMode!=AddressMode::none && pHexInfo->startAddressMode!=AddressMode::lba)
-                         return r=ParsingResult::mismatchStartAddressMode, false;
-
-                     pHexInfo->startAddressMode = AddressMode::lba;
-
-                     if (pHexInfo->startAddress==std::uint32_t(-1))
-                         pHexInfo->startAddress = extractStartAddressFromDataBytes();
-                 }
                  break;
 
             default:
@@ -643,6 +696,9 @@ public:
                  
         }
 
+        if (pHexInfo)
+            return updateHexInfo(r, *pHexInfo);
+
         return true; // ParsingResult::ok;
         
     }
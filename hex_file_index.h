@@ -0,0 +1,636 @@
+/*! \file
+    \brief Address index of a HEX file (with binary sidecar) for random access without a full parse
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "bit_vector.h"
+#include "enums.h"
+#include "hex_entry.h"
+#include "hex_record_ref.h"
+#include "intel_hex_parser.h"
+#include "mapped_file.h"
+
+//----------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_file_index.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//! Точка входа в HEX текст - с неё можно начать разбор, не разбирая всё, что выше
+struct HexFileIndexEntry
+{
+    std::uint64_t   textOffset  = 0; //!< Смещение начала строки
+    std::uint64_t   line        = 0; //!< Номер строки (как в FilePosInfo)
+    std::uint32_t   addrFirst   = std::uint32_t(-1); //!< Первый адрес данных блока (до следующей точки входа)
+    std::uint32_t   addrLast    = 0;                 //!< Последний адрес данных блока, включительно
+    std::uint16_t   baseAddress = 0; //!< Состояние адресации на начало строки
+    AddressMode     addressMode = AddressMode::none;
+
+    bool hasData() const { return addrFirst<=addrLast; }
+
+}; // struct HexFileIndexEntry
+
+//----------------------------------------------------------------------------
+//! Ключ, по которому сайдкар индекса сверяется с HEX файлом
+struct HexFileIndexKey
+{
+    std::uint64_t   fileSize  = 0;
+    std::uint64_t   fileTime  = 0; //!< Время модификации, секунды
+    std::uint64_t   probeHash = 0; //!< FNV-1a по первым и последним probeSize байтам текста
+
+    static const std::size_t probeSize = 64u*1024u;
+
+    bool operator==(const HexFileIndexKey &other) const
+    {
+        return fileSize==other.fileSize && fileTime==other.fileTime && probeHash==other.probeHash;
+    }
+
+    bool operator!=(const HexFileIndexKey &other) const { return !operator==(other); }
+
+}; // struct HexFileIndexKey
+
+//------------------------------
+//! Хэш считается не по всему файлу, а по началу и концу - иначе проверка ключа стоила бы полного чтения.
+//! Изменения в середине без изменения размера и времени модификации не ловятся; зато при чтении
+//! блок всё равно разбирается с проверкой КС, и на битый/чужой текст readAt вернёт ошибку
+inline
+std::uint64_t calcHexFileProbeHash(const char* pData, std::size_t size)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    auto hashRange = [&](const char* b, const char* e)
+    {
+        for(; b!=e; ++b)
+        {
+            h ^= std::uint64_t(std::uint8_t(*b));
+            h *= 1099511628211ull;
+        }
+    };
+
+    const std::size_t probeSize = HexFileIndexKey::probeSize;
+    if (size<=2u*probeSize)
+    {
+        hashRange(pData, pData+size);
+    }
+    else
+    {
+        hashRange(pData, pData+probeSize);
+        hashRange(pData+size-probeSize, pData+size);
+    }
+
+    return h;
+}
+
+//------------------------------
+inline
+bool getHexFileIndexKey(const std::string &fileName, const char* pData, std::size_t size, HexFileIndexKey &key)
+{
+#if defined(_WIN32)
+    struct _stat64 st;
+    if (_stat64(fileName.c_str(), &st)!=0)
+        return false;
+#else
+    struct stat st;
+    if (stat(fileName.c_str(), &st)!=0)
+        return false;
+#endif
+
+    key.fileSize  = std::uint64_t(size);
+    key.fileTime  = std::uint64_t(st.st_mtime);
+    key.probeHash = calcHexFileProbeHash(pData, size);
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//! Индекс HEX файла: точки входа на каждой ELA/ESA записи и через каждые recordsPerEntry записей данных.
+/*!
+    Индекс строится за один проход по тексту и хранит для каждой точки входа смещение и номер строки,
+    состояние адресации и диапазон адресов данных до следующей точки входа. Для поиска по адресу
+    точки сортируются по первому адресу, и к ним считается префиксный максимум последнего адреса -
+    поиск получается двоичным, а перекрывающиеся блоки тоже находятся.
+
+    readAt разбирает только блоки, которые пересекаются с запрошенным диапазоном. При перекрытии
+    побеждают более поздние (по тексту) записи, как при последовательной загрузке в MemoryImage.
+ */
+class HexFileIndex
+{
+
+public:
+
+    HexFileIndexKey                  key;
+    ParsingOptions                   parsingOptions  = ParsingOptions::none;
+    std::uint32_t                    recordsPerEntry = 64;
+    std::vector<HexFileIndexEntry>   entries;
+
+
+protected:
+
+    std::vector<std::uint32_t>       addrOrder;       // Индексы блоков с данными по возрастанию addrFirst
+    std::vector<std::uint32_t>       addrOrderMaxLast; // Префиксный максимум addrLast по addrOrder
+
+    static constexpr const char      sidecarMagic[8]  = { 'M', 'H', 'E', 'X', 'I', 'D', 'X', '1' };
+    static const std::size_t         sidecarEntrySize = 8u+8u+4u+4u+2u+1u;
+
+
+    static
+    bool isBaseAddressRecord(HexRecordType rt)
+    {
+        return rt==HexRecordType::extendedSegmentAddress || rt==HexRecordType::extendedLinearAddress;
+    }
+
+    static
+    void putLe(std::vector<std::uint8_t> &buf, std::uint64_t v, std::size_t numBytes)
+    {
+        for(std::size_t i=0; i!=numBytes; ++i, v>>=8)
+            buf.emplace_back(std::uint8_t(v));
+    }
+
+    static
+    std::uint64_t getLe(const std::uint8_t* &p, std::size_t numBytes)
+    {
+        std::uint64_t v = 0;
+        for(std::size_t i=0; i!=numBytes; ++i)
+            v |= std::uint64_t(p[i])<<(8u*i);
+        p += numBytes;
+        return v;
+    }
+
+    //! Разбирает блок текста [b, e), начиная с состояния адресации блока, и отдаёт записи в handler.
+    //! handler(const HexEntry &he, std::uint16_t baseAddress, AddressMode addressMode)
+    template<typename RecordHandler>
+    ParsingResult parseBlock( const char* pData, std::size_t b, std::size_t e
+                            , std::uint16_t baseAddress, AddressMode addressMode
+                            , RecordHandler handler
+                            , std::size_t *pErrorOffset
+                            ) const
+    {
+        IntelHexParser parser;
+        parser.trackHexInfo = false;
+
+        auto sink = [&](const HexRecordRef &rec)
+        {
+            const HexEntry &he = *rec.pEntry;
+            if (isBaseAddressRecord(he.recordType))
+            {
+                baseAddress = he.extractBaseAddressFromDataBytes();
+                addressMode = he.recordType==HexRecordType::extendedLinearAddress ? AddressMode::lba : AddressMode::sba;
+            }
+
+            handler(he, baseAddress, addressMode);
+        };
+
+        // Без allowMultiHex разбор, как и при построении, кончается на EOF записи
+        ParsingResult res = parser.parseTextChunk(sink, pData, e, b, parsingOptions, pErrorOffset);
+        if (res==ParsingResult::unexpectedEnd)
+        {
+            res = parser.parseFinalize(sink);
+            if (res!=ParsingResult::ok && res!=ParsingResult::unexpectedEnd && pErrorOffset)
+                *pErrorOffset = e;
+        }
+
+        // Конец блока без EOF записи - это нормально
+        return res==ParsingResult::unexpectedEnd ? ParsingResult::ok : res;
+    }
+
+    std::size_t getEntryTextEnd(std::size_t entryIdx, std::size_t textSize) const
+    {
+        return entryIdx+1u<entries.size() ? std::size_t(entries[entryIdx+1u].textOffset) : textSize;
+    }
+
+
+public:
+
+    void clear()
+    {
+        key = HexFileIndexKey();
+        entries.clear();
+        addrOrder.clear();
+        addrOrderMaxLast.clear();
+    }
+
+    //! Строит структуру для поиска по адресу. build и load вызывают сами
+    void buildLookup()
+    {
+        addrOrder.clear();
+        addrOrderMaxLast.clear();
+
+        for(std::size_t i=0; i!=entries.size(); ++i)
+        {
+            if (entries[i].hasData())
+                addrOrder.emplace_back(std::uint32_t(i));
+        }
+
+        std::stable_sort(addrOrder.begin(), addrOrder.end(), [&](std::uint32_t i1, std::uint32_t i2)
+        {
+            return entries[i1].addrFirst<entries[i2].addrFirst;
+        });
+
+        addrOrderMaxLast.resize(addrOrder.size());
+        std::uint32_t maxLast = 0;
+        for(std::size_t i=0; i!=addrOrder.size(); ++i)
+        {
+            maxLast = std::max(maxLast, entries[addrOrder[i]].addrLast);
+            addrOrderMaxLast[i] = maxLast;
+        }
+    }
+
+    //! Один проход по тексту. Текст разбирается по строкам тем же парсером, так что на каждую запись
+    //! известно смещение её строки. Разбор останавливается на EOF записи (если нет allowMultiHex)
+    ParsingResult build( const char* pData, std::size_t size
+                       , ParsingOptions opts = ParsingOptions::none
+                       , std::uint32_t recsPerEntry = 64
+                       , std::size_t *pErrorOffset = 0
+                       )
+    {
+        entries.clear();
+        parsingOptions  = opts;
+        recordsPerEntry = recsPerEntry ? recsPerEntry : 1u;
+
+        IntelHexParser parser;
+        parser.trackHexInfo = false;
+
+        std::uint16_t baseAddress   = 0;
+        AddressMode   addressMode   = AddressMode::none;
+        std::uint32_t numEntryRecs  = recordsPerEntry; // Первая строка с записью открывает точку входа
+        std::size_t   lineStart     = 0;
+        std::size_t   lineIdx       = 0;
+        std::uint16_t lineBase      = 0;
+        AddressMode   lineMode      = AddressMode::none;
+        bool          lineHasRecord = false;
+
+        auto sink = [&](const HexRecordRef &rec)
+        {
+            const HexEntry &he = *rec.pEntry;
+
+            // Новая точка входа - на строке с базовым адресом или когда набралось recordsPerEntry записей данных.
+            // Состояние берём на начало строки - тогда точка верна, даже если в "строке" несколько записей
+            if (!lineHasRecord && (isBaseAddressRecord(he.recordType) || numEntryRecs>=recordsPerEntry))
+            {
+                HexFileIndexEntry entry;
+                entry.textOffset  = lineStart;
+                entry.line        = lineIdx;
+                entry.baseAddress = lineBase;
+                entry.addressMode = lineMode;
+                entries.emplace_back(entry);
+                numEntryRecs = 0;
+            }
+
+            lineHasRecord = true;
+
+            if (isBaseAddressRecord(he.recordType))
+            {
+                baseAddress = he.extractBaseAddressFromDataBytes();
+                addressMode = he.recordType==HexRecordType::extendedLinearAddress ? AddressMode::lba : AddressMode::sba;
+            }
+            else if (he.recordType==HexRecordType::data)
+            {
+                ++numEntryRecs;
+                HexFileIndexEntry &entry = entries.back();
+                HexEntry::forEachDataSegment(he.address, baseAddress, addressMode, he.data.size(), [&](std::uint32_t addr, std::size_t, std::size_t segSize)
+                {
+                    entry.addrFirst = std::min(entry.addrFirst, addr);
+                    entry.addrLast  = std::max(entry.addrLast , std::uint32_t(addr+std::uint32_t(segSize-1u)));
+                });
+            }
+        };
+
+        ParsingResult res     = ParsingResult::unexpectedEnd;
+        bool          stopped = false;
+        for(std::size_t pos=0, nextLineIdx=0; pos<size; ++nextLineIdx)
+        {
+            const char* pLf = (const char*)std::memchr(pData+pos, '\n', size-pos);
+            const std::size_t lineEnd = pLf ? std::size_t(pLf-pData)+1u : size;
+
+            lineStart     = pos;
+            lineIdx       = nextLineIdx;
+            lineBase      = baseAddress;
+            lineMode      = addressMode;
+            lineHasRecord = false;
+
+            std::size_t errorOffset = lineEnd;
+            res = parser.parseTextChunk(sink, pData, lineEnd, lineStart, opts, &errorOffset);
+            if (res!=ParsingResult::unexpectedEnd || errorOffset!=lineEnd)
+            {
+                // EOF запись, ошибка или Ctrl+Z - дальше не разбираем
+                if (res!=ParsingResult::ok && pErrorOffset)
+                    *pErrorOffset = errorOffset;
+                stopped = true;
+                break;
+            }
+
+            pos = lineEnd;
+        }
+
+        // Последняя строка без перевода строки - досылаем его, как parseTextWithFinalLineEnd, чтобы запись
+        // в ней (в том числе EOF) разбиралась так же, как в строке с переводом строки
+        if (!stopped && size!=0 && pData[size-1]!='\n')
+        {
+            static const char finalLineEnd[] = "\n";
+            std::size_t errorOffset = 0;
+            res = parser.parseTextChunk(sink, finalLineEnd, 1, 0, opts, &errorOffset);
+            if (res!=ParsingResult::ok && res!=ParsingResult::unexpectedEnd && pErrorOffset)
+                *pErrorOffset = size;
+        }
+
+        // Текст без EOF записи - если в парсере ещё что-то осталось (например, после Ctrl+Z)
+        if (res==ParsingResult::unexpectedEnd)
+        {
+            res = parser.parseFinalize(sink);
+            if (res!=ParsingResult::ok && pErrorOffset)
+                *pErrorOffset = size;
+        }
+
+        buildLookup();
+        return res;
+    }
+
+    //! Вызывает handler(std::size_t entryIdx) для каждого блока, чьи данные пересекаются с [addrFirst, addrLast].
+    //! Порядок - по убыванию addrFirst
+    template<typename EntryHandler>
+    void findEntries(std::uint32_t addrFirst, std::uint32_t addrLast, EntryHandler handler) const
+    {
+        auto it = std::upper_bound(addrOrder.begin(), addrOrder.end(), addrLast, [&](std::uint32_t a, std::uint32_t idx)
+        {
+            return a<entries[idx].addrFirst;
+        });
+
+        for(std::size_t i=std::size_t(it-addrOrder.begin()); i!=0 && addrOrderMaxLast[i-1u]>=addrFirst; --i)
+        {
+            const std::size_t entryIdx = addrOrder[i-1u];
+            if (entries[entryIdx].addrLast>=addrFirst)
+                handler(entryIdx);
+        }
+    }
+
+    //! Читает len байт с адреса address из текста pData, по которому строился индекс. Байты, которых в HEX нет,
+    //! заполняются fillByte. Возвращает число найденных байт; -1 - текст не соответствует индексу (ошибка разбора блока)
+    std::size_t readAt( const char* pData, std::size_t size
+                      , std::uint32_t address, std::uint8_t* pBuf, std::size_t len
+                      , std::uint8_t fillByte = 0xFF
+                      , ParsingResult *pRes = 0
+                      , std::size_t *pErrorOffset = 0
+                      ) const
+    {
+        if (pRes)
+            *pRes = ParsingResult::ok;
+
+        if (!len)
+            return 0;
+
+        std::memset(pBuf, fillByte, len);
+
+        const std::uint64_t queryEnd  = std::min(std::uint64_t(address)+std::uint64_t(len), std::uint64_t(0x100000000ull));
+        const std::uint32_t queryLast = std::uint32_t(queryEnd-1u);
+
+        std::vector<std::size_t> hits;
+        findEntries(address, queryLast, [&](std::size_t entryIdx) { hits.emplace_back(entryIdx); });
+        std::sort(hits.begin(), hits.end()); // Порядок текста - поздние записи перекрывают ранние
+
+        BitVector<std::size_t> found;
+        for(auto entryIdx : hits)
+        {
+            const HexFileIndexEntry &entry = entries[entryIdx];
+            const std::size_t b = std::size_t(entry.textOffset);
+            const std::size_t e = getEntryTextEnd(entryIdx, size);
+            if (b>e || e>size || (b!=0 && pData[b-1]!='\n'))
+            {
+                if (pRes)
+                    *pRes = ParsingResult::invalidRecord;
+                if (pErrorOffset)
+                    *pErrorOffset = b;
+                return std::size_t(-1);
+            }
+
+            ParsingResult res = parseBlock( pData, b, e, entry.baseAddress, entry.addressMode
+                                          , [&](const HexEntry &he, std::uint16_t baseAddress, AddressMode addressMode)
+                                            {
+                                                if (he.recordType!=HexRecordType::data)
+                                                    return;
+
+                                                HexEntry::forEachDataSegment(he.address, baseAddress, addressMode, he.data.size(), [&](std::uint32_t addr, std::size_t dataOffset, std::size_t segSize)
+                                                {
+                                                    const std::uint64_t segBegin = std::max(std::uint64_t(addr), std::uint64_t(address));
+                                                    const std::uint64_t segEnd   = std::min(std::uint64_t(addr)+segSize, queryEnd);
+                                                    if (segBegin>=segEnd)
+                                                        return;
+
+                                                    const std::size_t dstIdx = std::size_t(segBegin-address);
+                                                    const std::size_t cpySize = std::size_t(segEnd-segBegin);
+                                                    std::memcpy(pBuf+dstIdx, he.data.data()+dataOffset+std::size_t(segBegin-addr), cpySize);
+                                                    found.setRange(dstIdx, dstIdx+cpySize);
+                                                });
+                                            }
+                                          , pErrorOffset
+                                          );
+            if (res!=ParsingResult::ok)
+            {
+                if (pRes)
+                    *pRes = res;
+                return std::size_t(-1);
+            }
+        }
+
+        return found.countSet();
+    }
+
+    //------------------------------
+    //! Сайдкар: заголовок (магия, ключ, опции, recordsPerEntry, число точек) и точки входа, всё little endian
+    bool save(const std::string &fileName) const
+    {
+        std::vector<std::uint8_t> buf;
+        buf.reserve(64u+entries.size()*sidecarEntrySize);
+
+        // Побайтно, как putLe - insert из массива в пустой вектор g++ 12 -O2 считает переполнением (-Wstringop-overflow)
+        for(char ch : sidecarMagic)
+            buf.emplace_back(std::uint8_t(ch));
+        putLe(buf, key.fileSize , 8);
+        putLe(buf, key.fileTime , 8);
+        putLe(buf, key.probeHash, 8);
+        putLe(buf, std::uint64_t(parsingOptions), 4);
+        putLe(buf, recordsPerEntry, 4);
+        putLe(buf, entries.size(), 8);
+
+        for(const auto &entry : entries)
+        {
+            putLe(buf, entry.textOffset , 8);
+            putLe(buf, entry.line       , 8);
+            putLe(buf, entry.addrFirst  , 4);
+            putLe(buf, entry.addrLast   , 4);
+            putLe(buf, entry.baseAddress, 2);
+            putLe(buf, std::uint64_t(entry.addressMode), 1);
+        }
+
+        std::FILE *fp = std::fopen(fileName.c_str(), "wb");
+        if (!fp)
+            return false;
+
+        const bool res = std::fwrite(buf.data(), 1, buf.size(), fp)==buf.size();
+        return std::fclose(fp)==0 && res;
+    }
+
+    //! Загружает сайдкар. Если задан pExpectedKey, ключ должен с ним совпасть
+    bool load(const std::string &fileName, const HexFileIndexKey *pExpectedKey=0)
+    {
+        clear();
+
+        std::FILE *fp = std::fopen(fileName.c_str(), "rb");
+        if (!fp)
+            return false;
+
+        std::vector<std::uint8_t> buf;
+        std::uint8_t readBuf[64*1024];
+        for(;;)
+        {
+            const std::size_t numRead = std::fread(readBuf, 1, sizeof(readBuf), fp);
+            buf.insert(buf.end(), readBuf, readBuf+numRead);
+            if (numRead!=sizeof(readBuf))
+                break;
+        }
+
+        const bool readError = std::ferror(fp)!=0;
+        std::fclose(fp);
+
+        const std::size_t headerSize = sizeof(sidecarMagic)+8u*3u+4u+4u+8u;
+        if (readError || buf.size()<headerSize || std::memcmp(buf.data(), sidecarMagic, sizeof(sidecarMagic))!=0)
+            return false;
+
+        const std::uint8_t *p = buf.data()+sizeof(sidecarMagic);
+        key.fileSize    = getLe(p, 8);
+        key.fileTime    = getLe(p, 8);
+        key.probeHash   = getLe(p, 8);
+        parsingOptions  = ParsingOptions(std::uint32_t(getLe(p, 4)));
+        recordsPerEntry = std::uint32_t(getLe(p, 4));
+        const std::uint64_t numEntries = getLe(p, 8);
+
+        if ( (pExpectedKey && *pExpectedKey!=key)
+          || numEntries!=(buf.size()-headerSize)/sidecarEntrySize
+          || (buf.size()-headerSize)%sidecarEntrySize!=0
+           )
+        {
+            clear();
+            return false;
+        }
+
+        entries.resize(std::size_t(numEntries));
+        for(auto &entry : entries)
+        {
+            entry.textOffset  = getLe(p, 8);
+            entry.line        = getLe(p, 8);
+            entry.addrFirst   = std::uint32_t(getLe(p, 4));
+            entry.addrLast    = std::uint32_t(getLe(p, 4));
+            entry.baseAddress = std::uint16_t(getLe(p, 2));
+            entry.addressMode = AddressMode(std::uint32_t(getLe(p, 1)));
+        }
+
+        buildLookup();
+        return true;
+    }
+
+}; // class HexFileIndex
+
+//----------------------------------------------------------------------------
+//! HEX файл, отображённый в память, плюс его индекс. Индекс берётся из сайдкара, если ключ совпал,
+//! иначе строится заново и сайдкар перезаписывается
+class IndexedHexFile
+{
+
+protected:
+
+    MappedFile      file;
+    HexFileIndex    index;
+    std::string     sidecarName;
+    bool            indexLoaded = false;
+
+
+public:
+
+    //! Имя сайдкара по умолчанию - имя HEX файла плюс ".idx"
+    static std::string makeSidecarName(const std::string &fileName) { return fileName + ".idx"; }
+
+    //! opts и recordsPerEntry используются, только если индекс строится заново
+    ParsingResult open( const std::string &fileName
+                      , ParsingOptions opts = ParsingOptions::none
+                      , std::uint32_t recordsPerEntry = 64
+                      , const std::string &sidecarFileName = std::string()
+                      , std::size_t *pErrorOffset = 0
+                      )
+    {
+        indexLoaded = false;
+        index.clear();
+
+        if (!file.open(fileName))
+            return ParsingResult::fileReadError;
+
+        HexFileIndexKey key;
+        if (!getHexFileIndexKey(fileName, file.data(), file.size(), key))
+            return ParsingResult::fileReadError;
+
+        sidecarName = sidecarFileName.empty() ? makeSidecarName(fileName) : sidecarFileName;
+
+        if (index.load(sidecarName, &key))
+        {
+            indexLoaded = true;
+            return ParsingResult::ok;
+        }
+
+        ParsingResult res = index.build(file.data(), file.size(), opts, recordsPerEntry, pErrorOffset);
+        index.key = key;
+        if (res==ParsingResult::ok || res==ParsingResult::unexpectedEnd)
+            index.save(sidecarName); // Не сохранился - не страшно, в следующий раз построим снова
+
+        return res;
+    }
+
+    std::size_t readAt(std::uint32_t address, std::uint8_t* pBuf, std::size_t len, std::uint8_t fillByte=0xFF, ParsingResult *pRes=0, std::size_t *pErrorOffset=0) const
+    {
+        return index.readAt(file.data(), file.size(), address, pBuf, len, fillByte, pRes, pErrorOffset);
+    }
+
+    std::vector<std::uint8_t> readAt(std::uint32_t address, std::size_t len, std::uint8_t fillByte=0xFF, std::size_t *pNumFound=0) const
+    {
+        std::vector<std::uint8_t> res(len);
+        const std::size_t numFound = readAt(address, res.data(), len, fillByte);
+        if (pNumFound)
+            *pNumFound = numFound;
+        return res;
+    }
+
+    bool                isIndexLoaded() const { return indexLoaded; }
+    const HexFileIndex& getIndex() const      { return index; }
+    const MappedFile&   getFile() const       { return file; }
+    const std::string&  getSidecarName() const{ return sidecarName; }
+
+}; // class IndexedHexFile
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_file_index.h
+
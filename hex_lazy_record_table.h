@@ -0,0 +1,364 @@
+/*! \file
+    \brief Lazy record table - record positions in the source text, data bytes are decoded on demand
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "file_pos_info.h"
+#include "hex_decode.h"
+#include "hex_entry.h"
+#include "hex_record_ref.h"
+#include "hex_record_view.h"
+#include "mapped_file.h"
+#include "utils.h"
+
+//----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_lazy_record_table.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Ленивая таблица записей. Парсер проверяет записи полностью (структура, КС, размеры по типу), но в таблицу
+    попадают только поля заголовка, состояние адресации и смещение записи в тексте - декодированных байт
+    данных таблица не хранит. Данные декодируются из исходного текста (обычно - отображённого в память файла)
+    по запросу. На запись уходит 19 байт, независимо от длины её данных (HexRecordTable хранит ещё и сами
+    данные, HexEntry - вдобавок блок в куче на каждую запись).
+
+    Текст должен жить, пока живёт таблица. Таблица может сама владеть отображённым файлом (setText(MappedFile&&)),
+    так делает loadIntelHexFile для ленивой таблицы.
+
+    Смещения записей берутся из парсера (HexRecordRef::textOffset) и отсчитываются от pData, переданного
+    в parseTextChunk - поэтому весь текст разбирается одним буфером (можно частями, через startIdx).
+
+    getHexRecordData для таблицы нет - указателя на готовые данные у неё просто не бывает; алгоритмы,
+    которым нужны только адреса (проверки, перекрытия, индекс адресов, порядок записей), работают с ней напрямую,
+    для данных - decodeData/getEntry.
+ */
+
+//----------------------------------------------------------------------------
+class HexLazyRecordTable
+{
+
+public:
+
+    std::vector<HexRecordType>   recordTypes  ;
+    std::vector<std::uint16_t>   addresses    ; //!< Поле адреса записи (для не-данных - как в HexRecordTable)
+    std::vector<std::uint16_t>   baseAddresses; //!< ULBA/USBA
+    std::vector<std::uint8_t>    addressModes ; //!< AddressMode, байтом - ради размера записи в таблице
+    std::vector<std::uint8_t>    dataSizes    ;
+    std::vector<std::uint32_t>   lines        ; //!< Номер строки в исходном тексте
+    std::vector<std::uint64_t>   textOffsets  ; //!< Смещение ':' записи в тексте
+
+    std::size_t                  fileId = std::size_t(-1);
+
+
+protected:
+
+    const char*      pText        = 0;
+    std::size_t      textSize     = 0;
+    bool             compactText  = true; // Цифры записей идут подряд, без пробелов (разбор без allowSpaces)
+    MappedFile       textFile;            // Если таблица сама владеет текстом
+
+    std::uint16_t    curBaseAddress = 0;
+    std::uint32_t    nextAddress    = 0;
+    AddressMode      curAddressMode = AddressMode::none;
+
+
+    template<typename T>
+    static
+    void reserveVector(std::vector<T> &vec, std::size_t n)
+    {
+        if (vec.capacity()>=n)
+            return;
+        vec.reserve(n>2u*vec.capacity() ? n : 2u*vec.capacity());
+    }
+
+
+public:
+
+    HexLazyRecordTable() = default;
+    HexLazyRecordTable(const HexLazyRecordTable&) = delete;
+    HexLazyRecordTable& operator=(const HexLazyRecordTable&) = delete;
+    HexLazyRecordTable(HexLazyRecordTable&&) = default;
+    HexLazyRecordTable& operator=(HexLazyRecordTable&&) = default;
+
+    std::size_t size()  const { return recordTypes.size(); }
+    bool        empty() const { return recordTypes.empty(); }
+
+    void clear()
+    {
+        recordTypes  .clear();
+        addresses    .clear();
+        baseAddresses.clear();
+        addressModes .clear();
+        dataSizes    .clear();
+        lines        .clear();
+        textOffsets  .clear();
+
+        curBaseAddress = 0;
+        nextAddress    = 0;
+        curAddressMode = AddressMode::none;
+    }
+
+    //! Текст, из которого декодируются данные. Свой отображённый файл, если это не он, таблица отпускает
+    void setText(const char* pData, std::size_t size)
+    {
+        if (pData!=textFile.data())
+            textFile.close();
+        pText    = pData;
+        textSize = size;
+    }
+
+    //! Таблица забирает файл себе и декодирует данные из него
+    void setText(MappedFile &&file)
+    {
+        textFile = std::move(file);
+        pText    = textFile.data();
+        textSize = textFile.size();
+    }
+
+    const char* getText()     const { return pText; }
+    std::size_t getTextSize() const { return textSize; }
+
+    //! Разбор с allowSpaces - между байтами в тексте могут быть пробелы, декодирование идёт медленным путём
+    void setCompactText(bool bCompact) { compactText = bCompact; }
+
+    void reserve(std::size_t numRecords)
+    {
+        reserveVector(recordTypes  , numRecords);
+        reserveVector(addresses    , numRecords);
+        reserveVector(baseAddresses, numRecords);
+        reserveVector(addressModes , numRecords);
+        reserveVector(dataSizes    , numRecords);
+        reserveVector(lines        , numRecords);
+        reserveVector(textOffsets  , numRecords);
+    }
+
+    //! Резервирует место по числу двоеточий в тексте
+    void reserveForText(const char* pData, std::size_t size)
+    {
+        if (!pData)
+            return;
+
+        std::size_t numColons = 0;
+        for(std::size_t i=0; i!=size; ++i)
+            numColons += pData[i]==':' ? 1u : 0u;
+
+        reserve(this->size()+numColons);
+    }
+
+    //! Добавляет запись. Базовый адрес и режим адресации вычисляются по ранее добавленным записям, как в HexRecordTable.
+    //! Данные нужны только ELA/ESA записям - для базового адреса
+    void appendRecord(HexRecordType recordType, std::uint16_t address, const std::uint8_t *pData, std::size_t dataSize, std::size_t line, std::uint64_t textOffset)
+    {
+        if (dataSize>255)
+            throw std::runtime_error("HexLazyRecordTable::appendRecord: data too big");
+
+        if (recordType!=HexRecordType::data)
+            address = std::uint16_t(nextAddress);
+
+        switch(recordType)
+        {
+            case HexRecordType::data:
+                 nextAddress = address + std::uint32_t(dataSize);
+                 break;
+
+            case HexRecordType::extendedSegmentAddress:
+            case HexRecordType::extendedLinearAddress:
+                 curAddressMode = recordType==HexRecordType::extendedSegmentAddress ? AddressMode::sba : AddressMode::lba;
+                 curBaseAddress = dataSize==2 ? std::uint16_t((std::uint16_t(pData[0])<<8) + std::uint16_t(pData[1])) : std::uint16_t(0);
+                 break;
+
+            default: break;
+        }
+
+        recordTypes  .emplace_back(recordType);
+        addresses    .emplace_back(address);
+        baseAddresses.emplace_back(curBaseAddress);
+        addressModes .emplace_back(std::uint8_t(curAddressMode));
+        dataSizes    .emplace_back(std::uint8_t(dataSize));
+        lines        .emplace_back(std::uint32_t(line));
+        textOffsets  .emplace_back(textOffset);
+    }
+
+    void appendRecord(const HexRecordRef &rec)
+    {
+        if (rec.textOffset==std::size_t(-1))
+            throw std::runtime_error("HexLazyRecordTable::appendRecord: record text offset is unknown (record started in another text chunk)");
+
+        fileId = rec.filePosInfo.file;
+        appendRecord(rec.recordType, rec.address, rec.pData, rec.dataSize, rec.filePosInfo.line, std::uint64_t(rec.textOffset));
+    }
+
+    //! Таблицу можно передавать парсеру как приёмник записей
+    void operator()(const HexRecordRef &rec)
+    {
+        appendRecord(rec);
+    }
+
+
+    HexRecordType        getRecordType      (std::size_t idx) const { return recordTypes[idx]; }
+    std::uint16_t        getAddress         (std::size_t idx) const { return addresses[idx]; }
+    std::uint16_t        getBaseAddress     (std::size_t idx) const { return baseAddresses[idx]; }
+    AddressMode          getAddressMode     (std::size_t idx) const { return AddressMode(addressModes[idx]); }
+    std::size_t          getDataSize        (std::size_t idx) const { return dataSizes[idx]; }
+    std::uint64_t        getTextOffset      (std::size_t idx) const { return textOffsets[idx]; }
+
+    std::uint32_t getEffectiveAddress(std::size_t idx) const
+    {
+        if (getAddressMode(idx)==AddressMode::sba)
+            return (std::uint32_t(baseAddresses[idx])<<4 ) + std::uint32_t(addresses[idx]);
+        return (std::uint32_t(baseAddresses[idx])<<16) + addresses[idx];
+    }
+
+    FilePosInfo getFilePosInfo(std::size_t idx) const
+    {
+        FilePosInfo fpi;
+        fpi.file = fileId;
+        fpi.line = lines[idx];
+        return fpi;
+    }
+
+    //! Адрес байта данных записи. SBA адрес заворачивается внутри 64K сегмента, как в HexEntry::getDataByteAddress
+    std::uint32_t getDataByteAddress(std::size_t idx, std::size_t byteIndex) const
+    {
+        if (recordTypes[idx]!=HexRecordType::data)
+            throw std::runtime_error("HexLazyRecordTable::getDataByteAddress - not a data record");
+
+        if (byteIndex>=dataSizes[idx])
+            throw std::runtime_error("HexLazyRecordTable::getDataByteAddress - byte index is out of range");
+
+        if (getAddressMode(idx)==AddressMode::sba)
+            return (std::uint32_t(baseAddresses[idx])<<4) + std::uint32_t(std::uint16_t(std::uint32_t(addresses[idx]) + std::uint32_t(byteIndex)));
+
+        return getEffectiveAddress(idx) + std::uint32_t(byteIndex);
+    }
+
+    //! Непрерывные куски адресного пространства записи данных, см. HexEntry::forEachDataSegment
+    template<typename SegmentHandler>
+    void forEachDataSegment(std::size_t idx, SegmentHandler fn) const
+    {
+        if (recordTypes[idx]!=HexRecordType::data)
+            return;
+        HexEntry::forEachDataSegment(addresses[idx], baseAddresses[idx], getAddressMode(idx), dataSizes[idx], fn);
+    }
+
+    //! Декодирует байты данных записи из текста в pOut (места - getDataSize(idx)). Запись при разборе уже проверена,
+    //! так что для компактного текста цифры просто декодируются. false - текст не похож на запись (текст подменили)
+    bool decodeData(std::size_t idx, std::uint8_t *pOut) const
+    {
+        const std::size_t numBytes = dataSizes[idx];
+        const std::size_t offset   = std::size_t(textOffsets[idx])+1u; // После ':'
+
+        if (!pText || offset>textSize)
+            return false;
+
+        const char*       p       = pText+offset;
+        const std::size_t tail    = textSize-offset;
+        const std::size_t skipHdr = 2u*HexEntry::recordHeaderSize;
+
+        if (compactText)
+        {
+            if (tail<skipHdr+2u*numBytes)
+                return false;
+            utils::decodeHexPairs(p+skipHdr, numBytes, pOut);
+            return true;
+        }
+
+        // Между байтами могут быть пробелы (allowSpaces) - пропускаем их, пары цифр не разрываются
+        const utils::HexDigitTable &t = utils::getHexDigitTable();
+        std::size_t pos = 0;
+        for(std::size_t byteIdx=0; byteIdx!=HexEntry::recordHeaderSize+numBytes; ++byteIdx)
+        {
+            while(pos!=tail && p[pos]==' ')
+                ++pos;
+
+            if (tail-pos<2u)
+                return false;
+
+            const std::uint8_t hi = t.values[std::uint8_t(p[pos])];
+            const std::uint8_t lo = t.values[std::uint8_t(p[pos+1u])];
+            if (hi==0xFFu || lo==0xFFu)
+                return false;
+
+            if (byteIdx>=HexEntry::recordHeaderSize)
+                pOut[byteIdx-HexEntry::recordHeaderSize] = std::uint8_t((hi<<4) | lo);
+
+            pos += 2u;
+        }
+
+        return true;
+    }
+
+    std::vector<std::uint8_t> decodeData(std::size_t idx) const
+    {
+        std::vector<std::uint8_t> res(getDataSize(idx));
+        if (!decodeData(idx, res.data()))
+            res.clear();
+        return res;
+    }
+
+    //! Вид записи над исходным текстом - байты декодируются при обращении к ним
+    HexRecordView getView(std::size_t idx) const
+    {
+        HexRecordView v;
+        v.recordType       = recordTypes[idx];
+        v.address          = addresses[idx];
+        v.baseAddress      = baseAddresses[idx];
+        v.addressMode      = getAddressMode(idx);
+        v.effectiveAddress = getEffectiveAddress(idx);
+        v.dataSize         = dataSizes[idx];
+        v.filePosInfo      = getFilePosInfo(idx);
+        v.pText            = pText ? pText+textOffsets[idx] : 0;
+        v.compactText      = compactText;
+        return v;
+    }
+
+    //! Собирает HexEntry с декодированными данными - для кода, который работает с вектором записей
+    HexEntry getEntry(std::size_t idx) const
+    {
+        std::uint8_t buf[256];
+        const bool decoded = decodeData(idx, buf);
+
+        HexEntry he;
+        he.recordType   = recordTypes[idx];
+        he.address      = addresses[idx];
+        he.numDataBytes = dataSizes[idx];
+        if (decoded)
+            he.data.assign(buf, buf+getDataSize(idx));
+        he.filePosInfo  = getFilePosInfo(idx);
+        he.baseAddress  = baseAddresses[idx];
+        he.addressMode  = getAddressMode(idx);
+        return he;
+    }
+
+}; // class HexLazyRecordTable
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_lazy_record_table.h
+
@@ -0,0 +1,97 @@
+/*! \file
+    \brief Lightweight reference to a parsed HEX record, passed to record sinks
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "file_pos_info.h"
+#include "hex_entry.h"
+
+//----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstddef>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_record_ref.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//! Ссылка на только что разобранную запись. Живёт только во время вызова приёмника (sink) -
+//! данные принадлежат парсеру и будут перезаписаны следующей записью
+struct HexRecordRef
+{
+    HexRecordType         recordType   = HexRecordType::invalid;
+    std::uint16_t         address      = 0;
+    const std::uint8_t   *pData        = 0;
+    std::size_t           dataSize     = 0;
+    FilePosInfo           filePosInfo;
+
+    //! Запись парсера, на которую ссылаемся. Её можно забрать через std::move - парсер её после вызова приёмника всё равно очищает
+    HexEntry             *pEntry       = 0;
+
+    //! Смещение ':' записи от начала pData того вызова parseTextChunk, в котором встретилось ':'.
+    //! -1 - неизвестно (запись досталась от параллельного разбора куска)
+    std::size_t           textOffset   = std::size_t(-1);
+
+
+    HexRecordRef() = default;
+    HexRecordRef(const HexRecordRef&) = default;
+    HexRecordRef& operator=(const HexRecordRef&) = default;
+
+    explicit HexRecordRef(HexEntry &he)
+    : recordType (he.recordType)
+    , address    (he.address)
+    , pData      (he.data.data())
+    , dataSize   (he.data.size())
+    , filePosInfo(he.filePosInfo)
+    , pEntry     (&he)
+    {}
+
+    const std::uint8_t* data()  const { return pData; }
+    std::size_t         size()  const { return dataSize; }
+    bool                empty() const { return dataSize==0; }
+
+    const std::uint8_t* begin() const { return pData; }
+    const std::uint8_t* end()   const { return pData+dataSize; }
+
+    std::uint8_t operator[](std::size_t idx) const { return pData[idx]; }
+
+    bool isEof() const
+    {
+        return recordType==HexRecordType::eof;
+    }
+
+    bool isBaseAddressEntry() const
+    {
+        return recordType==HexRecordType::extendedLinearAddress || recordType==HexRecordType::extendedSegmentAddress;
+    }
+
+    //! Только для ELA/ESA
+    std::uint16_t extractBaseAddressFromDataBytes() const
+    {
+        if (!isBaseAddressEntry() || dataSize!=2)
+            return 0;
+        return std::uint16_t(((std::uint16_t(pData[0])<<8) + std::uint16_t(pData[1])));
+    }
+
+}; // struct HexRecordRef
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_record_ref.h
+
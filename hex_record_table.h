@@ -0,0 +1,322 @@
+/*! \file
+    \brief Columnar (struct of arrays) storage for parsed HEX records
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "file_pos_info.h"
+#include "hex_entry.h"
+#include "hex_record_ref.h"
+#include "hex_record_view.h"
+
+//----------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_record_table.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Таблица записей - альтернатива std::vector<HexEntry>. Каждое поле записи хранится в своём плотном массиве,
+    а байты данных всех записей лежат подряд в одном общем массиве (арене). На запись данных из 16 байт
+    уходит около 40 байт, против сотни с лишним байт и отдельного блока в куче у HexEntry.
+
+    Базовый адрес и режим адресации заполняются сразу при добавлении записи, так же, как это делает
+    updateHexEntriesAddressAndMode для вектора HexEntry. Номера строк - 32 бита, этого с запасом хватает
+    для любого реального HEX-файла. Смещения в арене - 64 бита: у многогигабайтных файлов данных бывает
+    больше 4G.
+ */
+
+//----------------------------------------------------------------------------
+class HexRecordTable
+{
+
+public:
+
+    std::vector<HexRecordType>   recordTypes       ;
+    std::vector<std::uint16_t>   addresses         ; //!< Поле адреса записи (для не-данных - адрес следующего за предыдущими данными байта, как в updateHexEntriesAddressAndMode)
+    std::vector<std::uint16_t>   baseAddresses     ; //!< ULBA/USBA
+    std::vector<std::uint8_t>    addressModes      ; //!< AddressMode, байтом - как в HexLazyRecordTable
+    std::vector<std::uint32_t>   effectiveAddresses; //!< Эффективный адрес первого байта записи
+    std::vector<std::uint64_t>   dataOffsets       ; //!< Смещение данных записи в арене
+    std::vector<std::uint8_t>    dataSizes         ;
+    std::vector<std::uint32_t>   lines             ; //!< Номер строки в исходном тексте
+    std::vector<std::uint8_t>    arena             ; //!< Байты данных всех записей
+
+    std::size_t                  fileId = std::size_t(-1);
+
+
+protected:
+
+    // Текущее состояние адресации - для добавления следующих записей
+    std::uint16_t    curBaseAddress = 0;
+    std::uint32_t    nextAddress    = 0;
+    AddressMode      curAddressMode = AddressMode::none;
+
+
+public:
+
+    std::size_t size()  const { return recordTypes.size(); }
+    bool        empty() const { return recordTypes.empty(); }
+
+    void clear()
+    {
+        recordTypes       .clear();
+        addresses         .clear();
+        baseAddresses     .clear();
+        addressModes      .clear();
+        effectiveAddresses.clear();
+        dataOffsets       .clear();
+        dataSizes         .clear();
+        lines             .clear();
+        arena             .clear();
+
+        curBaseAddress = 0;
+        nextAddress    = 0;
+        curAddressMode = AddressMode::none;
+    }
+
+    //! Резервирует место под numRecords записей и numDataBytes байт данных (всего, а не в дополнение к имеющимся).
+    //! Если места не хватает, ёмкость растёт как минимум вдвое - чтобы при разборе по кускам не перевыделять память каждый раз
+    void reserve(std::size_t numRecords, std::size_t numDataBytes)
+    {
+        reserveVector(recordTypes       , numRecords);
+        reserveVector(addresses         , numRecords);
+        reserveVector(baseAddresses     , numRecords);
+        reserveVector(addressModes      , numRecords);
+        reserveVector(effectiveAddresses, numRecords);
+        reserveVector(dataOffsets       , numRecords);
+        reserveVector(dataSizes         , numRecords);
+        reserveVector(lines             , numRecords);
+        reserveVector(arena             , numDataBytes);
+    }
+
+    //! Быстрый предварительный проход по тексту: считаем двоеточия (записи) и переводы строк и резервируем место.
+    //! Строка записи - это ':', 10 цифр заголовка и КС, по две цифры на байт данных и перевод строки,
+    //! так что для текста без комментариев и с LF переводами строк размер арены получается точным
+    void reserveForText(const char* pData, std::size_t textSize)
+    {
+        if (!pData)
+            return;
+
+        std::size_t numColons = 0;
+        std::size_t numLf     = 0;
+        for(std::size_t i=0; i!=textSize; ++i)
+        {
+            numColons += pData[i]==':'  ? 1u : 0u;
+            numLf     += pData[i]=='\n' ? 1u : 0u;
+        }
+
+        const std::size_t overhead = numColons*(1u+2u*(HexEntry::recordHeaderSize+1u)) + numLf;
+        const std::size_t numDataBytes = textSize>overhead ? (textSize-overhead)/2u : 0u;
+
+        reserve(size()+numColons, arena.size()+numDataBytes);
+    }
+
+    void reserveForText(const std::string &hexText)
+    {
+        reserveForText(hexText.data(), hexText.size());
+    }
+
+
+    //! Добавляет запись. Базовый адрес и режим адресации вычисляются по ранее добавленным записям
+    void appendRecord(HexRecordType recordType, std::uint16_t address, const std::uint8_t *pData, std::size_t dataSize, std::size_t line)
+    {
+        if (dataSize>255)
+            throw std::runtime_error("HexRecordTable::appendRecord: data too big");
+
+        if (recordType!=HexRecordType::data)
+            address = std::uint16_t(nextAddress);
+
+        switch(recordType)
+        {
+            case HexRecordType::data:
+                 nextAddress = address + std::uint32_t(dataSize);
+                 break;
+
+            case HexRecordType::extendedSegmentAddress:
+            case HexRecordType::extendedLinearAddress:
+                 curAddressMode = recordType==HexRecordType::extendedSegmentAddress ? AddressMode::sba : AddressMode::lba;
+                 curBaseAddress = dataSize==2 ? std::uint16_t((std::uint16_t(pData[0])<<8) + std::uint16_t(pData[1])) : std::uint16_t(0);
+                 break;
+
+            default: break;
+        }
+
+        recordTypes       .emplace_back(recordType);
+        addresses         .emplace_back(address);
+        baseAddresses     .emplace_back(curBaseAddress);
+        addressModes      .emplace_back(std::uint8_t(curAddressMode));
+        effectiveAddresses.emplace_back(calcEffectiveAddress(address, curBaseAddress, curAddressMode));
+        dataOffsets       .emplace_back(std::uint64_t(arena.size()));
+        dataSizes         .emplace_back(std::uint8_t(dataSize));
+        lines             .emplace_back(std::uint32_t(line));
+
+        arena.insert(arena.end(), pData, pData+dataSize);
+    }
+
+    void appendRecord(const HexRecordRef &rec)
+    {
+        fileId = rec.filePosInfo.file;
+        appendRecord(rec.recordType, rec.address, rec.pData, rec.dataSize, rec.filePosInfo.line);
+    }
+
+    void appendRecord(const HexEntry &he)
+    {
+        appendRecord(he.recordType, he.address, he.data.data(), he.data.size(), he.filePosInfo.line);
+    }
+
+    //! Таблицу можно передавать парсеру как приёмник записей
+    void operator()(const HexRecordRef &rec)
+    {
+        appendRecord(rec);
+    }
+
+
+    HexRecordType        getRecordType      (std::size_t idx) const { return recordTypes[idx]; }
+    std::uint16_t        getAddress         (std::size_t idx) const { return addresses[idx]; }
+    std::uint16_t        getBaseAddress     (std::size_t idx) const { return baseAddresses[idx]; }
+    AddressMode          getAddressMode     (std::size_t idx) const { return AddressMode(addressModes[idx]); }
+    std::uint32_t        getEffectiveAddress(std::size_t idx) const { return effectiveAddresses[idx]; }
+    std::size_t          getDataSize        (std::size_t idx) const { return dataSizes[idx]; }
+    const std::uint8_t*  getData            (std::size_t idx) const { return arena.data()+std::size_t(dataOffsets[idx]); }
+
+    FilePosInfo getFilePosInfo(std::size_t idx) const
+    {
+        FilePosInfo fpi;
+        fpi.file = fileId;
+        fpi.line = lines[idx];
+        return fpi;
+    }
+
+    //! Адрес байта данных записи. SBA адрес заворачивается внутри 64K сегмента, как в HexEntry::getDataByteAddress
+    std::uint32_t getDataByteAddress(std::size_t idx, std::size_t byteIndex) const
+    {
+        if (recordTypes[idx]!=HexRecordType::data)
+            throw std::runtime_error("HexRecordTable::getDataByteAddress - not a data record");
+
+        if (byteIndex>=dataSizes[idx])
+            throw std::runtime_error("HexRecordTable::getDataByteAddress - byte index is out of range");
+
+        if (getAddressMode(idx)==AddressMode::sba)
+            return (std::uint32_t(baseAddresses[idx])<<4) + std::uint32_t(std::uint16_t(std::uint32_t(addresses[idx]) + std::uint32_t(byteIndex)));
+
+        return effectiveAddresses[idx] + std::uint32_t(byteIndex);
+    }
+
+    //! Непрерывные куски адресного пространства записи данных, см. HexEntry::forEachDataSegment
+    template<typename SegmentHandler>
+    void forEachDataSegment(std::size_t idx, SegmentHandler fn) const
+    {
+        if (recordTypes[idx]!=HexRecordType::data)
+            return;
+        HexEntry::forEachDataSegment(addresses[idx], baseAddresses[idx], getAddressMode(idx), dataSizes[idx], fn);
+    }
+
+    //! Вид записи - данные смотрят прямо в арену, без копирования
+    HexRecordView getView(std::size_t idx) const
+    {
+        HexRecordView v;
+        v.recordType       = recordTypes[idx];
+        v.address          = addresses[idx];
+        v.baseAddress      = baseAddresses[idx];
+        v.addressMode      = getAddressMode(idx);
+        v.effectiveAddress = effectiveAddresses[idx];
+        v.dataSize         = dataSizes[idx];
+        v.filePosInfo      = getFilePosInfo(idx);
+        v.pData            = getData(idx);
+        return v;
+    }
+
+    //! Собирает HexEntry - для кода, который работает с вектором записей
+    HexEntry getEntry(std::size_t idx) const
+    {
+        HexEntry he;
+        he.recordType   = recordTypes[idx];
+        he.address      = addresses[idx];
+        he.numDataBytes = dataSizes[idx];
+        he.data.assign(getData(idx), getData(idx)+getDataSize(idx));
+        he.filePosInfo  = getFilePosInfo(idx);
+        he.baseAddress  = baseAddresses[idx];
+        he.addressMode  = getAddressMode(idx);
+        return he;
+    }
+
+    std::string serialize(std::size_t idx, bool dontPrependColon=false) const
+    {
+        std::string res;
+        HexEntry::serializeRecord(res, recordTypes[idx], addresses[idx], getData(idx), getDataSize(idx), dontPrependColon);
+        return res;
+    }
+
+    //! Переставляет записи в порядке perm (новая запись i - это старая perm[i]). Арена не трогается, переставляются только смещения
+    void permute(const std::vector<std::size_t> &perm)
+    {
+        permuteVector(recordTypes       , perm);
+        permuteVector(addresses         , perm);
+        permuteVector(baseAddresses     , perm);
+        permuteVector(addressModes      , perm);
+        permuteVector(effectiveAddresses, perm);
+        permuteVector(dataOffsets       , perm);
+        permuteVector(dataSizes         , perm);
+        permuteVector(lines             , perm);
+    }
+
+
+protected:
+
+    static
+    std::uint32_t calcEffectiveAddress(std::uint16_t address, std::uint16_t baseAddress, AddressMode addressMode)
+    {
+        if (addressMode==AddressMode::sba)
+            return (std::uint32_t(baseAddress)<<4 ) + std::uint32_t(address);
+        return (std::uint32_t(baseAddress)<<16) + address;
+    }
+
+    template<typename T>
+    static
+    void reserveVector(std::vector<T> &vec, std::size_t n)
+    {
+        if (vec.capacity()>=n)
+            return;
+        vec.reserve(n>2u*vec.capacity() ? n : 2u*vec.capacity());
+    }
+
+    template<typename T>
+    static
+    void permuteVector(std::vector<T> &vec, const std::vector<std::size_t> &perm)
+    {
+        std::vector<T> tmp; tmp.reserve(perm.size());
+        for(auto idx : perm)
+            tmp.emplace_back(vec[idx]);
+        vec.swap(tmp);
+    }
+
+}; // class HexRecordTable
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_record_table.h
+
@@ -0,0 +1,306 @@
+/*! \file
+    \brief Non-owning view of a HEX record - over the source text or over decoded data in a shared arena
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "file_pos_info.h"
+#include "hex_decode.h"
+#include "hex_entry.h"
+
+//----------------------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_record_view.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Представление записи, ничем не владеющее. Байты данных берутся либо из уже декодированного общего массива
+    (арена HexRecordTable, data у HexEntry) - pData, либо декодируются на лету из исходного текста записи - pText
+    (HexLazyRecordTable). Если задано pData, текст не используется.
+
+    Вид живёт не дольше того, из чего он получен. Для кода, работающего с HexEntry, вид приводится к HexEntry -
+    с копированием данных, как и положено.
+ */
+
+//----------------------------------------------------------------------------
+struct HexRecordView
+{
+    HexRecordType         recordType       = HexRecordType::invalid;
+    std::uint16_t         address          = 0;
+    std::uint16_t         baseAddress      = 0;
+    AddressMode           addressMode      = AddressMode::none;
+    std::uint32_t         effectiveAddress = 0;
+    std::size_t           dataSize         = 0;
+    FilePosInfo           filePosInfo;
+
+    const std::uint8_t   *pData            = 0; //!< Декодированные данные (в арене); 0 - декодируем из pText
+    const char           *pText            = 0; //!< Текст записи, начиная с ':'
+    bool                  compactText      = true; //!< false - между байтами в тексте могут быть пробелы (allowSpaces)
+
+
+    //------------------------------
+    //! Итератор по байтам данных. Для текстового вида каждый байт декодируется при разыменовании
+    class const_iterator
+    {
+        const std::uint8_t   *pData   = 0;
+        const char           *pText   = 0; // На первой цифре текущего байта
+        std::size_t           idx     = 0;
+        bool                  compact = true;
+
+        friend struct HexRecordView;
+
+        static
+        const char* skipSpaces(const char *p)
+        {
+            while(*p==' ')
+                ++p;
+            return p;
+        }
+
+    public:
+
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = std::uint8_t;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const std::uint8_t*;
+        using reference         = std::uint8_t;
+
+        const_iterator() = default;
+
+        std::uint8_t operator*() const
+        {
+            if (pData)
+                return pData[idx];
+
+            const utils::HexDigitTable &t = utils::getHexDigitTable();
+            return std::uint8_t((t.values[std::uint8_t(pText[0])]<<4) | t.values[std::uint8_t(pText[1])]);
+        }
+
+        const_iterator& operator++()
+        {
+            ++idx;
+            if (!pData)
+            {
+                // За последним байтом данных ещё стоит КС, так что за пределы записи не выходим
+                pText += 2;
+                if (!compact)
+                    pText = skipSpaces(pText);
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const const_iterator &other) const { return idx==other.idx; }
+        bool operator!=(const const_iterator &other) const { return idx!=other.idx; }
+
+    }; // class const_iterator
+
+
+    //------------------------------
+    bool isDecoded() const { return pData!=0; }
+
+    std::size_t size()  const { return dataSize; }
+    bool        empty() const { return dataSize==0; }
+
+    const_iterator begin() const
+    {
+        const_iterator it;
+        it.pData   = pData;
+        it.compact = compactText;
+        if (!pData && pText)
+        {
+            const char *p = pText+1; // После ':'
+            if (compactText)
+            {
+                p += 2u*HexEntry::recordHeaderSize;
+            }
+            else
+            {
+                for(std::size_t i=0; i!=HexEntry::recordHeaderSize; ++i)
+                    p = const_iterator::skipSpaces(p) + 2;
+                p = const_iterator::skipSpaces(p);
+            }
+            it.pText = p;
+        }
+        return it;
+    }
+
+    const_iterator end() const
+    {
+        const_iterator it;
+        it.idx = dataSize;
+        return it;
+    }
+
+    //! Для текста с пробелами - линейный проход до нужного байта
+    std::uint8_t operator[](std::size_t idx) const
+    {
+        if (pData)
+            return pData[idx];
+
+        if (compactText)
+        {
+            const_iterator it = begin();
+            it.pText += 2u*idx;
+            return *it;
+        }
+
+        const_iterator it = begin();
+        for(std::size_t i=0; i!=idx; ++i)
+            ++it;
+        return *it;
+    }
+
+    //! Декодирует данные в pOut (места - size())
+    void decode(std::uint8_t *pOut) const
+    {
+        if (dataSize==0)
+            return;
+
+        if (pData)
+        {
+            std::memcpy(pOut, pData, dataSize);
+            return;
+        }
+
+        if (compactText)
+        {
+            utils::decodeHexPairs(begin().pText, dataSize, pOut);
+            return;
+        }
+
+        std::copy(begin(), end(), pOut);
+    }
+
+    //! Сравнение данных двух записей, без декодирования в промежуточный буфер
+    bool dataEquals(const HexRecordView &other) const
+    {
+        if (dataSize!=other.dataSize)
+            return false;
+
+        if (pData && other.pData)
+            return dataSize==0 || std::memcmp(pData, other.pData, dataSize)==0;
+
+        return std::equal(begin(), end(), other.begin());
+    }
+
+    bool isEof() const
+    {
+        return recordType==HexRecordType::eof;
+    }
+
+    //! Адрес байта данных записи. SBA адрес заворачивается внутри 64K сегмента, как в HexEntry::getDataByteAddress
+    std::uint32_t getDataByteAddress(std::size_t byteIndex) const
+    {
+        if (recordType!=HexRecordType::data)
+            throw std::runtime_error("HexRecordView::getDataByteAddress - not a data record");
+
+        if (byteIndex>=dataSize)
+            throw std::runtime_error("HexRecordView::getDataByteAddress - byte index is out of range");
+
+        if (addressMode==AddressMode::sba)
+            return (std::uint32_t(baseAddress)<<4) + std::uint32_t(std::uint16_t(std::uint32_t(address) + std::uint32_t(byteIndex)));
+
+        return effectiveAddress + std::uint32_t(byteIndex);
+    }
+
+    //! Непрерывные куски адресного пространства записи данных, см. HexEntry::forEachDataSegment
+    template<typename SegmentHandler>
+    void forEachDataSegment(SegmentHandler fn) const
+    {
+        if (recordType!=HexRecordType::data)
+            return;
+        HexEntry::forEachDataSegment(address, baseAddress, addressMode, dataSize, fn);
+    }
+
+    //! Собирает HexEntry с копией данных - для существующего кода, работающего с HexEntry
+    HexEntry toHexEntry() const
+    {
+        HexEntry he;
+        he.recordType   = recordType;
+        he.address      = address;
+        he.numDataBytes = std::uint8_t(dataSize);
+
+        // Вид HexEntry (makeHexRecordView) ограничения в 255 байт не имеет, поэтому без промежуточного буфера
+        if (pData)
+        {
+            he.data.assign(pData, pData+dataSize);
+        }
+        else
+        {
+            he.data.resize(dataSize);
+            decode(he.data.data());
+        }
+
+        he.filePosInfo  = filePosInfo;
+        he.baseAddress  = baseAddress;
+        he.addressMode  = addressMode;
+        return he;
+    }
+
+    operator HexEntry() const
+    {
+        return toHexEntry();
+    }
+
+    //! Эффективный адрес записи - так же, как его считают таблицы записей
+    static
+    std::uint32_t calcEffectiveAddress(std::uint16_t address, std::uint16_t baseAddress, AddressMode addressMode)
+    {
+        if (addressMode==AddressMode::sba)
+            return (std::uint32_t(baseAddress)<<4 ) + std::uint32_t(address);
+        return (std::uint32_t(baseAddress)<<16) + address;
+    }
+
+}; // struct HexRecordView
+
+//----------------------------------------------------------------------------
+//! Вид записи HexEntry - данные берутся из he.data. Базовый адрес и режим адресации должны быть уже заполнены (updateHexEntriesAddressAndMode)
+inline
+HexRecordView makeHexRecordView(const HexEntry &he)
+{
+    HexRecordView v;
+    v.recordType       = he.recordType;
+    v.address          = he.address;
+    v.baseAddress      = he.baseAddress;
+    v.addressMode      = he.addressMode;
+    v.effectiveAddress = HexRecordView::calcEffectiveAddress(he.address, he.baseAddress, he.addressMode);
+    v.dataSize         = he.data.size();
+    v.filePosInfo      = he.filePosInfo;
+    v.pData            = he.data.data();
+    return v;
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_record_view.h
+
@@ -0,0 +1,467 @@
+/*! \file
+    \brief Exporting HEX data as a flat binary into a file or a memory buffer
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "hex_entry.h"
+#include "hex_record_table.h"
+#include "memory_image.h"
+#include "parallel_utils.h"
+#include "utils.h"
+
+//----------------------------------------------------------------------------
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_to_binary.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Выгрузка образа в плоский двоичный вид. Источник - MemoryImage или записи (std::vector<HexEntry>,
+    HexRecordTable, с заполненной адресной информацией). Приёмник - буфер вызывающего с заданным адресом
+    начала, или файл: он создаётся нужного размера (ftruncate/SetEndOfFile), отображается в память,
+    и данные копируются прямо в отображение.
+
+    Всё делается кусками: данные - memcpy, дырки - memset байтом-заполнителем, побайтовых циклов нет.
+    Большие диапазоны режутся на куски по 1M (по границам 64K страниц), куски обрабатываются параллельно.
+
+    У MemoryImage заполнителем забиваются только дырки. У записей сначала забивается заполнителем весь
+    кусок, потом поверх копируются записи по порядку - как при addRecords, более поздняя запись побеждает.
+    Куски записей один раз сортируются по адресу, и каждый кусок выгрузки берёт только свои.
+ */
+
+//----------------------------------------------------------------------------
+struct BinaryExportParams
+{
+    static constexpr const std::uint64_t autoAddress = std::uint64_t(-1);
+
+    std::uint64_t   beginAddress = autoAddress; //!< Начало выгружаемого диапазона, autoAddress - первый заполненный байт
+    std::uint64_t   endAddress   = autoAddress; //!< Конец (не включая), autoAddress - за последним заполненным байтом
+    std::uint8_t    fillByte     = 0xFFu;
+    std::size_t     numThreads   = 1;           //!< 0 - по числу ядер
+
+}; // struct BinaryExportParams
+
+//----------------------------------------------------------------------------
+//! Режет [beginAddr, endAddr) на куски по 1M, выровненные по 64K, и вызывает fn(sliceBegin, sliceEnd) на numThreads потоках
+template<typename SliceHandler>
+void forEachBinaryExportSlice(std::uint64_t beginAddr, std::uint64_t endAddr, std::size_t numThreads, SliceHandler fn)
+{
+    if (beginAddr>=endAddr)
+        return;
+
+    const std::uint64_t sliceSize  = 16u*0x10000u;
+    const std::uint64_t firstSlice = (beginAddr & ~(sliceSize-1u)) + sliceSize;
+    const std::size_t   numSlices  = firstSlice>=endAddr ? std::size_t(1u) : std::size_t(1u + (endAddr-firstSlice+sliceSize-1u)/sliceSize);
+
+    auto sliceBegin = [&](std::size_t sliceIdx) { return sliceIdx ? firstSlice+(sliceIdx-1u)*sliceSize : beginAddr; };
+    auto sliceEnd   = [&](std::size_t sliceIdx) { return sliceIdx+1u==numSlices ? endAddr : sliceBegin(sliceIdx+1u); };
+
+    utils::parallelFor(numSlices, numThreads, [&](std::size_t sliceIdx)
+    {
+        fn(sliceBegin(sliceIdx), sliceEnd(sliceIdx));
+    });
+}
+
+//------------------------------
+//! Выгружает [sliceBegin, sliceEnd) образа в pBuf (pBuf соответствует адресу bufBaseAddr)
+inline
+void exportMemoryImageSlice( const MemoryImage &img
+                           , std::uint8_t *pBuf
+                           , std::uint64_t bufBaseAddr
+                           , std::uint64_t sliceBegin
+                           , std::uint64_t sliceEnd
+                           , std::uint8_t fillByte
+                           )
+{
+    std::uint64_t cur = sliceBegin;
+
+    std::vector<MemoryImage::memory_range_t> pageRanges;
+    const auto &pages = img.getPages();
+    auto it = pages.lower_bound(MemoryImage::address_t(sliceBegin & ~std::uint64_t(0xFFFFu)));
+
+    for(; it!=pages.end() && std::uint64_t(it->first)<sliceEnd; ++it)
+    {
+        const std::uint64_t pageBase = it->first;
+
+        pageRanges.clear();
+        it->second.filled.makeRanges(pageRanges, 0); // Индексы внутри страницы - с базой страницы последняя страница переполнила бы 32 бита
+
+        for(const auto &r : pageRanges)
+        {
+            std::uint64_t rb = pageBase+r.first;
+            std::uint64_t re = pageBase+r.second;
+            if (re<=cur)
+                continue;
+            if (rb>=sliceEnd)
+                break;
+            if (rb<cur)
+                rb = cur;
+            if (re>sliceEnd)
+                re = sliceEnd;
+
+            if (rb>cur)
+                std::memset(pBuf+std::size_t(cur-bufBaseAddr), fillByte, std::size_t(rb-cur));
+            std::memcpy(pBuf+std::size_t(rb-bufBaseAddr), &it->second.bytes[std::size_t(rb-pageBase)], std::size_t(re-rb));
+            cur = re;
+        }
+    }
+
+    if (sliceEnd>cur)
+        std::memset(pBuf+std::size_t(cur-bufBaseAddr), fillByte, std::size_t(sliceEnd-cur));
+}
+
+//------------------------------
+//! Кусок данных записи (не длиннее 255 байт, не переходит через конец адресного пространства)
+struct HexRecordsExportPiece
+{
+    std::uint32_t   address    = 0; //!< Эффективный адрес первого байта - ключ сортировки
+    std::uint32_t   recordIdx  = 0;
+    std::uint8_t    dataOffset = 0;
+    std::uint8_t    size       = 0;
+
+}; // struct HexRecordsExportPiece
+
+//------------------------------
+//! Куски записей, упорядоченные по адресу - строятся один раз на выгрузку, кусок выгрузки берёт из них только свой поддиапазон
+struct HexRecordsExportOrder
+{
+    std::vector<HexRecordsExportPiece>  pieces;
+    bool                                hasOverlaps = false; //!< Есть перекрытия - внутри куска выгрузки копируем в порядке записей
+
+}; // struct HexRecordsExportOrder
+
+//------------------------------
+template<typename HexRecordsType>
+void makeHexRecordsExportOrder(const HexRecordsType &records, HexRecordsExportOrder &order)
+{
+    order.pieces.clear();
+    order.hasOverlaps = false;
+
+    const std::size_t numRecords = getHexRecordsCount(records);
+    order.pieces.reserve(numRecords);
+
+    for(std::size_t idx=0; idx!=numRecords; ++idx)
+    {
+        forEachHexRecordDataSegment(records, idx, [&](std::uint32_t addr, std::size_t dataOffset, std::size_t size)
+        {
+            if (size)
+                order.pieces.emplace_back(HexRecordsExportPiece{addr, std::uint32_t(idx), std::uint8_t(dataOffset), std::uint8_t(size)});
+        });
+    }
+
+    // Обычно записи и так идут по возрастанию адресов - тогда сортировать нечего.
+    // Сортировка устойчивая - куски с одним адресом остаются в порядке записей
+    bool sorted = true;
+    for(std::size_t i=1; i<order.pieces.size() && sorted; ++i)
+        sorted = order.pieces[i-1].address<=order.pieces[i].address;
+
+    if (!sorted)
+        utils::radixSortByKey32(order.pieces, [](const HexRecordsExportPiece &piece) { return piece.address; });
+
+    std::uint64_t maxEnd = 0;
+    for(const auto &piece : order.pieces)
+    {
+        if (std::uint64_t(piece.address)<maxEnd)
+        {
+            order.hasOverlaps = true;
+            break;
+        }
+        maxEnd = std::uint64_t(piece.address)+piece.size;
+    }
+}
+
+//------------------------------
+//! Выгружает [sliceBegin, sliceEnd) записей в pBuf (pBuf соответствует адресу bufBaseAddr). Куски записей берутся
+//! из order, двоичным поиском - только те, что могут попасть в кусок выгрузки
+template<typename HexRecordsType>
+void exportHexRecordsSlice( const HexRecordsType &records
+                          , const HexRecordsExportOrder &order
+                          , std::uint8_t *pBuf
+                          , std::uint64_t bufBaseAddr
+                          , std::uint64_t sliceBegin
+                          , std::uint64_t sliceEnd
+                          , std::uint8_t fillByte
+                          )
+{
+    std::memset(pBuf+std::size_t(sliceBegin-bufBaseAddr), fillByte, std::size_t(sliceEnd-sliceBegin));
+
+    // Кусок записи не длиннее 255 байт, так что начавшиеся раньше 255 байт до начала куска выгрузки в него уже не попадут
+    const std::uint64_t searchBegin = sliceBegin>255u ? sliceBegin-255u : 0u;
+    auto addrLess = [](const HexRecordsExportPiece &piece, std::uint64_t addr) { return std::uint64_t(piece.address)<addr; };
+    auto itBegin  = std::lower_bound(order.pieces.begin(), order.pieces.end(), searchBegin, addrLess);
+    auto itEnd    = std::lower_bound(itBegin             , order.pieces.end(), sliceEnd   , addrLess);
+
+    auto copyPiece = [&](const HexRecordsExportPiece &piece)
+    {
+        std::uint64_t sb = piece.address;
+        std::uint64_t se = sb+piece.size;
+        if (se<=sliceBegin)
+            return;
+
+        const std::uint8_t *pData = getHexRecordData(records, piece.recordIdx) + piece.dataOffset;
+        if (sb<sliceBegin)
+        {
+            pData += std::size_t(sliceBegin-sb);
+            sb = sliceBegin;
+        }
+        if (se>sliceEnd)
+            se = sliceEnd;
+
+        std::memcpy(pBuf+std::size_t(sb-bufBaseAddr), pData, std::size_t(se-sb));
+    };
+
+    if (!order.hasOverlaps)
+    {
+        for(auto it=itBegin; it!=itEnd; ++it)
+            copyPiece(*it);
+        return;
+    }
+
+    // Перекрытия - более поздняя запись побеждает, поэтому копируем в порядке записей
+    std::vector<HexRecordsExportPiece> slicePieces(itBegin, itEnd);
+    std::stable_sort( slicePieces.begin(), slicePieces.end()
+                    , [](const HexRecordsExportPiece &p1, const HexRecordsExportPiece &p2) { return p1.recordIdx<p2.recordIdx; }
+                    );
+    for(const auto &piece : slicePieces)
+        copyPiece(piece);
+}
+
+//----------------------------------------------------------------------------
+//! Диапазон заполненных адресов образа [beginAddr, endAddr). Возвращает false, если образ пуст
+inline
+bool getFilledAddressRange(const MemoryImage &img, std::uint64_t &beginAddr, std::uint64_t &endAddr)
+{
+    bool found = false;
+    std::vector<MemoryImage::memory_range_t> pageRanges;
+
+    for(const auto &kv : img.getPages())
+    {
+        pageRanges.clear();
+        kv.second.filled.makeRanges(pageRanges, 0);
+        if (pageRanges.empty())
+            continue;
+
+        if (!found)
+            beginAddr = std::uint64_t(kv.first)+pageRanges.front().first;
+        endAddr = std::uint64_t(kv.first)+pageRanges.back().second;
+        found   = true;
+    }
+
+    return found;
+}
+
+//------------------------------
+template<typename HexRecordsType>
+bool getFilledAddressRange(const HexRecordsType &records, std::uint64_t &beginAddr, std::uint64_t &endAddr)
+{
+    bool found = false;
+
+    const std::size_t numRecords = getHexRecordsCount(records);
+    for(std::size_t idx=0; idx!=numRecords; ++idx)
+    {
+        forEachHexRecordDataSegment(records, idx, [&](std::uint32_t addr, std::size_t, std::size_t size)
+        {
+            const std::uint64_t sb = addr;
+            const std::uint64_t se = sb+size;
+            if (!found || sb<beginAddr)
+                beginAddr = sb;
+            if (!found || se>endAddr)
+                endAddr = se;
+            found = true;
+        });
+    }
+
+    return found;
+}
+
+//------------------------------
+//! Диапазон выгрузки по параметрам: явно заданные границы, остальное - по заполненным адресам.
+//! Возвращает false, если диапазон пуст
+template<typename SourceType>
+bool getBinaryExportRange(const SourceType &src, const BinaryExportParams &params, std::uint64_t &beginAddr, std::uint64_t &endAddr)
+{
+    std::uint64_t filledBegin = 0;
+    std::uint64_t filledEnd   = 0;
+    const bool    hasFilled   = getFilledAddressRange(src, filledBegin, filledEnd);
+
+    beginAddr = params.beginAddress!=BinaryExportParams::autoAddress ? params.beginAddress : filledBegin;
+    endAddr   = params.endAddress  !=BinaryExportParams::autoAddress ? params.endAddress   : filledEnd  ;
+
+    if (!hasFilled && (params.beginAddress==BinaryExportParams::autoAddress || params.endAddress==BinaryExportParams::autoAddress))
+        return false;
+
+    if (endAddr>0x100000000ull)
+        endAddr = 0x100000000ull;
+
+    return beginAddr<endAddr;
+}
+
+//----------------------------------------------------------------------------
+//! Выгружает образ в буфер вызывающего. Буфер соответствует адресам [bufBaseAddr, bufBaseAddr+bufSize),
+//! всё, что вне него, отсекается
+inline
+void exportBinary(const MemoryImage &img, std::uint8_t *pBuf, std::size_t bufSize, std::uint32_t bufBaseAddr, std::uint8_t fillByte=0xFFu, std::size_t numThreads=1)
+{
+    std::uint64_t endAddr = std::uint64_t(bufBaseAddr)+bufSize;
+    if (endAddr>0x100000000ull)
+        endAddr = 0x100000000ull;
+
+    forEachBinaryExportSlice(bufBaseAddr, endAddr, numThreads, [&](std::uint64_t sliceBegin, std::uint64_t sliceEnd)
+    {
+        exportMemoryImageSlice(img, pBuf, bufBaseAddr, sliceBegin, sliceEnd, fillByte);
+    });
+}
+
+//------------------------------
+template<typename HexRecordsType>
+void exportBinary(const HexRecordsType &records, std::uint8_t *pBuf, std::size_t bufSize, std::uint32_t bufBaseAddr, std::uint8_t fillByte=0xFFu, std::size_t numThreads=1)
+{
+    std::uint64_t endAddr = std::uint64_t(bufBaseAddr)+bufSize;
+    if (endAddr>0x100000000ull)
+        endAddr = 0x100000000ull;
+
+    HexRecordsExportOrder order;
+    makeHexRecordsExportOrder(records, order);
+
+    forEachBinaryExportSlice(bufBaseAddr, endAddr, numThreads, [&](std::uint64_t sliceBegin, std::uint64_t sliceEnd)
+    {
+        exportHexRecordsSlice(records, order, pBuf, bufBaseAddr, sliceBegin, sliceEnd, fillByte);
+    });
+}
+
+//------------------------------
+//! Выгружает в вектор, диапазон - по параметрам. В pBeginAddr - адрес первого байта результата
+template<typename SourceType>
+bool exportBinary(const SourceType &src, std::vector<std::uint8_t> &resVec, const BinaryExportParams &params, std::uint64_t *pBeginAddr=0)
+{
+    std::uint64_t beginAddr = 0;
+    std::uint64_t endAddr   = 0;
+    if (!getBinaryExportRange(src, params, beginAddr, endAddr))
+    {
+        resVec.clear();
+        return false;
+    }
+
+    if (pBeginAddr)
+        *pBeginAddr = beginAddr;
+
+    // Без заполнения - всё равно всё перезапишется
+    resVec.resize(std::size_t(endAddr-beginAddr));
+    exportBinary(src, resVec.data(), resVec.size(), std::uint32_t(beginAddr), params.fillByte, params.numThreads);
+    return true;
+}
+
+//----------------------------------------------------------------------------
+/*! Выгружает в файл. Файл создаётся (перезаписывается) сразу нужного размера, отображается в память на запись,
+    и выгрузка идёт прямо в отображение. Пустой диапазон - пустой файл, результат - true
+ */
+template<typename SourceType>
+bool exportBinaryFile(const SourceType &src, const std::string &fileName, const BinaryExportParams &params, std::uint64_t *pBeginAddr=0)
+{
+    std::uint64_t beginAddr = 0;
+    std::uint64_t endAddr   = 0;
+    const bool    hasData   = getBinaryExportRange(src, params, beginAddr, endAddr);
+    const std::uint64_t fileSize = hasData ? endAddr-beginAddr : 0u;
+
+    if (pBeginAddr)
+        *pBeginAddr = beginAddr;
+
+#if defined(_WIN32)
+
+    HANDLE hFile = CreateFileA(fileName.c_str(), GENERIC_READ|GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+    if (hFile==INVALID_HANDLE_VALUE)
+        return false;
+
+    if (!fileSize)
+    {
+        CloseHandle(hFile);
+        return true;
+    }
+
+    bool res = false;
+    LARGE_INTEGER li;
+    li.QuadPart = LONGLONG(fileSize);
+    if (SetFilePointerEx(hFile, li, 0, FILE_BEGIN) && SetEndOfFile(hFile))
+    {
+        HANDLE hMapping = CreateFileMappingA(hFile, 0, PAGE_READWRITE, 0, 0, 0);
+        if (hMapping)
+        {
+            std::uint8_t *pBuf = (std::uint8_t*)MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, 0);
+            if (pBuf)
+            {
+                exportBinary(src, pBuf, std::size_t(fileSize), std::uint32_t(beginAddr), params.fillByte, params.numThreads);
+                res = FlushViewOfFile((LPCVOID)pBuf, 0) ? true : false;
+                UnmapViewOfFile((LPCVOID)pBuf);
+            }
+            CloseHandle(hMapping);
+        }
+    }
+
+    CloseHandle(hFile);
+    return res;
+
+#else
+
+    int fd = ::open(fileName.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0666);
+    if (fd<0)
+        return false;
+
+    if (!fileSize)
+        return ::close(fd)==0;
+
+    bool res = false;
+    if (::ftruncate(fd, off_t(fileSize))==0)
+    {
+        void *p = ::mmap(0, std::size_t(fileSize), PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p!=MAP_FAILED)
+        {
+            exportBinary(src, (std::uint8_t*)p, std::size_t(fileSize), std::uint32_t(beginAddr), params.fillByte, params.numThreads);
+            res = ::munmap(p, std::size_t(fileSize))==0;
+        }
+    }
+
+    if (::close(fd)!=0)
+        res = false;
+
+    return res;
+
+#endif
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_to_binary.h
+
@@ -0,0 +1,472 @@
+/*! \file
+    \brief Buffered Intel HEX writer
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "hex_entry.h"
+#include "hex_record_table.h"
+#include "utils.h"
+
+//----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/hex_writer.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*! Базовый адрес (ULBA/USBA) для данных по адресу addr - один на каждое 64K окно. В режиме SBA окно N
+    адресуется сегментом N*0x1000, а окно за первым мегабайтом (SBA адреса доходят до 0x10FFEF) - сегментом 0xFFFF
+ */
+inline
+std::uint16_t getNormalizedBaseAddress(std::uint32_t addr, AddressMode addressMode)
+{
+    const std::uint32_t hi = addr>>16;
+    if (addressMode==AddressMode::sba)
+        return hi<0x10u ? std::uint16_t(hi<<12) : std::uint16_t(0xFFFFu);
+    return std::uint16_t(hi);
+}
+
+//------------------------------
+inline
+std::uint16_t getNormalizedAddressOffset(std::uint32_t addr, std::uint16_t baseAddr, AddressMode addressMode)
+{
+    return std::uint16_t(addr - (std::uint32_t(baseAddr) << (addressMode==AddressMode::sba ? 4 : 16)));
+}
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Писатель HEX. Записи форматируются прямо в один большой буфер, который переиспользуется - по таблице пар цифр
+    (utils::formatHexRecord), КС считается в том же проходе. Когда буфер заполняется, он целиком отдаётся
+    обработчику сброса: дописывается в строку, пишется в файл одним write()/WriteFile, или уходит в
+    пользовательский обработчик. Мелких выделений памяти нет вообще.
+
+    writeData сам режет данные на записи и вставляет ELA (или ESA) запись, когда адрес переходит в другое
+    64K окно. Записи данных через границу 64K не переходят.
+
+    Ошибка записи запоминается, все последующие вызовы ничего не делают и возвращают false.
+ */
+
+//----------------------------------------------------------------------------
+class HexWriter
+{
+
+public:
+
+    //! Получает очередной кусок текста, возвращает false при ошибке
+    using flush_handler_t = std::function<bool(const char*, std::size_t)>;
+
+    static constexpr const std::size_t defaultBufferSize = 1024u*1024u;
+    static constexpr const std::size_t defaultRecordSize = 16u;
+
+
+protected:
+
+    std::vector<char>   m_buffer;
+    std::size_t         m_used       = 0;
+    std::uint64_t       m_flushedSize = 0;
+    flush_handler_t     m_flushHandler;
+    bool                m_failed     = false;
+
+    HexWriterOptions    m_options     = HexWriterOptions::none;
+    const char         *m_pDigitPairs = 0;
+    std::string         m_lineEnd;
+    std::size_t         m_recordSize  = defaultRecordSize;
+
+    AddressMode         m_addressMode = AddressMode::lba;
+    std::uint16_t       m_curBaseAddr = 0; // Базовый адрес, заданный последней выданной ELA/ESA записью
+
+#if defined(_WIN32)
+    HANDLE              m_hFile = INVALID_HANDLE_VALUE;
+#else
+    int                 m_fd    = -1;
+#endif
+
+
+public:
+
+    explicit HexWriter(HexWriterOptions options=HexWriterOptions::none, std::size_t bufferSize=defaultBufferSize)
+    : m_buffer(bufferSize<4096u ? std::size_t(4096u) : bufferSize)
+    , m_options(options)
+    , m_pDigitPairs(utils::getHexDigitPairs((options&HexWriterOptions::lowercase)!=0))
+    , m_lineEnd((options&HexWriterOptions::crlf)!=0 ? "\r\n" : "\n")
+    , m_addressMode((options&HexWriterOptions::segmentAddressMode)!=0 ? AddressMode::sba : AddressMode::lba)
+    {}
+
+    HexWriter(const HexWriter&) = delete;
+    HexWriter& operator=(const HexWriter&) = delete;
+
+    //! Недосброшенное сбрасывается, файл закрывается. Чтобы узнать, удалось ли, надо вызвать flush/finish/close самому
+    ~HexWriter()
+    {
+        close();
+    }
+
+
+    //! Текст дописывается в конец str. Строка должна жить, пока жив писатель
+    void setOutput(std::string &str)
+    {
+        setOutput([&str](const char *pData, std::size_t size)
+                  {
+                      str.append(pData, size);
+                      return true;
+                  }
+                 );
+    }
+
+    void setOutput(flush_handler_t handler)
+    {
+        close();
+        m_flushHandler = std::move(handler);
+        m_failed       = false;
+    }
+
+    //! Перевод строки - любой, не только LF/CRLF из опций
+    void setLineEnd(const std::string &lineEnd) { m_lineEnd = lineEnd; }
+
+    //! Размер данных в записях, которые нарезает writeData, 1..255
+    void setRecordSize(std::size_t recordSize)
+    {
+        m_recordSize = recordSize<1u ? std::size_t(1u) : recordSize>255u ? std::size_t(255u) : recordSize;
+    }
+
+    bool good() const { return !m_failed; }
+
+    //! Сколько символов записано с момента открытия (сброшенные и ещё лежащие в буфере)
+    std::uint64_t getWrittenSize() const { return m_flushedSize+m_used; }
+
+    HexWriterOptions   getOptions()     const { return m_options; }
+    const std::string& getLineEnd()     const { return m_lineEnd; }
+    std::size_t        getRecordSize()  const { return m_recordSize; }
+    AddressMode        getAddressMode() const { return m_addressMode; }
+
+    //! Базовый адрес, заданный последней записанной ELA/ESA записью (0 - если их не было)
+    std::uint16_t getCurrentBaseAddress() const { return m_curBaseAddr; }
+
+    //! Считать, что базовый адрес уже задан, не записывая ELA/ESA. Для текста, который потом склеивается с другим текстом
+    void setCurrentBaseAddress(std::uint16_t baseAddr) { m_curBaseAddr = baseAddr; }
+
+
+#if defined(_WIN32)
+
+    //! Создаёт (перезаписывает) файл
+    bool open(const std::string &fileName)
+    {
+        close();
+
+        HANDLE hFile = CreateFileA( fileName.c_str(), GENERIC_WRITE, 0, 0, CREATE_ALWAYS
+                                  , FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, 0
+                                  );
+        if (hFile==INVALID_HANDLE_VALUE)
+            return false;
+
+        m_hFile        = hFile;
+        m_failed       = false;
+        m_flushHandler = [hFile](const char *pData, std::size_t size)
+                         {
+                             while(size)
+                             {
+                                 const DWORD toWrite = size>0x40000000u ? DWORD(0x40000000u) : DWORD(size);
+                                 DWORD numWritten = 0;
+                                 if (!WriteFile(hFile, (LPCVOID)pData, toWrite, &numWritten, 0) || !numWritten)
+                                     return false;
+                                 pData += numWritten;
+                                 size  -= std::size_t(numWritten);
+                             }
+                             return true;
+                         };
+        return true;
+    }
+
+#else
+
+    //! Создаёт (перезаписывает) файл
+    bool open(const std::string &fileName)
+    {
+        close();
+
+        int fd = ::open(fileName.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0666);
+        if (fd<0)
+            return false;
+
+        m_fd = fd;
+        setFdHandler(fd);
+        return true;
+    }
+
+    //! Пишет в уже открытый дескриптор (например, stdout). Дескриптор не закрывается
+    void setOutput(int fd)
+    {
+        close();
+        setFdHandler(fd);
+    }
+
+#endif
+
+    //! Сбрасывает буфер и закрывает файл, если он был открыт через open. Возвращает false, если была ошибка записи
+    bool close()
+    {
+        const bool res = flush();
+
+        m_flushHandler = flush_handler_t();
+
+    #if defined(_WIN32)
+        if (m_hFile!=INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(m_hFile);
+            m_hFile = INVALID_HANDLE_VALUE;
+        }
+    #else
+        if (m_fd>=0)
+        {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    #endif
+
+        m_curBaseAddr = 0;
+        m_flushedSize = 0;
+        return res;
+    }
+
+    //! Отдаёт накопленный текст обработчику. Без обработчика текст просто выбрасывается
+    bool flush()
+    {
+        if (m_used && !m_failed && m_flushHandler)
+        {
+            if (!m_flushHandler(m_buffer.data(), m_used))
+                m_failed = true;
+        }
+
+        m_flushedSize += m_used;
+        m_used = 0;
+        return !m_failed;
+    }
+
+
+    //! Дописывает готовый текст как есть (например, отформатированный другим писателем)
+    bool writeText(const char *pText, std::size_t size)
+    {
+        if (m_failed)
+            return false;
+
+        if (size>m_buffer.size()/2u)
+        {
+            // Большой кусок не копируем - отдаём обработчику сразу после уже накопленного
+            if (!flush())
+                return false;
+            if (size && m_flushHandler && !m_flushHandler(pText, size))
+                m_failed = true;
+            m_flushedSize += size;
+            return !m_failed;
+        }
+
+        char *pDst = reserveText(size);
+        if (!pDst)
+            return false;
+        if (size)
+            std::memcpy(pDst, pText, size);
+        return true;
+    }
+
+    bool writeText(const std::string &text)
+    {
+        return writeText(text.data(), text.size());
+    }
+
+    //! Записывает одну запись как есть, без учёта текущего базового адреса.
+    //! Больше 255 байт данных в запись не помещается - тогда ничего не пишется и возвращается false
+    bool writeRecord(HexRecordType recordType, std::uint16_t address, const std::uint8_t *pData, std::size_t dataSize)
+    {
+        if (recordType==HexRecordType::invalid)
+            return !m_failed;
+
+        if (dataSize>255u)
+            return false;
+
+        char *pDst = reserveText(utils::calcHexRecordTextSize(dataSize)+m_lineEnd.size());
+        if (!pDst)
+            return false;
+
+        pDst = utils::formatHexRecord(pDst, recordType, address, pData, dataSize, m_pDigitPairs);
+        std::memcpy(pDst, m_lineEnd.data(), m_lineEnd.size());
+
+        if (recordType==HexRecordType::extendedLinearAddress || recordType==HexRecordType::extendedSegmentAddress)
+            m_curBaseAddr = dataSize==2 ? std::uint16_t((std::uint16_t(pData[0])<<8) + std::uint16_t(pData[1])) : std::uint16_t(0);
+
+        return true;
+    }
+
+    bool writeRecord(const HexEntry &he)
+    {
+        return writeRecord(he.recordType, he.address, he.data.data(), he.data.size());
+    }
+
+    //! Записи пишутся как есть - базовые адреса в них уже есть
+    bool writeRecords(const std::vector<HexEntry> &heVec)
+    {
+        for(const auto &he : heVec)
+        {
+            if (!writeRecord(he))
+                return false;
+        }
+        return true;
+    }
+
+    bool writeRecords(const HexRecordTable &tbl)
+    {
+        for(std::size_t idx=0; idx!=tbl.size(); ++idx)
+        {
+            if (!writeRecord(tbl.getRecordType(idx), tbl.getAddress(idx), tbl.getData(idx), tbl.getDataSize(idx)))
+                return false;
+        }
+        return true;
+    }
+
+    //! Пишет байты данных с адреса addr, нарезая их на записи и вставляя ELA/ESA записи при смене 64K окна.
+    //! В режиме SBA адреса выше 0x10FFEF не представимы - тогда возвращается false
+    bool writeData(std::uint32_t addr, const std::uint8_t *pData, std::size_t size)
+    {
+        while(size)
+        {
+            if (m_addressMode==AddressMode::sba && addr>0x10FFEFu)
+                return false;
+
+            // Запись не должна выходить за конец окна базового адреса - в SBA окно сегмента 0xFFFF начинается
+            // не с границы 64K, поэтому считаем по смещению в окне, а не по addr&0xFFFF
+            const std::uint16_t baseAddr   = getNormalizedBaseAddress(addr, m_addressMode);
+            const std::uint16_t addrOffset = getNormalizedAddressOffset(addr, baseAddr, m_addressMode);
+
+            std::size_t chunk = 0x10000u - std::size_t(addrOffset);
+            if (chunk>m_recordSize)
+                chunk = m_recordSize;
+            if (chunk>size)
+                chunk = size;
+
+            if (baseAddr!=m_curBaseAddr)
+            {
+                const std::uint8_t baseAddrBytes[2] = { std::uint8_t(baseAddr>>8), std::uint8_t(baseAddr) };
+                const HexRecordType baseRecordType  = m_addressMode==AddressMode::sba ? HexRecordType::extendedSegmentAddress : HexRecordType::extendedLinearAddress;
+                if (!writeRecord(baseRecordType, 0, &baseAddrBytes[0], 2u))
+                    return false;
+            }
+
+            if (!writeRecord(HexRecordType::data, addrOffset, pData, chunk))
+                return false;
+
+            addr  += std::uint32_t(chunk);
+            pData += chunk;
+            size  -= chunk;
+        }
+
+        return !m_failed;
+    }
+
+    //! SLA запись, или SSA (CS в старших 16 битах, IP - в младших) в режиме SBA
+    bool writeStartAddress(std::uint32_t startAddr)
+    {
+        const std::uint8_t bytes[4] = { std::uint8_t(startAddr>>24), std::uint8_t(startAddr>>16), std::uint8_t(startAddr>>8), std::uint8_t(startAddr) };
+        return writeRecord(m_addressMode==AddressMode::sba ? HexRecordType::startSegmentAddress : HexRecordType::startLinearAddress, 0, &bytes[0], 4u);
+    }
+
+    bool writeEof()
+    {
+        return writeRecord(HexRecordType::eof, 0, 0, 0);
+    }
+
+    //! EOF запись и сброс буфера
+    bool finish()
+    {
+        writeEof();
+        return flush();
+    }
+
+
+protected:
+
+    //! Место под size символов в буфере, при необходимости буфер сначала сбрасывается. 0 - если писатель в ошибке
+    char* reserveText(std::size_t size)
+    {
+        if (m_failed)
+            return 0;
+
+        if (m_used+size>m_buffer.size())
+        {
+            if (!flush())
+                return 0;
+            if (size>m_buffer.size()) // Длинный перевод строки из setLineEnd
+                m_buffer.resize(size);
+        }
+
+        char *pDst = m_buffer.data()+m_used;
+        m_used += size;
+        return pDst;
+    }
+
+#if !defined(_WIN32)
+
+    void setFdHandler(int fd)
+    {
+        m_failed       = false;
+        m_flushHandler = [fd](const char *pData, std::size_t size)
+                         {
+                             while(size)
+                             {
+                                 ssize_t numWritten = ::write(fd, pData, size);
+                                 if (numWritten<0)
+                                 {
+                                     if (errno==EINTR)
+                                         continue;
+                                     return false;
+                                 }
+                                 pData += numWritten;
+                                 size  -= std::size_t(numWritten);
+                             }
+                             return true;
+                         };
+    }
+
+#endif
+
+}; // class HexWriter
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/hex_writer.h
+
@@ -0,0 +1,166 @@
+/*! \file
+    \brief Loading Intel HEX files without intermediate copies
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "hex_entry.h"
+#include "hex_lazy_record_table.h"
+#include "intel_hex_parallel_parser.h"
+#include "intel_hex_parser.h"
+#include "mapped_file.h"
+
+//----------------------------------------------------------------------------
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/intel_hex_loader.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//! Разбирает текст, как если бы он был подготовлен utils::prepareTextChunkForParsing, но без копирования:
+//! если в конце нет перевода строки, а разбор дошёл до конца текста, то дополнительно скармливаем парсеру "\n"
+inline
+ParsingResult parseTextWithFinalLineEnd( IntelHexParser &parser
+                                       , std::vector<HexEntry> &resVec
+                                       , const char* pData
+                                       , std::size_t size
+                                       , ParsingOptions parsingOptions = ParsingOptions::none
+                                       , std::size_t *pErrorOffset=0
+                                       , std::size_t numThreads=1
+                                       )
+{
+    std::size_t errorOffset = 0;
+    ParsingResult res = numThreads==1
+                      ? parser.parseTextChunk(resVec, pData, size, 0, parsingOptions, &errorOffset)
+                      : parseTextChunkParallel(parser, resVec, pData, size, numThreads, parsingOptions, &errorOffset)
+                      ;
+
+    if ( size!=0 && errorOffset==size
+      && pData[size-1]!='\r' && pData[size-1]!='\n'
+       )
+    {
+        static const char finalLineEnd[] = "\n";
+        const std::size_t numErrors = parser.parsingErrors.size();
+        res = parser.parseTextChunk(resVec, finalLineEnd, 1, 0, parsingOptions, &errorOffset);
+        errorOffset += size;
+        for(std::size_t i=numErrors; i!=parser.parsingErrors.size(); ++i)
+            parser.parsingErrors[i].offset += size;
+    }
+
+    if (pErrorOffset)
+        *pErrorOffset = errorOffset;
+
+    return res;
+}
+
+//----------------------------------------------------------------------------
+//! Загружает HEX-файл. Файл отображается в память (madvise(MADV_SEQUENTIAL)) и разбирается прямо из отображения.
+//! Пайпы и прочее, что не отображается, вычитываются через read(). numThreads!=1 - параллельный разбор (0 - по числу ядер)
+inline
+ParsingResult loadIntelHexFile( IntelHexParser &parser
+                              , std::vector<HexEntry> &resVec
+                              , const std::string &fileName
+                              , ParsingOptions parsingOptions = ParsingOptions::none
+                              , std::size_t *pErrorOffset=0
+                              , std::size_t numThreads=1
+                              )
+{
+    MappedFile mappedFile;
+    if (!mappedFile.open(fileName))
+    {
+        if (pErrorOffset)
+            *pErrorOffset = 0;
+        return ParsingResult::fileReadError;
+    }
+
+    return parseTextWithFinalLineEnd(parser, resVec, mappedFile.data(), mappedFile.size(), parsingOptions, pErrorOffset, numThreads);
+}
+
+//------------------------------
+//! Ленивая загрузка - отображение файла переходит во владение таблицы, данные записей декодируются из него по запросу
+inline
+ParsingResult loadIntelHexFile( IntelHexParser &parser
+                              , HexLazyRecordTable &recordTable
+                              , const std::string &fileName
+                              , ParsingOptions parsingOptions = ParsingOptions::none
+                              , std::size_t *pErrorOffset=0
+                              )
+{
+    MappedFile mappedFile;
+    if (!mappedFile.open(fileName))
+    {
+        if (pErrorOffset)
+            *pErrorOffset = 0;
+        return ParsingResult::fileReadError;
+    }
+
+    const char*       pData = mappedFile.data();
+    const std::size_t size  = mappedFile.size();
+    recordTable.setText(std::move(mappedFile)); // Перемещение не трогает отображение, pData остаётся валидным
+
+    std::size_t errorOffset = 0;
+    ParsingResult res = parser.parseTextChunk(recordTable, pData, size, 0, parsingOptions, &errorOffset);
+
+    if ( size!=0 && errorOffset==size
+      && pData[size-1]!='\r' && pData[size-1]!='\n'
+       )
+    {
+        // Через шаблонный приёмник - перегрузка для таблицы переключила бы её текст на finalLineEnd
+        static const char finalLineEnd[] = "\n";
+        const std::size_t numErrors = parser.parsingErrors.size();
+        res = parser.parseTextChunk<HexLazyRecordTable&>(recordTable, finalLineEnd, 1, 0, parsingOptions, &errorOffset);
+        errorOffset += size;
+        for(std::size_t i=numErrors; i!=parser.parsingErrors.size(); ++i)
+            parser.parsingErrors[i].offset += size;
+    }
+
+    if (pErrorOffset)
+        *pErrorOffset = errorOffset;
+
+    return res;
+}
+
+//------------------------------
+inline
+ParsingResult loadIntelHexFile( std::vector<HexEntry> &resVec
+                              , const std::string &fileName
+                              , ParsingOptions parsingOptions = ParsingOptions::none
+                              , std::size_t *pErrorOffset=0
+                              , std::size_t fileId=std::size_t(-1)
+                              , HexInfo *pHexInfo=0
+                              , ParsingErrorsReport *pParsingErrors=0 // Для ParsingOptions::collectErrors
+                              )
+{
+    IntelHexParser parser;
+    parser.setFileId(fileId);
+    ParsingResult res = loadIntelHexFile(parser, resVec, fileName, parsingOptions, pErrorOffset);
+    if (pHexInfo)
+        *pHexInfo = parser.hexInfo;
+    if (pParsingErrors)
+        *pParsingErrors = std::move(parser.parsingErrors);
+    return res;
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/intel_hex_loader.h
+
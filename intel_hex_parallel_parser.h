@@ -0,0 +1,238 @@
+/*! \file
+    \brief Multi-threaded Intel HEX text parsing
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "enums.h"
+#include "file_pos_info.h"
+#include "hex_entry.h"
+#include "hex_info.h"
+#include "intel_hex_parser.h"
+#include "parallel_utils.h"
+
+//----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/intel_hex_parallel_parser.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Текст режется на куски (slices) по границам строк, куски разбираются независимыми экземплярами
+    IntelHexParser, без проверки режимов адресации (trackHexInfo=false). Потом по кускам по порядку
+    прогоняется состояние: номер строки и HexInfo (через адресные записи куска, их единицы).
+    Номера строк в записях правятся параллельно.
+
+    Если кусок разобрался "нечисто" (ошибка, досрочный выход по EOF, Ctrl+Z, кусок закончился не в начале строки,
+    ошибка режима адресации при прогоне HexInfo), то с начала этого куска и до конца текста разбор
+    продолжается последовательно основным парсером - так результат, код возврата и смещение ошибки
+    всегда совпадают с однопоточным разбором.
+ */
+
+//----------------------------------------------------------------------------
+//! Минимальный размер куска, меньше которого текст на потоки не режем
+constexpr const std::size_t parallelParsingMinSliceSize = 256u*1024u;
+
+//----------------------------------------------------------------------------
+//! Режет текст на numSlices кусков по границам строк (после '\n'). Возвращает начала кусков, последний элемент - size
+inline
+std::vector<std::size_t> splitTextAtLineBoundaries(const char* pData, std::size_t size, std::size_t numSlices)
+{
+    std::vector<std::size_t> bounds;
+    bounds.reserve(numSlices+1u);
+    bounds.emplace_back(0u);
+
+    for(std::size_t i=1; i<numSlices; ++i)
+    {
+        std::size_t pos = std::size_t((unsigned long long)size*i/numSlices);
+        if (pos<bounds.back())
+            pos = bounds.back();
+
+        const void *pLf = std::memchr(pData+pos, '\n', size-pos);
+        if (!pLf)
+            break;
+
+        pos = std::size_t((const char*)pLf-pData) + 1u;
+        if (pos>=size)
+            break;
+
+        if (pos!=bounds.back())
+            bounds.emplace_back(pos);
+    }
+
+    bounds.emplace_back(size);
+    return bounds;
+}
+
+//----------------------------------------------------------------------------
+//! Параллельный разбор текста целиком. Результат такой же, как у parser.parseTextChunk(resVec, pData, size, 0, parsingOptions, pErrorOffset),
+//! включая конечное состояние parser (filePosInfo, hexInfo). parser должен стоять в начале строки, иначе разбор идёт в один поток
+inline
+ParsingResult parseTextChunkParallel( IntelHexParser &parser
+                                    , std::vector<HexEntry> &resVec
+                                    , const char* pData     // ptr to text chunk start
+                                    , std::size_t size      // text chunk size
+                                    , std::size_t numThreads = 0 // 0 - по числу ядер
+                                    , ParsingOptions parsingOptions = ParsingOptions::none
+                                    , std::size_t *pErrorOffset=0
+                                    )
+{
+    if (!numThreads)
+        numThreads = utils::getHardwareThreadsCount();
+
+    std::size_t numSlices = numThreads;
+    if (numSlices>size/parallelParsingMinSliceSize)
+        numSlices = size/parallelParsingMinSliceSize;
+
+    // Сбор ошибок (collectErrors) - только в один поток: смещения и позиции ошибок в кусках пришлось бы пересчитывать
+    if (!pData || numSlices<2 || !parser.isAtLineStart() || !parser.trackHexInfo || (parsingOptions&ParsingOptions::collectErrors)!=0)
+        return parser.parseTextChunk(resVec, pData, size, 0, parsingOptions, pErrorOffset);
+
+    const std::vector<std::size_t> bounds = splitTextAtLineBoundaries(pData, size, numSlices);
+    numSlices = bounds.size()-1u;
+    if (numSlices<2) // Нет переводов строк '\n', резать не по чем
+        return parser.parseTextChunk(resVec, pData, size, 0, parsingOptions, pErrorOffset);
+
+    struct SliceResult
+    {
+        IntelHexParser             parser;
+        std::vector<HexEntry>      entries;
+        std::vector<std::size_t>   addressEntries; // Индексы записей, влияющих на HexInfo
+        ParsingResult              res       = ParsingResult::ok;
+        std::size_t                endOffset = 0;
+        std::size_t                lineBase  = 0;
+    };
+
+    std::vector<SliceResult> slices(numSlices);
+
+    utils::parallelFor(numSlices, numThreads, [&](std::size_t sliceIdx)
+    {
+        SliceResult &slice = slices[sliceIdx];
+        slice.parser.trackHexInfo = false;
+        slice.parser.setFileId(parser.filePosInfo.file);
+
+        const std::size_t sliceSize = bounds[sliceIdx+1]-bounds[sliceIdx];
+        slice.entries.reserve(IntelHexParser::estimateRecordsCount(pData+bounds[sliceIdx], sliceSize));
+        slice.endOffset = std::size_t(-1);
+        slice.res = slice.parser.parseTextChunk(slice.entries, pData+bounds[sliceIdx], sliceSize, 0, parsingOptions, &slice.endOffset);
+
+        for(std::size_t i=0; i!=slice.entries.size(); ++i)
+        {
+            if (slice.entries[i].recordType!=HexRecordType::data && slice.entries[i].recordType!=HexRecordType::eof)
+                slice.addressEntries.emplace_back(i);
+        }
+    });
+
+    // Последовательно прогоняем состояние по кускам, пока они разобраны чисто
+    const bool allowMultiHex = (parsingOptions&ParsingOptions::allowMultiHex)!=0;
+    std::size_t numCleanSlices = 0;
+
+    for(; numCleanSlices!=numSlices; ++numCleanSlices)
+    {
+        SliceResult &slice = slices[numCleanSlices];
+        const std::size_t sliceSize = bounds[numCleanSlices+1]-bounds[numCleanSlices];
+        const bool lastSlice = numCleanSlices+1u==numSlices;
+
+        if (slice.endOffset!=sliceSize)
+            break;
+
+        if (slice.res!=ParsingResult::ok && slice.res!=ParsingResult::unexpectedEnd)
+            break;
+
+        if (!lastSlice && !slice.parser.isAtLineStart())
+            break;
+
+        // Пустая запись ':' после EOF без allowMultiHex завершает разбор - это кусок сам знать не мог
+        if (parser.getCurEntry().isEof() && !allowMultiHex)
+            break;
+
+        HexInfo hexInfo = parser.hexInfo;
+        bool hexInfoOk = true;
+        for(auto entryIdx : slice.addressEntries)
+        {
+            ParsingResult r = ParsingResult::ok;
+            if (!slice.entries[entryIdx].updateHexInfo(r, hexInfo))
+            {
+                hexInfoOk = false;
+                break;
+            }
+        }
+
+        if (!hexInfoOk)
+            break;
+
+        parser.hexInfo = hexInfo;
+        slice.lineBase = parser.filePosInfo.line;
+        parser.appendSliceState(slice.parser);
+    }
+
+    // Сшиваем результаты чисто разобранных кусков, заодно правим номера строк
+    std::vector<std::size_t> outOffsets(numCleanSlices+1u, resVec.size());
+    for(std::size_t i=0; i!=numCleanSlices; ++i)
+        outOffsets[i+1] = outOffsets[i] + slices[i].entries.size();
+
+    resVec.resize(outOffsets[numCleanSlices]);
+
+    utils::parallelFor(numCleanSlices, numThreads, [&](std::size_t sliceIdx)
+    {
+        SliceResult &slice = slices[sliceIdx];
+        std::size_t outIdx = outOffsets[sliceIdx];
+        for(auto &he : slice.entries)
+        {
+            he.filePosInfo.line += slice.lineBase;
+            resVec[outIdx++] = std::move(he);
+        }
+
+        slice.entries.clear();
+        slice.entries.shrink_to_fit();
+    });
+
+    if (numCleanSlices!=numSlices)
+    {
+        // Остаток разбираем последовательно, с правильным состоянием
+        return parser.parseTextChunk(resVec, pData, size, bounds[numCleanSlices], parsingOptions, pErrorOffset);
+    }
+
+    if (pErrorOffset)
+        *pErrorOffset = size;
+
+    return parser.getCurEntry().isEof() ? ParsingResult::ok : ParsingResult::unexpectedEnd;
+}
+
+//------------------------------
+inline
+ParsingResult parseTextChunkParallel( IntelHexParser &parser
+                                    , std::vector<HexEntry> &resVec
+                                    , const std::string &hexText
+                                    , std::size_t numThreads = 0
+                                    , ParsingOptions parsingOptions = ParsingOptions::none
+                                    , std::size_t *pErrorOffset=0
+                                    )
+{
+    return parseTextChunkParallel(parser, resVec, hexText.data(), hexText.size(), numThreads, parsingOptions, pErrorOffset);
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/intel_hex_parallel_parser.h
+
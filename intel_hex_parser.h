@@ -7,7 +7,11 @@
 //----------------------------------------------------------------------------
 #include "enums.h"
 #include "file_pos_info.h"
+#include "hex_decode.h"
 #include "hex_entry.h"
+#include "hex_lazy_record_table.h"
+#include "hex_record_ref.h"
+#include "hex_record_table.h"
 #include "memory_fill_map.h"
 #include "types.h"
 #include "utils.h"
@@ -15,9 +19,11 @@
 //----------------------------------------------------------------------------
 #include <string>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <exception>
 #include <stdexcept>
+#include <utility>
 
 //----------------------------------------------------------------------------
 
@@ -31,6 +37,18 @@ namespace hex{
 
 
 
+//----------------------------------------------------------------------------
+//! Ошибка, найденная при разборе в режиме ParsingOptions::collectErrors
+struct ParsingErrorEntry
+{
+    ParsingResult     result = ParsingResult::ok;
+    FilePosInfo       filePosInfo;
+    std::size_t       offset = 0; //!< Смещение символа, на котором обнаружена ошибка, от начала pData куска
+
+}; // struct ParsingErrorEntry
+
+using ParsingErrorsReport = std::vector<ParsingErrorEntry>;
+
 //----------------------------------------------------------------------------
 class IntelHexParser
 {
@@ -41,12 +59,21 @@ class IntelHexParser
         skipCommentLine   ,
         waitLf            ,
         waitFirstTetrad   ,
-        waitSecondTetrad
+        waitSecondTetrad  ,
+        waitResync          // После ошибки (collectErrors) - пропускаем всё до ':' или перевода строки
     };
 
     State st = waitStart;
     HexEntry curEntry;
 
+    // Заголовок записи (LL AAAA TT) копим отдельно, а в curEntry.data сразу пишем данные и КС -
+    // так после разбора строки данные уже лежат на своём месте, ничего не надо сдвигать
+    std::uint8_t recordHeader[HexEntry::recordHeaderSize] = { 0 };
+    std::size_t  recordHeaderBytes = 0;
+    std::uint8_t recordBytesSum    = 0; // Сумма всех байт текущей записи - для проверки КС без повторного прохода
+    std::size_t  recordTextOffset  = std::size_t(-1); // Смещение ':' текущей записи в pData того куска, где запись началась
+    HexRecordType lastEmittedType  = HexRecordType::invalid; // Тип последней выданной записи - parseRawRecord портит тип в curEntry и при ошибке
+
 
 public:
 
@@ -56,16 +83,32 @@ public:
     FilePosInfo filePosInfo;
     HexInfo     hexInfo;
 
+    // Если false, режимы адресации не проверяются и hexInfo не заполняется - это делается потом,
+    // по уже разобранным записям (HexEntry::updateHexInfo). Нужно для параллельного разбора
+    bool        trackHexInfo = true;
+
+    // Режим ParsingOptions::collectErrors - ошибки не прерывают разбор, а складываются сюда.
+    // В отчёт попадает не больше maxParsingErrors ошибок, parsingErrorsCount - сколько их было всего
+    ParsingErrorsReport parsingErrors;
+    std::size_t         maxParsingErrors   = 1000;
+    std::size_t         parsingErrorsCount = 0;
+
 
     const HexEntry& getCurEntry() const { return curEntry; }
 
     void reset()
     {
         curEntry.reset();
+        recordHeaderBytes = 0;
+        recordBytesSum    = 0;
+        recordTextOffset  = std::size_t(-1);
+        lastEmittedType   = HexRecordType::invalid;
         filePosInfo.line = 0;
         filePosInfo.pos  = 0;
         st = waitStart;
         hexInfo = HexInfo();
+        parsingErrors.clear();
+        parsingErrorsCount = 0;
     }
 
     void setFileId(std::size_t fileId)
@@ -75,6 +118,184 @@ public:
 
     void clear() { reset(); }
 
+    //! Парсер стоит в начале строки - отсюда можно продолжить разбор другим экземпляром парсера
+    bool isAtLineStart() const { return st==waitStart; }
+
+    //! Переносит к себе конечное состояние парсера, который разбирал следующий (после нашего) кусок текста.
+    //! Тот парсер должен был начинать с начала строки и с чистого состояния. hexInfo не трогаем -
+    //! его надо обновить по разобранным записям отдельно
+    void appendSliceState(const IntelHexParser &sliceParser)
+    {
+        if (sliceParser.filePosInfo.line==0)
+        {
+            filePosInfo.pos  += sliceParser.filePosInfo.pos;
+        }
+        else
+        {
+            filePosInfo.line += sliceParser.filePosInfo.line;
+            filePosInfo.pos   = sliceParser.filePosInfo.pos;
+        }
+
+        st = sliceParser.st;
+
+        // Тип последней записи нужен для проверки на EOF; если в куске записей не было, оставляем свой
+        HexRecordType lastRecordType = curEntry.recordType;
+        if (sliceParser.curEntry.recordType!=HexRecordType::invalid)
+            lastRecordType = sliceParser.curEntry.recordType;
+
+        curEntry = sliceParser.curEntry; // Там может быть недочитанная запись в конце куска
+        curEntry.recordType = lastRecordType;
+        lastEmittedType = lastRecordType;
+
+        recordHeaderBytes = sliceParser.recordHeaderBytes;
+        recordBytesSum    = sliceParser.recordBytesSum;
+        recordTextOffset  = std::size_t(-1); // Смещение было от начала куска, не нашего текста
+        for(std::size_t i=0; i!=recordHeaderBytes; ++i)
+            recordHeader[i] = sliceParser.recordHeader[i];
+    }
+
+
+protected:
+
+    //! Быстрый путь: если после двоеточия вся строка до перевода строки состоит из пар hex-цифр
+    //! и целиком лежит в текущем куске, декодируем её за один раз, и встаём на символ перевода строки.
+    //! Иначе (пробелы, мусор, нечётное число цифр, строка обрезана краем куска) возвращаем false,
+    //! и строку разбирает обычный автомат - так коды ошибок и позиции остаются прежними
+    bool decodeWholeLine(const char* pData, std::size_t size, std::size_t &idx)
+    {
+        const std::size_t digitsStart = idx+1;
+        const std::size_t numDigits   = utils::countHexDigits(pData+digitsStart, size-digitsStart);
+        const std::size_t eolIdx      = digitsStart+numDigits;
+
+        if (numDigits==0 || (numDigits&1u)!=0 || eolIdx>=size)
+            return false;
+
+        if (pData[eolIdx]!='\r' && pData[eolIdx]!='\n')
+            return false;
+
+        std::size_t numBytes = numDigits/2u;
+        const char* pDigits  = pData+digitsStart;
+
+        std::size_t numHeaderBytes = HexEntry::recordHeaderSize-recordHeaderBytes;
+        if (numHeaderBytes>numBytes)
+            numHeaderBytes = numBytes;
+        std::uint32_t bytesSum = utils::decodeHexPairsSum(pDigits, numHeaderBytes, &recordHeader[recordHeaderBytes]);
+        recordHeaderBytes += numHeaderBytes;
+        pDigits  += 2u*numHeaderBytes;
+        numBytes -= numHeaderBytes;
+
+        if (numBytes)
+        {
+            const std::size_t prevSize = curEntry.data.size();
+            curEntry.data.resize(prevSize+numBytes);
+            bytesSum += utils::decodeHexPairsSum(pDigits, numBytes, &curEntry.data[prevSize]);
+        }
+
+        recordBytesSum = std::uint8_t(recordBytesSum+bytesSum);
+
+        filePosInfo.pos += numDigits;
+        idx = eolIdx;
+        return true;
+    }
+
+
+    void appendRecordByte(std::uint8_t b)
+    {
+        recordBytesSum = std::uint8_t(recordBytesSum+b);
+        if (recordHeaderBytes<HexEntry::recordHeaderSize)
+            recordHeader[recordHeaderBytes++] = b;
+        else
+            curEntry.appendDataByte(b);
+    }
+
+    //! В текущей строке были байты записи
+    bool hasRecordBytes() const
+    {
+        return recordHeaderBytes!=0 || !curEntry.empty();
+    }
+
+    //! Разбирает накопленные байты текущей записи
+    bool parseCurEntry(ParsingResult &r)
+    {
+        return curEntry.parseRawRecord(r, trackHexInfo ? &hexInfo : 0, recordHeader, recordHeaderBytes, recordBytesSum);
+    }
+
+    //! Отдаёт текущую (полностью разобранную) запись приёмнику и очищает её
+    template<typename RecordSink>
+    void emitCurEntry(RecordSink &sink)
+    {
+        curEntry.filePosInfo = filePosInfo;
+        HexRecordRef rec = HexRecordRef(curEntry);
+        rec.textOffset = recordTextOffset;
+        sink(rec);
+        lastEmittedType = curEntry.recordType;
+        curEntry.clear();
+        recordHeaderBytes = 0;
+        recordBytesSum    = 0;
+        recordTextOffset  = std::size_t(-1);
+    }
+
+    //! Запоминает ошибку и выбрасывает недоразобранную запись - дальше ждём начала следующей
+    void collectError(ParsingResult r, std::size_t offset)
+    {
+        if (parsingErrors.size()<maxParsingErrors)
+        {
+            ParsingErrorEntry e;
+            e.result      = r;
+            e.filePosInfo = filePosInfo;
+            e.offset      = offset;
+            parsingErrors.emplace_back(e);
+        }
+
+        ++parsingErrorsCount;
+
+        // Тип последней удачной записи нужен для проверки на EOF
+        curEntry.clear();
+        curEntry.recordType = lastEmittedType;
+        recordHeaderBytes = 0;
+        recordBytesSum    = 0;
+        recordTextOffset  = std::size_t(-1);
+        st = waitResync;
+    }
+
+    //! Приёмник для старого API - забирает записи в вектор без копирования: curEntry после вызова приёмника
+    //! всё равно очищается (emitCurEntry), так что его данные просто переезжают в результат
+    static
+    auto makeVectorSink(std::vector<HexEntry> &resVec)
+    {
+        return [&resVec](const HexRecordRef &rec)
+        {
+            resVec.emplace_back(std::move(*rec.pEntry));
+        };
+    }
+
+
+public:
+
+
+    //! Оценка количества записей в тексте по длине первой строки - чтобы заранее зарезервировать место в векторе результата
+    static
+    std::size_t estimateRecordsCount(const char* pData, std::size_t size)
+    {
+        const std::size_t minLineLen  = 12u; // ":00000001FF\n"
+        const std::size_t maxScanSize = 1024u;
+        const std::size_t scanSize    = size<maxScanSize ? size : maxScanSize;
+
+        const char *pColon = (const char*)std::memchr(pData, ':', scanSize);
+        if (!pColon)
+            return 0;
+
+        const char *pLf = (const char*)std::memchr(pColon, '\n', scanSize-std::size_t(pColon-pData));
+        if (!pLf)
+            return 0;
+
+        std::size_t lineLen = std::size_t(pLf-pColon) + 1u;
+        if (lineLen<minLineLen)
+            lineLen = minLineLen;
+
+        return size/lineLen + 1u;
+    }
+
 
     bool moveIndexToNextLine(const std::string &hexText, std::size_t &idx) const
     {
@@ -108,7 +329,10 @@ public:
         return true;
     }
 
-    ParsingResult parseFinalize(std::vector<HexEntry> &resVec)
+    //! Приёмник (sink) - любой вызываемый объект вида void(const HexRecordRef&).
+    //! Вызывается на каждую разобранную запись, прямо из цикла разбора
+    template<typename RecordSink>
+    ParsingResult parseFinalize(RecordSink &&sink)
     {
         switch(st)
         {
@@ -122,38 +346,43 @@ public:
                  return curEntry.isEof() ? ParsingResult::ok : ParsingResult::unexpectedEnd;
 
             case waitFirstTetrad :
-                 if (!curEntry.empty())
+                 if (hasRecordBytes())
                  {
                      ParsingResult parseRes = ParsingResult::ok;
-                     if (!curEntry.parseRawData(parseRes, &hexInfo)) // Если что-то пошло не так, то мы получим false и в parseRes код возврата, его и возвращаем
+                     if (!parseCurEntry(parseRes)) // Если что-то пошло не так, то мы получим false и в parseRes код возврата, его и возвращаем
                          return parseRes;
          
-                     curEntry.filePosInfo = filePosInfo;
-                     resVec.emplace_back(curEntry.makeFitCopy());
-                     curEntry.clear();
+                     emitCurEntry(sink);
                  }
                  //return ParsingResult::notDigit;
                  return ParsingResult::unexpectedEnd;
             
             case waitSecondTetrad:
-                 if (!curEntry.empty())
+                 if (hasRecordBytes())
                  {
                      ParsingResult parseRes = ParsingResult::ok;
-                     if (!curEntry.parseRawData(parseRes, &hexInfo)) // Если что-то пошло не так, то мы получим false и в parseRes код возврата, его и возвращаем
+                     if (!parseCurEntry(parseRes)) // Если что-то пошло не так, то мы получим false и в parseRes код возврата, его и возвращаем
                          return parseRes;
          
-                     curEntry.filePosInfo = filePosInfo;
-                     resVec.emplace_back(curEntry.makeFitCopy());
-                     curEntry.clear();
+                     emitCurEntry(sink);
                  }
                  return ParsingResult::brokenByte;
 
+            case waitResync      : // Ошибка уже в отчёте
+                 return curEntry.isEof() ? ParsingResult::ok : ParsingResult::unexpectedEnd;
+
             default:
                  return ParsingResult::invalidRecord;
         }
     }
 
 
+    ParsingResult parseFinalize(std::vector<HexEntry> &resVec)
+    {
+        return parseFinalize(makeVectorSink(resVec));
+    }
+
+
     ParsingResult parseTextChunk( std::vector<HexEntry> &resVec
                                 , const std::string &hexText
                                 , std::size_t startIdx = 0
@@ -161,7 +390,7 @@ public:
                                 , std::size_t *pErrorOffset=0
                                 )
     {
-        return parseTextChunk(resVec, hexText.data(), hexText.size(), startIdx, parsingOptions, pErrorOffset);
+        return parseTextChunk(makeVectorSink(resVec), hexText.data(), hexText.size(), startIdx, parsingOptions, pErrorOffset);
     }
 
     ParsingResult parseTextChunk( std::vector<HexEntry> &resVec
@@ -171,6 +400,84 @@ public:
                                 , ParsingOptions parsingOptions = ParsingOptions::none
                                 , std::size_t *pErrorOffset=0
                                 )
+    {
+        if (pData && startIdx<size)
+        {
+            // При разборе по кускам резервируем с запасом, чтобы не перевыделять память на каждом куске
+            const std::size_t numRecords = resVec.size()+estimateRecordsCount(pData+startIdx, size-startIdx);
+            if (resVec.capacity()<numRecords)
+                resVec.reserve(numRecords>2u*resVec.capacity() ? numRecords : 2u*resVec.capacity());
+        }
+
+        return parseTextChunk(makeVectorSink(resVec), pData, size, startIdx, parsingOptions, pErrorOffset);
+    }
+
+    //! Разбор прямо в таблицу записей. Перед разбором место в таблице резервируется по предварительному проходу по тексту
+    ParsingResult parseTextChunk( HexRecordTable &recordTable
+                                , const char* pData     // ptr to text chunk start
+                                , std::size_t size      // text chunk start
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        if (pData && startIdx<size)
+            recordTable.reserveForText(pData+startIdx, size-startIdx);
+
+        return parseTextChunk<HexRecordTable&>(recordTable, pData, size, startIdx, parsingOptions, pErrorOffset);
+    }
+
+    //! Ленивый разбор - записи проверяются полностью, но в таблицу попадают только заголовки и смещения в тексте,
+    //! данные таблица декодирует из pData по запросу. pData должен жить, пока живёт таблица.
+    //! Весь текст разбирается одним буфером - при разборе по частям передаётся тот же pData и startIdx
+    ParsingResult parseTextChunk( HexLazyRecordTable &recordTable
+                                , const char* pData     // ptr to text chunk start
+                                , std::size_t size      // text chunk start
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        if (pData && startIdx<size)
+            recordTable.reserveForText(pData+startIdx, size-startIdx);
+
+        recordTable.setText(pData, size);
+        recordTable.setCompactText((parsingOptions&ParsingOptions::allowSpaces)==0);
+
+        return parseTextChunk<HexLazyRecordTable&>(recordTable, pData, size, startIdx, parsingOptions, pErrorOffset);
+    }
+
+    ParsingResult parseTextChunk( HexRecordTable &recordTable
+                                , const std::string &hexText
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunk(recordTable, hexText.data(), hexText.size(), startIdx, parsingOptions, pErrorOffset);
+    }
+
+    template<typename RecordSink>
+    ParsingResult parseTextChunk( RecordSink &&sink
+                                , const std::string &hexText
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
+    {
+        return parseTextChunk(sink, hexText.data(), hexText.size(), startIdx, parsingOptions, pErrorOffset);
+    }
+
+    //! Разбор куска текста с выдачей записей в приёмник (sink) - void(const HexRecordRef&).
+    //! Ничего не аллоцирует на каждую запись, если этого не делает сам приёмник
+    template<typename RecordSink>
+    ParsingResult parseTextChunk( RecordSink &&sink
+                                , const char* pData     // ptr to text chunk start
+                                , std::size_t size      // text chunk start
+                                , std::size_t startIdx = 0
+                                , ParsingOptions parsingOptions = ParsingOptions::none
+                                , std::size_t *pErrorOffset=0
+                                )
     {
         std::size_t  idx     = startIdx;
         std::uint8_t curByte = 0;
@@ -178,6 +485,9 @@ public:
         bool allowComments = (parsingOptions&ParsingOptions::allowComments)!=0;
         bool allowSpaces   = (parsingOptions&ParsingOptions::allowSpaces  )!=0;
         bool allowMultiHex = (parsingOptions&ParsingOptions::allowMultiHex)!=0;
+        bool collectErrors = (parsingOptions&ParsingOptions::collectErrors)!=0;
+
+        ParsingResult errorResult = ParsingResult::ok;
 
         auto returnError = [&](ParsingResult e)
         {
@@ -202,8 +512,14 @@ public:
                 {
                     if (ch==':')
                     {
+                       recordTextOffset = idx;
                        ++filePosInfo.pos;
                        st = waitFirstTetrad;
+                       if (decodeWholeLine(pData, size, idx))
+                       {
+                           ch = pData[idx];
+                           goto explicit_waitFirstTetrad; // Обрабатываем перевод строки как обычно
+                       }
                        break;
                     }
 
@@ -220,7 +536,10 @@ public:
                     else if (ch==' ')
                     {
                         if (!allowSpaces)
-                            return returnError(ParsingResult::unexpectedSpace);
+                        {
+                            errorResult = ParsingResult::unexpectedSpace;
+                            goto explicit_parsingError;
+                        }
                         ++filePosInfo.pos;
                         break;
                     }
@@ -244,7 +563,8 @@ public:
                          return returnError(curEntry.isEof() ? ParsingResult::ok : ParsingResult::unexpectedEnd );
                     }
 
-                    return returnError(ParsingResult::invalidRecord); // Что-то непонятное пришло
+                    errorResult = ParsingResult::invalidRecord; // Что-то непонятное пришло
+                    goto explicit_parsingError;
                 }
     
                 case skipCommentLine:
@@ -290,12 +610,16 @@ public:
                     goto explicit_waitStart;
                 }
     
+                explicit_waitFirstTetrad:
                 case waitFirstTetrad:
                 {
                     if (ch==' ')
                     {
                         if (!allowSpaces)
-                            return returnError(ParsingResult::unexpectedSpace);
+                        {
+                            errorResult = ParsingResult::unexpectedSpace;
+                            goto explicit_parsingError;
+                        }
                         ++filePosInfo.pos;
                         break;
                     }
@@ -303,15 +627,16 @@ public:
                     else if (ch=='\r')
                     {
                         // process entry here
-                        if (!curEntry.empty())
+                        if (hasRecordBytes())
                         {
                             ParsingResult parseRes = ParsingResult::ok;
-                            if (!curEntry.parseRawData(parseRes, &hexInfo)) // Если что-то пошло не так, то мы получим false и в parseRes код возврата, его и возвращаем
-                                return returnError(parseRes);
+                            if (!parseCurEntry(parseRes)) // Если что-то пошло не так, то мы получим false и в parseRes код возврата, его и возвращаем
+                            {
+                                errorResult = parseRes;
+                                goto explicit_parsingError;
+                            }
     
-                            curEntry.filePosInfo = filePosInfo;
-                            resVec.emplace_back(curEntry.makeFitCopy());
-                            curEntry.clear();
+                            emitCurEntry(sink);
                         }
 
                         st = waitLf;
@@ -326,15 +651,16 @@ public:
                     else if (ch=='\n')
                     {
                         // process entry here
-                        if (!curEntry.empty())
+                        if (hasRecordBytes())
                         {
                             ParsingResult parseRes = ParsingResult::ok;
-                            if (!curEntry.parseRawData(parseRes, &hexInfo))
-                                return returnError(parseRes);
+                            if (!parseCurEntry(parseRes))
+                            {
+                                errorResult = parseRes;
+                                goto explicit_parsingError;
+                            }
     
-                            curEntry.filePosInfo = filePosInfo;
-                            resVec.emplace_back(curEntry.makeFitCopy());
-                            curEntry.clear();
+                            emitCurEntry(sink);
                         }
 
                         st = waitStart;
@@ -351,7 +677,10 @@ public:
                     {
                         int d = utils::charToDigit(ch);
                         if (d<0)
-                            return returnError(ParsingResult::notDigit); // Ждали цифру, пришла хрень
+                        {
+                            errorResult = ParsingResult::notDigit; // Ждали цифру, пришла хрень
+                            goto explicit_parsingError;
+                        }
                         curByte = (std::uint8_t)(unsigned)d;
                         st = waitSecondTetrad;
                         ++filePosInfo.pos;
@@ -366,22 +695,50 @@ public:
                     int d = utils::charToDigit(ch);
                     if (d<0) // Ждали цифру
                     {
-                        if (ch==' ' || ch=='\n' || ch=='\n')
-                            return returnError(ParsingResult::brokenByte); // поймали пробел
+                        if (ch==' ' || ch=='\r' || ch=='\n')
+                            errorResult = ParsingResult::brokenByte; // поймали пробел
                         else
-                            return returnError(ParsingResult::notDigit); // пришла хрень
+                            errorResult = ParsingResult::notDigit; // пришла хрень
+                        goto explicit_parsingError;
                     }
 
                     ++filePosInfo.pos;
                     curByte <<= 4;
                     curByte |= (std::uint8_t)(unsigned)d;
-                    curEntry.appendDataByte(curByte);
+                    appendRecordByte(curByte);
                     curByte = 0;
                     st = waitFirstTetrad;
                     break;
                 }
+
+                case waitResync:
+                {
+                    if (ch==':' || ch=='\r' || ch=='\n')
+                    {
+                        st = waitStart; // '\n' в waitStart состояние не меняет
+                        goto explicit_waitStart;
+                    }
+                    ++filePosInfo.pos;
+                    break;
+                }
     
             }
+
+            continue;
+
+        explicit_parsingError:
+            if (!collectErrors)
+                return returnError(errorResult);
+
+            collectError(errorResult, idx);
+
+            // Символ, на котором споткнулись, может начинать следующую запись или строку - разбираем его заново
+            if (ch==':' || ch=='\r' || ch=='\n')
+            {
+                st = waitStart;
+                goto explicit_waitStart;
+            }
+            ++filePosInfo.pos;
         
         }
     
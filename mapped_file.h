@@ -0,0 +1,278 @@
+/*! \file
+    \brief Read-only memory mapped file with fallback to buffered reading
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/mapped_file.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//! Файл, отображённый в память только для чтения. Если отобразить не получается (пайп, символьное
+//! устройство, ошибка mmap), файл вычитывается целиком через read() в собственный буфер
+class MappedFile
+{
+
+protected:
+
+    const char*         m_pData  = 0;
+    std::size_t         m_size   = 0;
+    bool                m_mapped = false;
+    std::vector<char>   m_buffer;
+
+#if defined(_WIN32)
+    HANDLE              m_hMapping = 0;
+#endif
+
+
+public:
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile &&other) { swap(other); }
+    MappedFile& operator=(MappedFile &&other)
+    {
+        if (this!=&other)
+        {
+            close();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~MappedFile() { close(); }
+
+    explicit MappedFile(const std::string &fileName) { open(fileName); }
+
+    void swap(MappedFile &other)
+    {
+        std::swap(m_pData , other.m_pData );
+        std::swap(m_size  , other.m_size  );
+        std::swap(m_mapped, other.m_mapped);
+        m_buffer.swap(other.m_buffer);
+    #if defined(_WIN32)
+        std::swap(m_hMapping, other.m_hMapping);
+    #endif
+    }
+
+    const char* data() const { return m_pData; }
+    std::size_t size() const { return m_size; }
+    bool empty()       const { return m_size==0; }
+    bool isMapped()    const { return m_mapped; }
+
+    const char* begin() const { return m_pData; }
+    const char* end()   const { return m_pData+m_size; }
+
+
+    void close()
+    {
+        if (m_mapped)
+        {
+        #if defined(_WIN32)
+            UnmapViewOfFile((LPCVOID)m_pData);
+            CloseHandle(m_hMapping);
+            m_hMapping = 0;
+        #else
+            munmap((void*)m_pData, m_size);
+        #endif
+        }
+
+        m_pData  = 0;
+        m_size   = 0;
+        m_mapped = false;
+        m_buffer.clear();
+        m_buffer.shrink_to_fit();
+    }
+
+
+#if defined(_WIN32)
+
+protected:
+
+    bool readAll(HANDLE hFile)
+    {
+        const std::size_t blockSize = 1024u*1024u;
+        std::size_t total = 0;
+        for(;;)
+        {
+            m_buffer.resize(total+blockSize);
+            DWORD numRead = 0;
+            if (!ReadFile(hFile, (LPVOID)(m_buffer.data()+total), (DWORD)blockSize, &numRead, 0))
+            {
+                if (GetLastError()==ERROR_BROKEN_PIPE) // Пишущий конец закрыт - это конец данных
+                    break;
+                m_buffer.clear();
+                return false;
+            }
+            if (!numRead)
+                break;
+            total += std::size_t(numRead);
+        }
+
+        m_buffer.resize(total);
+        m_pData = m_buffer.data();
+        m_size  = total;
+        return true;
+    }
+
+public:
+
+    bool open(const std::string &fileName)
+    {
+        close();
+
+        HANDLE hFile = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING
+                                  , FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, 0
+                                  );
+        if (hFile==INVALID_HANDLE_VALUE)
+            return false;
+
+        bool res = false;
+        LARGE_INTEGER fileSize;
+        if (GetFileType(hFile)==FILE_TYPE_DISK && GetFileSizeEx(hFile, &fileSize))
+        {
+            if (fileSize.QuadPart==0)
+            {
+                res = true;
+            }
+            else
+            {
+                m_hMapping = CreateFileMappingA(hFile, 0, PAGE_READONLY, 0, 0, 0);
+                if (m_hMapping)
+                {
+                    m_pData = (const char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+                    if (m_pData)
+                    {
+                        m_size   = std::size_t(fileSize.QuadPart);
+                        m_mapped = true;
+                        res      = true;
+                    }
+                    else
+                    {
+                        CloseHandle(m_hMapping);
+                        m_hMapping = 0;
+                    }
+                }
+            }
+        }
+
+        if (!res)
+            res = readAll(hFile);
+
+        CloseHandle(hFile);
+        return res;
+    }
+
+#else
+
+protected:
+
+    bool readAll(int fd)
+    {
+        const std::size_t blockSize = 1024u*1024u;
+        std::size_t total = 0;
+        for(;;)
+        {
+            m_buffer.resize(total+blockSize);
+            ssize_t numRead = ::read(fd, m_buffer.data()+total, blockSize);
+            if (numRead<0)
+            {
+                if (errno==EINTR)
+                    continue;
+                m_buffer.clear();
+                return false;
+            }
+            if (numRead==0)
+                break;
+            total += std::size_t(numRead);
+        }
+
+        m_buffer.resize(total);
+        m_pData = m_buffer.data();
+        m_size  = total;
+        return true;
+    }
+
+public:
+
+    bool open(const std::string &fileName)
+    {
+        close();
+
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd<0)
+            return false;
+
+        bool res = false;
+        struct stat st;
+        if (::fstat(fd, &st)==0 && S_ISREG(st.st_mode))
+        {
+            if (st.st_size==0)
+            {
+                res = true; // mmap нулевой длины не делается
+            }
+            else
+            {
+                void *p = ::mmap(0, std::size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p!=MAP_FAILED)
+                {
+                #if defined(MADV_SEQUENTIAL)
+                    ::madvise(p, std::size_t(st.st_size), MADV_SEQUENTIAL);
+                #endif
+                    m_pData  = (const char*)p;
+                    m_size   = std::size_t(st.st_size);
+                    m_mapped = true;
+                    res      = true;
+                }
+            }
+        }
+
+        if (!res) // Пайпы, устройства, или mmap не удался
+            res = readAll(fd);
+
+        ::close(fd);
+        return res;
+    }
+
+#endif
+
+}; // class MappedFile
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/mapped_file.h
+
@@ -5,17 +5,36 @@
 #pragma once
 
 //----------------------------------------------------------------------------
+#include "binary_to_hex.h"
 #include "enums.h"
 #include "file_pos_info.h"
+#include "hex_address_lookup.h"
+#include "hex_decode.h"
+#include "hex_dump_parser.h"
 #include "hex_entry.h"
+#include "hex_file_index.h"
+#include "hex_lazy_record_table.h"
+#include "hex_record_ref.h"
+#include "hex_record_table.h"
+#include "hex_record_view.h"
+#include "hex_to_binary.h"
+#include "hex_writer.h"
+#include "intel_hex_loader.h"
 #include "intel_hex_parser.h"
+#include "intel_hex_parallel_parser.h"
+#include "mapped_file.h"
+#include "memory_image.h"
 #include "memory_fill_map.h"
+#include "parallel_utils.h"
+#include "small_byte_vector.h"
 #include "types.h"
 #include "utils.h"
 
 //----------------------------------------------------------------------------
+#include <algorithm>
 #include <string>
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <exception>
 #include <stdexcept>
@@ -34,16 +53,27 @@ namespace hex{
 
 //----------------------------------------------------------------------------
 
-// Заодно обновляем поле адрес address значением ULBA/USBA. А надо ли? Наверное, не надо
-inline
-void updateHexEntriesAddressAndMode(std::vector<HexEntry> &heVec)
+//! Состояние, которое протаскивается по записям при обновлении адресов и режима адресации
+struct HexEntriesAddressState
 {
-    std::uint16_t curBaseAddr = 0;
-    std::uint32_t nextAddr    = 0;
+    std::uint16_t baseAddress = 0;
+    std::uint32_t nextAddress = 0;
     AddressMode   addressMode = AddressMode::none;
 
-    for(auto &he : heVec)
+}; // struct HexEntriesAddressState
+
+// Заодно обновляем поле адрес address значением ULBA/USBA. А надо ли? Наверное, не надо
+template<typename IteratorType>
+HexEntriesAddressState updateHexEntriesAddressAndMode(IteratorType b, IteratorType e, HexEntriesAddressState state)
+{
+    std::uint16_t curBaseAddr = state.baseAddress;
+    std::uint32_t nextAddr    = state.nextAddress;
+    AddressMode   addressMode = state.addressMode;
+
+    for(; b!=e; ++b)
     {
+        HexEntry &he = *b;
+
         he.addressMode = addressMode;
         he.baseAddress = curBaseAddr;
         if (he.recordType!=HexRecordType::data)
@@ -83,6 +113,97 @@ void updateHexEntriesAddressAndMode(std::vector<HexEntry> &heVec)
         }
 
     }
+
+    state.baseAddress = curBaseAddr;
+    state.nextAddress = nextAddr;
+    state.addressMode = addressMode;
+    return state;
+}
+
+//------------------------------
+inline
+void updateHexEntriesAddressAndMode(std::vector<HexEntry> &heVec)
+{
+    updateHexEntriesAddressAndMode(heVec.begin(), heVec.end(), HexEntriesAddressState());
+}
+
+//------------------------------
+//! Параллельная версия. Записи режутся на куски, по каждому куску параллельно считается его итог
+//! (последняя базовая запись и последняя запись данных - от входного состояния они не зависят),
+//! потом итоги последовательно сворачиваются в начальные состояния кусков (префиксный скан),
+//! и куски обновляются параллельно. Результат совпадает с однопоточной версией
+inline
+void updateHexEntriesAddressAndModeParallel(std::vector<HexEntry> &heVec, std::size_t numThreads=0)
+{
+    if (!numThreads)
+        numThreads = utils::getHardwareThreadsCount();
+
+    const std::size_t minSliceSize = 16384u;
+    std::size_t numSlices = numThreads;
+    if (numSlices>heVec.size()/minSliceSize)
+        numSlices = heVec.size()/minSliceSize;
+
+    if (numSlices<2)
+    {
+        updateHexEntriesAddressAndMode(heVec);
+        return;
+    }
+
+    struct SliceSummary
+    {
+        bool                   hasBase = false;
+        bool                   hasData = false;
+        HexEntriesAddressState state;  // Что задаёт сам кусок
+        HexEntriesAddressState input;  // Состояние на входе в кусок
+    };
+
+    std::vector<SliceSummary> summaries(numSlices);
+    auto sliceBegin = [&](std::size_t sliceIdx) { return heVec.size()*sliceIdx/numSlices; };
+
+    utils::parallelFor(numSlices, numThreads, [&](std::size_t sliceIdx)
+    {
+        SliceSummary &summary = summaries[sliceIdx];
+        const std::size_t b = sliceBegin(sliceIdx);
+        std::size_t idx = sliceBegin(sliceIdx+1);
+
+        // Идём с конца - ищем последнюю базовую запись и последнюю запись данных
+        while(idx!=b && (!summary.hasBase || !summary.hasData))
+        {
+            const HexEntry &he = heVec[--idx];
+            if (!summary.hasData && he.recordType==HexRecordType::data)
+            {
+                summary.hasData = true;
+                summary.state.nextAddress = he.address + std::uint32_t(he.data.size());
+            }
+            else if (!summary.hasBase && he.isBaseAddressEntry())
+            {
+                summary.hasBase = true;
+                summary.state.addressMode = he.recordType==HexRecordType::extendedSegmentAddress ? AddressMode::sba : AddressMode::lba;
+                summary.state.baseAddress = he.extractBaseAddressFromDataBytes();
+            }
+        }
+    });
+
+    HexEntriesAddressState state;
+    for(auto &summary : summaries)
+    {
+        summary.input = state;
+        if (summary.hasBase)
+        {
+            state.baseAddress = summary.state.baseAddress;
+            state.addressMode = summary.state.addressMode;
+        }
+        if (summary.hasData)
+            state.nextAddress = summary.state.nextAddress;
+    }
+
+    utils::parallelFor(numSlices, numThreads, [&](std::size_t sliceIdx)
+    {
+        updateHexEntriesAddressAndMode( heVec.begin()+std::ptrdiff_t(sliceBegin(sliceIdx))
+                                      , heVec.begin()+std::ptrdiff_t(sliceBegin(sliceIdx+1))
+                                      , summaries[sliceIdx].input
+                                      );
+    });
 }
 
 //----------------------------------------------------------------------------
@@ -100,9 +221,46 @@ struct HexRecordsCheckResultEntry
 
 using HexRecordsCheckReport = std::vector<HexRecordsCheckResultEntry>;
 
+//----------------------------------------------------------------------------
+// Доступ к записям - чтобы проверку и прочее можно было писать одинаково для вектора HexEntry и для HexRecordTable
 
-inline
-HexRecordsCheckCode checkHexRecords(const std::vector<HexEntry> &heVec, MemoryFillMap *pMemMap, HexRecordsCheckReport *pReport)
+inline std::size_t   getHexRecordsCount         (const std::vector<HexEntry> &heVec) { return heVec.size(); }
+inline HexRecordType getHexRecordType           (const std::vector<HexEntry> &heVec, std::size_t idx) { return heVec[idx].recordType; }
+inline std::size_t   getHexRecordDataSize       (const std::vector<HexEntry> &heVec, std::size_t idx) { return heVec[idx].data.size(); }
+inline FilePosInfo   getHexRecordFilePosInfo    (const std::vector<HexEntry> &heVec, std::size_t idx) { return heVec[idx].filePosInfo; }
+inline const std::uint8_t* getHexRecordData     (const std::vector<HexEntry> &heVec, std::size_t idx) { return heVec[idx].data.data(); }
+inline std::uint32_t getHexRecordDataByteAddress(const std::vector<HexEntry> &heVec, std::size_t idx, std::size_t byteIndex) { return heVec[idx].getDataByteAddress(byteIndex); }
+
+template<typename SegmentHandler>
+void forEachHexRecordDataSegment(const std::vector<HexEntry> &heVec, std::size_t idx, SegmentHandler fn) { heVec[idx].forEachDataSegment(fn); }
+
+//------------------------------
+inline std::size_t   getHexRecordsCount         (const HexRecordTable &tbl) { return tbl.size(); }
+inline HexRecordType getHexRecordType           (const HexRecordTable &tbl, std::size_t idx) { return tbl.getRecordType(idx); }
+inline std::size_t   getHexRecordDataSize       (const HexRecordTable &tbl, std::size_t idx) { return tbl.getDataSize(idx); }
+inline FilePosInfo   getHexRecordFilePosInfo    (const HexRecordTable &tbl, std::size_t idx) { return tbl.getFilePosInfo(idx); }
+inline const std::uint8_t* getHexRecordData     (const HexRecordTable &tbl, std::size_t idx) { return tbl.getData(idx); }
+inline std::uint32_t getHexRecordDataByteAddress(const HexRecordTable &tbl, std::size_t idx, std::size_t byteIndex) { return tbl.getDataByteAddress(idx, byteIndex); }
+
+template<typename SegmentHandler>
+void forEachHexRecordDataSegment(const HexRecordTable &tbl, std::size_t idx, SegmentHandler fn) { tbl.forEachDataSegment(idx, fn); }
+
+//------------------------------
+// Для ленивой таблицы getHexRecordData нет - данных в памяти у неё нет. Проверка записей (checkHexRecords) с ней работает,
+// а то, что сравнивает или выгружает данные (findHexRecordsOverlaps, экспорт) - нет, там нужна обычная таблица или вектор HexEntry
+inline std::size_t   getHexRecordsCount         (const HexLazyRecordTable &tbl) { return tbl.size(); }
+inline HexRecordType getHexRecordType           (const HexLazyRecordTable &tbl, std::size_t idx) { return tbl.getRecordType(idx); }
+inline std::size_t   getHexRecordDataSize       (const HexLazyRecordTable &tbl, std::size_t idx) { return tbl.getDataSize(idx); }
+inline FilePosInfo   getHexRecordFilePosInfo    (const HexLazyRecordTable &tbl, std::size_t idx) { return tbl.getFilePosInfo(idx); }
+inline std::uint32_t getHexRecordDataByteAddress(const HexLazyRecordTable &tbl, std::size_t idx, std::size_t byteIndex) { return tbl.getDataByteAddress(idx, byteIndex); }
+
+template<typename SegmentHandler>
+void forEachHexRecordDataSegment(const HexLazyRecordTable &tbl, std::size_t idx, SegmentHandler fn) { tbl.forEachDataSegment(idx, fn); }
+
+//----------------------------------------------------------------------------
+//! HexRecordsType - std::vector<HexEntry> или HexRecordTable (или что-то ещё с перегрузками getHexRecord*)
+template<typename HexRecordsType>
+HexRecordsCheckCode checkHexRecords(const HexRecordsType &records, MemoryFillMap *pMemMap, HexRecordsCheckReport *pReport)
 {
     MemoryFillMap memoryFillMap;
 
@@ -115,47 +273,49 @@ HexRecordsCheckCode checkHexRecords(const std::vector<HexEntry> &heVec, MemoryFi
     bool overlapsReported = false;
     HexRecordsCheckCode resCode = HexRecordsCheckCode::none;
 
-    for(std::size_t idx=0u; idx!=heVec.size(); ++idx)
+    const std::size_t numRecords = getHexRecordsCount(records);
+    for(std::size_t idx=0u; idx!=numRecords; ++idx)
     {
-        const auto &he = heVec[idx];
+        const HexRecordType recordType  = getHexRecordType(records, idx);
+        const FilePosInfo   filePosInfo = getHexRecordFilePosInfo(records, idx);
 
-        switch(he.recordType)
+        switch(recordType)
         {
             case HexRecordType::invalid: break;
 
             case HexRecordType::data:
+            {
                  //nextAddr = he.effectiveAddress + std::uint32_t(he.data.size());
 
-                 //std::size_t dataSize = he.data.size();
-                 //for(std::size_t i=0; i!=dataSize; ++i)
-                 for(std::size_t i=0; i!=he.data.size(); ++i)
+                 // Запись ложится в один непрерывный кусок адресов, или в два, если адрес заворачивается (SBA).
+                 // Сама с собой запись не перекрывается, так что проверка кусками даёт тот же отчёт, что и побайтовая
+                 bool overlaps = false;
+                 forEachHexRecordDataSegment(records, idx, [&](std::uint32_t addr, std::size_t /* dataOffset */, std::size_t size)
+                 {
+                     if (memoryFillMap.testAndSetRange(addr, size))
+                         overlaps = true;
+                 });
+
+                 if (overlaps && !overlapsReported)
                  {
-                     auto addr = he.getDataByteAddress(i); // he.calcDataByteAddress(i, curBaseAddr, addressMode);
-                     if (memoryFillMap.getFilled(addr))
-                     {
-                         if (!overlapsReported)
-                         {
-                             overlapsReported = true;
-                             report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::memoryOverlaps, he.filePosInfo, idx});
-                             resCode |= HexRecordsCheckCode::memoryOverlaps;
-                         }
-                     }
-
-                     memoryFillMap.setFilled(addr);
+                     overlapsReported = true;
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::memoryOverlaps, filePosInfo, idx});
+                     resCode |= HexRecordsCheckCode::memoryOverlaps;
                  }
                  break;
+            }
 
             case HexRecordType::eof: break;
 
             case HexRecordType::extendedSegmentAddress:
                  if (addressMode!=AddressMode::none && addressMode!=AddressMode::sba)
                  {
-                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchAddressMode, he.filePosInfo, idx});
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchAddressMode, filePosInfo, idx});
                      resCode |= HexRecordsCheckCode::mismatchAddressMode;
                  }
                  if (startAddressMode!=AddressMode::none && startAddressMode!=AddressMode::sba)
                  {
-                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchStartAddressMode, he.filePosInfo, idx});
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchStartAddressMode, filePosInfo, idx});
                      resCode |= HexRecordsCheckCode::mismatchStartAddressMode;
                  }
 
@@ -167,12 +327,12 @@ HexRecordsCheckCode checkHexRecords(const std::vector<HexEntry> &heVec, MemoryFi
             case HexRecordType::startSegmentAddress:
                  if (addressMode!=AddressMode::none && addressMode!=AddressMode::sba)
                  {
-                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchStartAddressMode, he.filePosInfo, idx});
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchStartAddressMode, filePosInfo, idx});
                      resCode |= HexRecordsCheckCode::mismatchStartAddressMode;
                  }
                  if (startAddressMode!=AddressMode::none && startAddressMode!=AddressMode::sba)
                  {
-                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchAddressMode, he.filePosInfo, idx});
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchAddressMode, filePosInfo, idx});
                      resCode |= HexRecordsCheckCode::mismatchAddressMode;
                  }
                  break;
@@ -180,12 +340,12 @@ HexRecordsCheckCode checkHexRecords(const std::vector<HexEntry> &heVec, MemoryFi
             case HexRecordType::extendedLinearAddress:
                  if (addressMode!=AddressMode::none && addressMode!=AddressMode::lba)
                  {
-                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchAddressMode, he.filePosInfo, idx});
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchAddressMode, filePosInfo, idx});
                      resCode |= HexRecordsCheckCode::mismatchAddressMode;
                  }
                  if (startAddressMode!=AddressMode::none && startAddressMode!=AddressMode::lba)
                  {
-                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchStartAddressMode, he.filePosInfo, idx});
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchStartAddressMode, filePosInfo, idx});
                      resCode |= HexRecordsCheckCode::mismatchStartAddressMode;
                  }
 
@@ -197,12 +357,12 @@ HexRecordsCheckCode checkHexRecords(const std::vector<HexEntry> &heVec, MemoryFi
             case HexRecordType::startLinearAddress:
                  if (addressMode!=AddressMode::none && addressMode!=AddressMode::lba)
                  {
-                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchStartAddressMode, he.filePosInfo, idx});
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchStartAddressMode, filePosInfo, idx});
                      resCode |= HexRecordsCheckCode::mismatchStartAddressMode;
                  }
                  if (startAddressMode!=AddressMode::none && startAddressMode!=AddressMode::lba)
                  {
-                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchAddressMode, he.filePosInfo, idx});
+                     report.emplace_back(HexRecordsCheckResultEntry{HexRecordsCheckCode::mismatchAddressMode, filePosInfo, idx});
                      resCode |= HexRecordsCheckCode::mismatchAddressMode;
                  }
                  break;
@@ -211,7 +371,7 @@ HexRecordsCheckCode checkHexRecords(const std::vector<HexEntry> &heVec, MemoryFi
     }
 
     if (pMemMap)
-       *pMemMap = memoryFillMap;
+       *pMemMap = std::move(memoryFillMap);
 
     if (!report.empty())
     {
@@ -222,15 +382,745 @@ HexRecordsCheckCode checkHexRecords(const std::vector<HexEntry> &heVec, MemoryFi
     return resCode;
 }
 
+//----------------------------------------------------------------------------
+//! Перекрытие двух записей
+struct HexRecordsOverlapEntry
+{
+    std::size_t           hexEntryIndex1 = 0; //!< Меньший индекс
+    std::size_t           hexEntryIndex2 = 0; //!< Больший индекс
+    FilePosInfo           filePosInfo1;
+    FilePosInfo           filePosInfo2;
+    std::uint32_t         address        = 0; //!< Начало перекрытия
+    std::size_t           size           = 0; //!< Размер перекрытия в байтах
+    bool                  identical      = false; //!< В перекрывающихся байтах у обеих записей одно и то же
+
+}; // struct HexRecordsOverlapEntry
+
+using HexRecordsOverlapReport = std::vector<HexRecordsOverlapEntry>;
+
+//------------------------------
+/*! Находит все пары перекрывающихся записей данных (checkHexRecords сообщает только о первом перекрытии).
+    Записи режутся на непрерывные интервалы адресов (один на запись, два - если адрес заворачивается),
+    интервалы сортируются по началу и проходятся один раз с набором "активных" интервалов, ещё не кончившихся
+    к началу текущего. Записи не длиннее 255 байт, так что активных обычно единицы, и время - O(n log n)
+    плюс размер отчёта, от количества байт не зависит.
+
+    На каждую пару перекрывающихся интервалов - одна запись отчёта, по возрастанию адреса перекрытия.
+    Адресная информация записей должна быть заполнена (updateHexEntriesAddressAndMode).
+    Возвращает true, если перекрытия есть
+ */
+template<typename HexRecordsType>
+bool findHexRecordsOverlaps(const HexRecordsType &records, HexRecordsOverlapReport &report)
+{
+    struct Interval
+    {
+        std::uint64_t  begin;
+        std::uint64_t  end;
+        std::size_t    recordIdx;
+        std::size_t    dataOffset;
+    };
+
+    std::vector<Interval> intervals;
+    const std::size_t numRecords = getHexRecordsCount(records);
+    intervals.reserve(numRecords);
+
+    for(std::size_t idx=0u; idx!=numRecords; ++idx)
+    {
+        forEachHexRecordDataSegment(records, idx, [&](std::uint32_t addr, std::size_t dataOffset, std::size_t size)
+        {
+            intervals.emplace_back(Interval{std::uint64_t(addr), std::uint64_t(addr)+size, idx, dataOffset});
+        });
+    }
+
+    std::sort( intervals.begin(), intervals.end()
+             , [](const Interval &i1, const Interval &i2)
+               {
+                   return i1.begin!=i2.begin ? i1.begin<i2.begin : i1.recordIdx<i2.recordIdx;
+               }
+             );
+
+    const std::size_t reportSizeOrg = report.size();
+    std::vector<std::size_t> active; // Индексы в intervals
+
+    for(std::size_t curIdx=0; curIdx!=intervals.size(); ++curIdx)
+    {
+        const Interval &cur = intervals[curIdx];
+
+        // Выкидываем кончившиеся, остальные - перекрываются с текущим
+        std::size_t numActive = 0;
+        for(auto activeIdx : active)
+        {
+            const Interval &prev = intervals[activeIdx];
+            if (prev.end<=cur.begin)
+                continue;
+
+            active[numActive++] = activeIdx;
+
+            const std::uint64_t overlapEnd  = prev.end<cur.end ? prev.end : cur.end;
+            const std::size_t   overlapSize = std::size_t(overlapEnd-cur.begin);
+
+            const std::uint8_t *pPrevData = getHexRecordData(records, prev.recordIdx) + prev.dataOffset + std::size_t(cur.begin-prev.begin);
+            const std::uint8_t *pCurData  = getHexRecordData(records, cur.recordIdx ) + cur.dataOffset;
+
+            HexRecordsOverlapEntry entry;
+            entry.hexEntryIndex1 = prev.recordIdx<cur.recordIdx ? prev.recordIdx : cur.recordIdx;
+            entry.hexEntryIndex2 = prev.recordIdx<cur.recordIdx ? cur.recordIdx  : prev.recordIdx;
+            entry.filePosInfo1   = getHexRecordFilePosInfo(records, entry.hexEntryIndex1);
+            entry.filePosInfo2   = getHexRecordFilePosInfo(records, entry.hexEntryIndex2);
+            entry.address        = std::uint32_t(cur.begin);
+            entry.size           = overlapSize;
+            entry.identical      = std::memcmp(pPrevData, pCurData, overlapSize)==0;
+            report.emplace_back(entry);
+        }
+
+        active.resize(numActive);
+        active.emplace_back(curIdx);
+    }
+
+    return report.size()!=reportSizeOrg;
+}
+
+//------------------------------
+//! Кусок данных записи, который после нормализации станет отдельной записью. Поля ужаты до 12 байт -
+//! сортировка гоняет эти куски по памяти несколько раз. Записей не больше 4G, данных в записи не больше 255 байт
+struct NormalizedAddressOrderPiece
+{
+    std::uint32_t   address    = 0; //!< Эффективный адрес первого байта - ключ сортировки
+    std::uint32_t   recordIdx  = 0;
+    std::uint8_t    dataOffset = 0;
+    std::uint8_t    size       = 0;
+
+}; // struct NormalizedAddressOrderPiece
+
+//------------------------------
+/*! Общая часть normalizeAddressOrder для вектора и для таблицы. Записи данных режутся на куски, которые
+    не переходят через границу 64K (заворот SBA сегмента и 32-битного адреса тоже даёт два куска), куски
+    сортируются по эффективному адресу. Пустые записи данных и ESA/ELA выбрасываются, стартовые адреса
+    (и invalid, если попались) собираются в tailRecords в исходном порядке, в eofIdx - первая EOF запись.
+    В addressMode - режим адресации для результата: sba, если в записях есть ESA/SSA и нет ELA/SLA, иначе lba
+ */
+template<typename HexRecordsType>
+void makeNormalizedAddressOrder( const HexRecordsType                     &records
+                               , std::vector<NormalizedAddressOrderPiece> &pieces
+                               , std::vector<std::size_t>                 &tailRecords
+                               , std::size_t                              &eofIdx
+                               , AddressMode                              &addressMode
+                               )
+{
+    const std::size_t numRecords = getHexRecordsCount(records);
+    pieces.reserve(numRecords);
+    eofIdx = std::size_t(-1);
+
+    bool hasSegmentRecords = false;
+    bool hasLinearRecords  = false;
+
+    for(std::size_t idx=0u; idx!=numRecords; ++idx)
+    {
+        switch(getHexRecordType(records, idx))
+        {
+            case HexRecordType::data:
+                 forEachHexRecordDataSegment(records, idx, [&](std::uint32_t addr, std::size_t dataOffset, std::size_t size)
+                 {
+                     // Запись не длиннее 255 байт, так что через границу 64K кусок переходит не больше одного раза
+                     const std::size_t pageTail  = 0x10000u - std::size_t(addr&0xFFFFu);
+                     const std::size_t firstSize = size<pageTail ? size : pageTail;
+                     pieces.emplace_back(NormalizedAddressOrderPiece{addr, std::uint32_t(idx), std::uint8_t(dataOffset), std::uint8_t(firstSize)});
+                     if (firstSize!=size)
+                         pieces.emplace_back(NormalizedAddressOrderPiece{std::uint32_t(addr+firstSize), std::uint32_t(idx), std::uint8_t(dataOffset+firstSize), std::uint8_t(size-firstSize)});
+                 });
+                 break;
+
+            case HexRecordType::extendedSegmentAddress:
+                 hasSegmentRecords = true;
+                 break;
+
+            case HexRecordType::extendedLinearAddress:
+                 hasLinearRecords = true;
+                 break;
+
+            case HexRecordType::eof:
+                 if (eofIdx==std::size_t(-1))
+                     eofIdx = idx;
+                 break;
+
+            case HexRecordType::startSegmentAddress:
+                 hasSegmentRecords = true;
+                 tailRecords.emplace_back(idx);
+                 break;
+
+            case HexRecordType::startLinearAddress:
+                 hasLinearRecords = true;
+                 tailRecords.emplace_back(idx);
+                 break;
+
+            default:
+                 tailRecords.emplace_back(idx);
+        }
+    }
+
+    addressMode = hasSegmentRecords && !hasLinearRecords ? AddressMode::sba : AddressMode::lba;
+
+    utils::radixSortByKey32(pieces, [](const NormalizedAddressOrderPiece &piece) { return piece.address; });
+}
+
+//------------------------------
+/*! Упорядочивает записи данных по эффективному адресу так, чтобы результат оставался правильным HEX потоком.
+    Ключ (32-битный адрес) считается один раз на запись, сортировка - устойчивая поразрядная, записи переносятся
+    через std::move, время линейное. Записи с одинаковым адресом остаются в исходном порядке.
+
+    Расширенные адреса пересоздаются заново - минимальный набор ELA записей (ESA, если исходные записи были
+    в режиме SBA), по одной на каждое 64K окно с данными (для первого окна - ни одной). Запись данных, которая
+    переходила через границу 64K или заворачивалась внутри SBA сегмента, режется на две. Стартовые адреса идут после данных в исходном порядке,
+    EOF, если был, - последней записью.
+
+    Адресная информация записей должна быть заполнена (updateHexEntriesAddressAndMode), у результата она
+    заполнена заново.
+ */
 inline
 void normalizeAddressOrder(std::vector<HexEntry> &heVec)
 {
-    std::stable_sort( heVec.begin(), heVec.end()
-                    , [](const HexEntry &e1, const HexEntry &e2)
-                      {
-                          return e1.getEffectiveBaseAddress() < e2.getEffectiveBaseAddress();
-                      }
-                    );
+    std::vector<NormalizedAddressOrderPiece> pieces;
+    std::vector<std::size_t>                 tailRecords;
+    std::size_t                              eofIdx = std::size_t(-1);
+    AddressMode                              addressMode = AddressMode::lba;
+    makeNormalizedAddressOrder(heVec, pieces, tailRecords, eofIdx, addressMode);
+
+    const HexRecordType baseRecordType = addressMode==AddressMode::sba ? HexRecordType::extendedSegmentAddress : HexRecordType::extendedLinearAddress;
+
+    std::vector<HexEntry> resVec;
+    resVec.reserve(pieces.size()+tailRecords.size()+1u);
+
+    std::uint16_t curBaseAddr = 0;
+    for(const auto &piece : pieces)
+    {
+        const std::uint16_t baseAddr = getNormalizedBaseAddress(piece.address, addressMode);
+        if (baseAddr!=curBaseAddr)
+        {
+            resVec.emplace_back(baseRecordType, baseAddr);
+            curBaseAddr = baseAddr;
+        }
+
+        HexEntry &srcEntry = heVec[piece.recordIdx];
+        if (piece.dataOffset==0 && piece.size==srcEntry.data.size())
+        {
+            resVec.emplace_back(std::move(srcEntry));
+        }
+        else
+        {
+            const std::uint8_t *pData = srcEntry.data.data()+piece.dataOffset;
+            resVec.emplace_back(byte_vector(pData, pData+piece.size));
+            resVec.back().filePosInfo = srcEntry.filePosInfo;
+        }
+
+        resVec.back().address = getNormalizedAddressOffset(piece.address, baseAddr, addressMode);
+    }
+
+    for(auto idx : tailRecords)
+        resVec.emplace_back(std::move(heVec[idx]));
+
+    if (eofIdx!=std::size_t(-1))
+        resVec.emplace_back(std::move(heVec[eofIdx]));
+
+    heVec.swap(resVec);
+    updateHexEntriesAddressAndMode(heVec);
+}
+
+//------------------------------
+//! То же для таблицы. Таблица собирается заново, байты данных копируются в новую арену подряд, в порядке адресов
+inline
+void normalizeAddressOrder(HexRecordTable &tbl)
+{
+    std::vector<NormalizedAddressOrderPiece> pieces;
+    std::vector<std::size_t>                 tailRecords;
+    std::size_t                              eofIdx = std::size_t(-1);
+    AddressMode                              addressMode = AddressMode::lba;
+    makeNormalizedAddressOrder(tbl, pieces, tailRecords, eofIdx, addressMode);
+
+    const HexRecordType baseRecordType = addressMode==AddressMode::sba ? HexRecordType::extendedSegmentAddress : HexRecordType::extendedLinearAddress;
+
+    HexRecordTable resTbl;
+    resTbl.reserve(pieces.size()+tailRecords.size()+1u, tbl.arena.size());
+
+    std::uint16_t curBaseAddr = 0;
+    for(const auto &piece : pieces)
+    {
+        const std::uint16_t baseAddr = getNormalizedBaseAddress(piece.address, addressMode);
+        if (baseAddr!=curBaseAddr)
+        {
+            const std::uint8_t baseAddrBytes[2] = { std::uint8_t(baseAddr>>8), std::uint8_t(baseAddr) };
+            resTbl.appendRecord(baseRecordType, 0, &baseAddrBytes[0], 2u, 0u);
+            curBaseAddr = baseAddr;
+        }
+
+        resTbl.appendRecord( HexRecordType::data, getNormalizedAddressOffset(piece.address, baseAddr, addressMode)
+                           , tbl.getData(piece.recordIdx)+piece.dataOffset, piece.size
+                           , tbl.lines[piece.recordIdx]
+                           );
+    }
+
+    for(auto idx : tailRecords)
+        resTbl.appendRecord(tbl.getRecordType(idx), tbl.getAddress(idx), tbl.getData(idx), tbl.getDataSize(idx), tbl.lines[idx]);
+
+    if (eofIdx!=std::size_t(-1))
+        resTbl.appendRecord(HexRecordType::eof, 0, tbl.getData(eofIdx), tbl.getDataSize(eofIdx), tbl.lines[eofIdx]);
+
+    resTbl.fileId = tbl.fileId;
+    tbl = std::move(resTbl);
+}
+
+//----------------------------------------------------------------------------
+//! Перекрытие данных двух записей при слиянии. Первая - та, что раньше по (номеру входа, номеру записи)
+struct HexMergeConflictEntry
+{
+    std::size_t           inputIndex1    = 0;
+    std::size_t           hexEntryIndex1 = 0;
+    FilePosInfo           filePosInfo1;        //!< filePosInfo1.file - id файла первой записи
+    std::size_t           inputIndex2    = 0;
+    std::size_t           hexEntryIndex2 = 0;
+    FilePosInfo           filePosInfo2;
+    std::uint32_t         address        = 0; //!< Начало перекрытия
+    std::size_t           size           = 0; //!< Размер перекрытия в байтах
+    bool                  identical      = false; //!< В перекрывающихся байтах у обеих записей одно и то же
+
+}; // struct HexMergeConflictEntry
+
+using HexMergeConflictReport = std::vector<HexMergeConflictEntry>;
+
+//------------------------------
+//! Кусок результата слияния - кусок данных записи одного из входов, не переходит через границу 64K
+struct HexMergePiece
+{
+    std::uint32_t   address    = 0;
+    std::uint32_t   inputIdx   = 0;
+    std::uint32_t   recordIdx  = 0;
+    std::uint8_t    dataOffset = 0;
+    std::uint8_t    size       = 0;
+
+}; // struct HexMergePiece
+
+//------------------------------
+/*! Общая часть mergeHexRecords. Режим адресации всех входов должен совпадать (или в каком-то из входов
+    вообще не быть записей с базовым адресом), иначе - mismatchAddressMode. Каждый вход упорядочивается
+    как в normalizeAddressOrder, упорядоченные входы сливаются через кучу из N курсоров - O(R log N)
+    на все R записей, без побайтовой карты заполнения.
+
+    Слитый поток проходится один раз с набором "активных" кусков, ещё не кончившихся к текущему адресу.
+    Каждая пара перекрывающихся кусков попадает в отчёт. В каждом отрезке между границами кусков
+    выбирается один кусок: при lastWins - самый поздний по (номеру входа, номеру записи), иначе - самый
+    ранний. Перекрытия внутри одного входа обрабатываются так же.
+
+    При errorOnOverlap любое перекрытие - ошибка memoryOverlaps, при allowIdentical - перекрытие
+    с разными байтами. Отчёт при этом всё равно заполняется целиком.
+
+    Стартовые адреса берутся из первого входа, в котором они есть (при lastWins - из последнего).
+ */
+template<typename HexRecordsType>
+bool makeHexMergePieces( const std::vector<const HexRecordsType*>          &inputs
+                       , HexMergePolicy                                    policy
+                       , std::vector<HexMergePiece>                        &resPieces
+                       , std::vector<std::pair<std::size_t, std::size_t> > &startRecords // (вход, запись)
+                       , AddressMode                                       &addressMode
+                       , HexMergeConflictReport                            *pReport
+                       , ParsingResult                                     &r
+                       )
+{
+    const std::size_t numInputs = inputs.size();
+
+    addressMode = AddressMode::none;
+    for(std::size_t inputIdx=0; inputIdx!=numInputs; ++inputIdx)
+    {
+        bool hasSegmentRecords = false;
+        bool hasLinearRecords  = false;
+
+        const std::size_t numRecords = getHexRecordsCount(*inputs[inputIdx]);
+        for(std::size_t idx=0u; idx!=numRecords; ++idx)
+        {
+            const HexRecordType recordType = getHexRecordType(*inputs[inputIdx], idx);
+            if (recordType==HexRecordType::extendedSegmentAddress || recordType==HexRecordType::startSegmentAddress)
+                hasSegmentRecords = true;
+            else if (recordType==HexRecordType::extendedLinearAddress || recordType==HexRecordType::startLinearAddress)
+                hasLinearRecords = true;
+        }
+
+        if (hasSegmentRecords && hasLinearRecords)
+            return r=ParsingResult::mismatchAddressMode, false;
+
+        const AddressMode inputAddressMode = hasSegmentRecords ? AddressMode::sba : hasLinearRecords ? AddressMode::lba : AddressMode::none;
+        if (inputAddressMode==AddressMode::none)
+            continue;
+
+        if (addressMode!=AddressMode::none && addressMode!=inputAddressMode)
+            return r=ParsingResult::mismatchAddressMode, false;
+
+        addressMode = inputAddressMode;
+    }
+
+    if (addressMode==AddressMode::none)
+        addressMode = AddressMode::lba;
+
+    // Упорядочиваем каждый вход
+    std::vector< std::vector<NormalizedAddressOrderPiece> > inputPieces(numInputs);
+    std::size_t totalPieces = 0;
+    std::size_t startInputIdx = std::size_t(-1);
+
+    for(std::size_t inputIdx=0; inputIdx!=numInputs; ++inputIdx)
+    {
+        std::vector<std::size_t> tailRecords;
+        std::size_t              eofIdx = std::size_t(-1);
+        AddressMode              inputAddressMode = AddressMode::lba;
+        makeNormalizedAddressOrder(*inputs[inputIdx], inputPieces[inputIdx], tailRecords, eofIdx, inputAddressMode);
+        totalPieces += inputPieces[inputIdx].size();
+
+        if (startInputIdx!=std::size_t(-1) && policy!=HexMergePolicy::lastWins)
+            continue;
+
+        bool hasStartRecords = false;
+        for(auto idx : tailRecords)
+        {
+            const HexRecordType recordType = getHexRecordType(*inputs[inputIdx], idx);
+            if (recordType!=HexRecordType::startSegmentAddress && recordType!=HexRecordType::startLinearAddress)
+                continue;
+
+            if (!hasStartRecords)
+            {
+                startRecords.clear();
+                startInputIdx   = inputIdx;
+                hasStartRecords = true;
+            }
+
+            startRecords.emplace_back(inputIdx, idx);
+        }
+    }
+
+    // Сливаем через кучу курсоров, в вершине - вход с наименьшим адресом очередного куска (при равных - с меньшим номером)
+    std::vector<std::size_t> cursors(numInputs, 0u);
+    std::vector<std::size_t> heap;
+    heap.reserve(numInputs);
+
+    auto heapLess = [&](std::size_t i1, std::size_t i2)
+    {
+        const std::uint32_t a1 = inputPieces[i1][cursors[i1]].address;
+        const std::uint32_t a2 = inputPieces[i2][cursors[i2]].address;
+        return a1!=a2 ? a1>a2 : i1>i2;
+    };
+
+    for(std::size_t inputIdx=0; inputIdx!=numInputs; ++inputIdx)
+    {
+        if (!inputPieces[inputIdx].empty())
+            heap.emplace_back(inputIdx);
+    }
+    std::make_heap(heap.begin(), heap.end(), heapLess);
+
+    struct Active
+    {
+        std::uint64_t                       begin;
+        std::uint64_t                       end;
+        std::size_t                         inputIdx;
+        const NormalizedAddressOrderPiece  *pPiece;
+
+        bool isBefore(const Active &other) const
+        {
+            return inputIdx!=other.inputIdx ? inputIdx<other.inputIdx : pPiece->recordIdx<other.pPiece->recordIdx;
+        }
+
+        const std::uint8_t* getData(const std::vector<const HexRecordsType*> &inputs, std::uint64_t addr) const
+        {
+            return getHexRecordData(*inputs[inputIdx], pPiece->recordIdx) + pPiece->dataOffset + std::size_t(addr-begin);
+        }
+    };
+
+    std::vector<Active> active;
+    std::size_t numOverlaps          = 0;
+    std::size_t numDifferentOverlaps = 0;
+
+    resPieces.clear();
+    resPieces.reserve(totalPieces);
+
+    auto emit = [&](const Active &a, std::uint64_t from, std::uint64_t to)
+    {
+        const std::size_t dataOffset = a.pPiece->dataOffset + std::size_t(from-a.begin);
+
+        // Куски одной записи по разные стороны границы 64K не склеиваем - makeNormalizedAddressOrder их
+        // разрезал специально, иначе в SBA склеенная запись завернётся внутри сегмента
+        if (!resPieces.empty() && (from&0xFFFFu)!=0)
+        {
+            HexMergePiece &last = resPieces.back();
+            if ( last.inputIdx==a.inputIdx && last.recordIdx==a.pPiece->recordIdx
+              && std::uint64_t(last.address)+last.size==from && std::size_t(last.dataOffset)+last.size==dataOffset
+               )
+            {
+                last.size = std::uint8_t(last.size+(to-from));
+                return;
+            }
+        }
+
+        resPieces.emplace_back(HexMergePiece{std::uint32_t(from), std::uint32_t(a.inputIdx), a.pPiece->recordIdx, std::uint8_t(dataOffset), std::uint8_t(to-from)});
+    };
+
+    std::uint64_t pos = 0;
+    while(!heap.empty() || !active.empty())
+    {
+        if (!heap.empty())
+        {
+            const std::size_t inputIdx = heap.front();
+            const NormalizedAddressOrderPiece &piece = inputPieces[inputIdx][cursors[inputIdx]];
+
+            if (active.empty() || piece.address<=pos)
+            {
+                std::pop_heap(heap.begin(), heap.end(), heapLess);
+                heap.pop_back();
+                if (++cursors[inputIdx]!=inputPieces[inputIdx].size())
+                {
+                    heap.emplace_back(inputIdx);
+                    std::push_heap(heap.begin(), heap.end(), heapLess);
+                }
+
+                const Active cur = Active{piece.address, std::uint64_t(piece.address)+piece.size, inputIdx, &piece};
+                pos = cur.begin;
+
+                for(const auto &prev : active)
+                {
+                    const std::uint64_t overlapEnd  = prev.end<cur.end ? prev.end : cur.end;
+                    const std::size_t   overlapSize = std::size_t(overlapEnd-cur.begin);
+                    const bool          identical   = std::memcmp(prev.getData(inputs, cur.begin), cur.getData(inputs, cur.begin), overlapSize)==0;
+
+                    ++numOverlaps;
+                    if (!identical)
+                        ++numDifferentOverlaps;
+
+                    if (!pReport)
+                        continue;
+
+                    const Active &first  = prev.isBefore(cur) ? prev : cur;
+                    const Active &second = prev.isBefore(cur) ? cur  : prev;
+
+                    HexMergeConflictEntry entry;
+                    entry.inputIndex1    = first.inputIdx;
+                    entry.hexEntryIndex1 = first.pPiece->recordIdx;
+                    entry.filePosInfo1   = getHexRecordFilePosInfo(*inputs[first.inputIdx], entry.hexEntryIndex1);
+                    entry.inputIndex2    = second.inputIdx;
+                    entry.hexEntryIndex2 = second.pPiece->recordIdx;
+                    entry.filePosInfo2   = getHexRecordFilePosInfo(*inputs[second.inputIdx], entry.hexEntryIndex2);
+                    entry.address        = std::uint32_t(cur.begin);
+                    entry.size           = overlapSize;
+                    entry.identical      = identical;
+                    pReport->emplace_back(entry);
+                }
+
+                active.emplace_back(cur);
+                continue;
+            }
+        }
+
+        // Отрезок [pos, boundary) до ближайшей границы - начала следующего куска или конца активного
+        std::uint64_t boundary = heap.empty() ? std::uint64_t(-1) : std::uint64_t(inputPieces[heap.front()][cursors[heap.front()]].address);
+        std::size_t   winnerIdx = 0;
+        for(std::size_t activeIdx=0; activeIdx!=active.size(); ++activeIdx)
+        {
+            if (active[activeIdx].end<boundary)
+                boundary = active[activeIdx].end;
+
+            const bool winnerIsBefore = active[winnerIdx].isBefore(active[activeIdx]);
+            if (policy==HexMergePolicy::lastWins ? winnerIsBefore : !winnerIsBefore)
+                winnerIdx = activeIdx;
+        }
+
+        emit(active[winnerIdx], pos, boundary);
+        pos = boundary;
+
+        std::size_t numActive = 0;
+        for(const auto &a : active)
+        {
+            if (a.end>pos)
+                active[numActive++] = a;
+        }
+        active.resize(numActive);
+    }
+
+    if (policy==HexMergePolicy::errorOnOverlap && numOverlaps)
+        return r=ParsingResult::memoryOverlaps, false;
+
+    if (policy==HexMergePolicy::allowIdentical && numDifferentOverlaps)
+        return r=ParsingResult::memoryOverlaps, false;
+
+    return r=ParsingResult::ok, true;
+}
+
+//------------------------------
+/*! Слияние N входов в один поток записей. Адресная информация записей входов должна быть заполнена
+    (updateHexEntriesAddressAndMode). Результат - как у normalizeAddressOrder: записи данных по порядку адресов
+    с минимальным набором ELA/ESA, затем стартовые адреса, затем EOF.
+    При ошибке результат не трогается, в *pRes - код ошибки. Отчёт о перекрытиях дописывается в *pReport
+ */
+template<typename HexRecordsType>
+bool mergeHexRecords( const std::vector<const HexRecordsType*> &inputs
+                    , HexMergePolicy                           policy
+                    , std::vector<HexEntry>                    &resVec
+                    , HexMergeConflictReport                   *pReport = 0
+                    , ParsingResult                            *pRes    = 0
+                    )
+{
+    std::vector<HexMergePiece>                        pieces;
+    std::vector<std::pair<std::size_t, std::size_t> > startRecords;
+    AddressMode                                       addressMode = AddressMode::lba;
+    ParsingResult                                     r = ParsingResult::ok;
+
+    const bool res = makeHexMergePieces(inputs, policy, pieces, startRecords, addressMode, pReport, r);
+    if (pRes)
+       *pRes = r;
+    if (!res)
+        return false;
+
+    const HexRecordType baseRecordType = addressMode==AddressMode::sba ? HexRecordType::extendedSegmentAddress : HexRecordType::extendedLinearAddress;
+
+    std::vector<HexEntry> mergedVec;
+    mergedVec.reserve(pieces.size()+startRecords.size()+1u);
+
+    std::uint16_t curBaseAddr = 0;
+    for(const auto &piece : pieces)
+    {
+        const std::uint16_t baseAddr = getNormalizedBaseAddress(piece.address, addressMode);
+        if (baseAddr!=curBaseAddr)
+        {
+            mergedVec.emplace_back(baseRecordType, baseAddr);
+            curBaseAddr = baseAddr;
+        }
+
+        const std::uint8_t *pData = getHexRecordData(*inputs[piece.inputIdx], piece.recordIdx) + piece.dataOffset;
+        mergedVec.emplace_back(byte_vector(pData, pData+piece.size));
+        mergedVec.back().address     = getNormalizedAddressOffset(piece.address, baseAddr, addressMode);
+        mergedVec.back().filePosInfo = getHexRecordFilePosInfo(*inputs[piece.inputIdx], piece.recordIdx);
+    }
+
+    for(const auto &sr : startRecords)
+    {
+        const std::uint8_t *pData = getHexRecordData(*inputs[sr.first], sr.second);
+        const std::uint32_t startAddr = (std::uint32_t(pData[0])<<24) | (std::uint32_t(pData[1])<<16) | (std::uint32_t(pData[2])<<8) | std::uint32_t(pData[3]);
+        mergedVec.emplace_back(getHexRecordType(*inputs[sr.first], sr.second), startAddr);
+        mergedVec.back().filePosInfo = getHexRecordFilePosInfo(*inputs[sr.first], sr.second);
+    }
+
+    mergedVec.emplace_back(HexRecordType::eof);
+
+    updateHexEntriesAddressAndMode(mergedVec);
+    resVec.swap(mergedVec);
+    return true;
+}
+
+//------------------------------
+//! То же в таблицу. Номера строк берутся из исходных записей, fileId у результата - по умолчанию
+template<typename HexRecordsType>
+bool mergeHexRecords( const std::vector<const HexRecordsType*> &inputs
+                    , HexMergePolicy                           policy
+                    , HexRecordTable                           &resTbl
+                    , HexMergeConflictReport                   *pReport = 0
+                    , ParsingResult                            *pRes    = 0
+                    )
+{
+    std::vector<HexMergePiece>                        pieces;
+    std::vector<std::pair<std::size_t, std::size_t> > startRecords;
+    AddressMode                                       addressMode = AddressMode::lba;
+    ParsingResult                                     r = ParsingResult::ok;
+
+    const bool res = makeHexMergePieces(inputs, policy, pieces, startRecords, addressMode, pReport, r);
+    if (pRes)
+       *pRes = r;
+    if (!res)
+        return false;
+
+    const HexRecordType baseRecordType = addressMode==AddressMode::sba ? HexRecordType::extendedSegmentAddress : HexRecordType::extendedLinearAddress;
+
+    std::size_t dataSize = 0;
+    for(const auto &piece : pieces)
+        dataSize += piece.size;
+
+    HexRecordTable mergedTbl;
+    mergedTbl.reserve(pieces.size()+startRecords.size()+1u, dataSize);
+
+    std::uint16_t curBaseAddr = 0;
+    for(const auto &piece : pieces)
+    {
+        const std::uint16_t baseAddr = getNormalizedBaseAddress(piece.address, addressMode);
+        if (baseAddr!=curBaseAddr)
+        {
+            const std::uint8_t baseAddrBytes[2] = { std::uint8_t(baseAddr>>8), std::uint8_t(baseAddr) };
+            mergedTbl.appendRecord(baseRecordType, 0, &baseAddrBytes[0], 2u, 0u);
+            curBaseAddr = baseAddr;
+        }
+
+        mergedTbl.appendRecord( HexRecordType::data, getNormalizedAddressOffset(piece.address, baseAddr, addressMode)
+                              , getHexRecordData(*inputs[piece.inputIdx], piece.recordIdx)+piece.dataOffset, piece.size
+                              , getHexRecordFilePosInfo(*inputs[piece.inputIdx], piece.recordIdx).line
+                              );
+    }
+
+    for(const auto &sr : startRecords)
+    {
+        mergedTbl.appendRecord( getHexRecordType(*inputs[sr.first], sr.second), 0
+                              , getHexRecordData(*inputs[sr.first], sr.second), 4u
+                              , getHexRecordFilePosInfo(*inputs[sr.first], sr.second).line
+                              );
+    }
+
+    mergedTbl.appendRecord(HexRecordType::eof, 0, 0, 0u, 0u);
+
+    resTbl = std::move(mergedTbl);
+    return true;
+}
+
+//------------------------------
+//! То же в образ памяти. Образ не очищается, слитые данные пишутся поверх
+template<typename HexRecordsType>
+bool mergeHexRecords( const std::vector<const HexRecordsType*> &inputs
+                    , HexMergePolicy                           policy
+                    , MemoryImage                              &img
+                    , HexMergeConflictReport                   *pReport = 0
+                    , ParsingResult                            *pRes    = 0
+                    )
+{
+    std::vector<HexMergePiece>                        pieces;
+    std::vector<std::pair<std::size_t, std::size_t> > startRecords;
+    AddressMode                                       addressMode = AddressMode::lba;
+    ParsingResult                                     r = ParsingResult::ok;
+
+    const bool res = makeHexMergePieces(inputs, policy, pieces, startRecords, addressMode, pReport, r);
+    if (pRes)
+       *pRes = r;
+    if (!res)
+        return false;
+
+    for(const auto &piece : pieces)
+        img.write(piece.address, getHexRecordData(*inputs[piece.inputIdx], piece.recordIdx)+piece.dataOffset, piece.size);
+
+    return true;
+}
+
+//----------------------------------------------------------------------------
+//! Сериализует все записи, каждую с новой строки (через HexWriter)
+inline
+std::string serializeHexRecords(const std::vector<HexEntry> &heVec, const std::string &lineEnd="\n")
+{
+    std::string res;
+    HexWriter writer;
+    writer.setOutput(res);
+    writer.setLineEnd(lineEnd);
+    writer.writeRecords(heVec);
+    writer.flush();
+    return res;
+}
+
+//------------------------------
+inline
+std::string serializeHexRecords(const HexRecordTable &tbl, const std::string &lineEnd="\n")
+{
+    std::string res;
+    res.reserve(tbl.arena.size()*2u + tbl.size()*(11u+lineEnd.size()));
+    HexWriter writer;
+    writer.setOutput(res);
+    writer.setLineEnd(lineEnd);
+    writer.writeRecords(tbl);
+    writer.flush();
+    return res;
 }
 
 //----------------------------------------------------------------------------
@@ -9,7 +9,6 @@
 #include "bit_vector.h"
 //
 #include <iterator>
-#include <map>
 #include <string>
 #include <vector>
 #include <utility>
@@ -41,7 +40,75 @@ public:
 
 protected:
 
-    std::map<address_t, bit_vector_t >    m_fillMap;
+    // Двухуровневая структура вместо std::map<address_t, bit_vector_t>: таблица на все 65536 страниц
+    // 32-битного пространства (заводится при первой записи) хранит индекс страницы в m_pages плюс один,
+    // 0 - страницы нет. Индексы, а не указатели - чтобы копирование работало как есть.
+    // Плюс кеш последней страницы - подряд обычно идут обращения к одной и той же странице
+    static constexpr const std::size_t numPages = 0x10000u;
+
+    std::vector<std::uint32_t>     m_pageTable;
+    std::vector<bit_vector_t>      m_pages    ;
+
+    mutable address_t              m_lastPageNum   = 0;
+    mutable std::uint32_t          m_lastPageEntry = 0; // Как в m_pageTable, 0 - кеш пуст
+
+
+    static address_t getPageNum   (address_t byteAddr) { return byteAddr>>16; }
+    static address_t getPageBase  (address_t pageNum ) { return pageNum<<16; }
+    static address_t getPageOffset(address_t byteAddr) { return byteAddr&0xFFFFu; }
+
+    const bit_vector_t* findPage(address_t pageNum) const
+    {
+        if (m_lastPageEntry && m_lastPageNum==pageNum)
+            return &m_pages[m_lastPageEntry-1u];
+
+        if (m_pageTable.empty())
+            return 0;
+
+        const std::uint32_t entry = m_pageTable[pageNum];
+        if (!entry)
+            return 0;
+
+        m_lastPageNum   = pageNum;
+        m_lastPageEntry = entry;
+        return &m_pages[entry-1u];
+    }
+
+    bit_vector_t& getPage(address_t pageNum)
+    {
+        if (m_lastPageEntry && m_lastPageNum==pageNum)
+            return m_pages[m_lastPageEntry-1u];
+
+        if (m_pageTable.empty())
+            m_pageTable.resize(numPages, 0u);
+
+        std::uint32_t &entry = m_pageTable[pageNum];
+        if (!entry)
+        {
+            m_pages.emplace_back();
+            m_pages.back().reserve(address_t(0x10000u));
+            entry = std::uint32_t(m_pages.size());
+        }
+
+        m_lastPageNum   = pageNum;
+        m_lastPageEntry = entry;
+        return m_pages[entry-1u];
+    }
+
+    //! Вызывает fn(address_t pageBase, const bit_vector_t &bv) для всех страниц по возрастанию адреса
+    template<typename PageHandler>
+    void forEachPage(PageHandler fn) const
+    {
+        if (m_pages.empty())
+            return;
+
+        for(std::size_t pageNum=0; pageNum!=numPages; ++pageNum)
+        {
+            const std::uint32_t entry = m_pageTable[pageNum];
+            if (entry)
+                fn(getPageBase(address_t(pageNum)), m_pages[entry-1u]);
+        }
+    }
 
 
 public:
@@ -51,38 +118,83 @@ public:
 
     MemoryFillMap() = default;
     MemoryFillMap(const MemoryFillMap &) = default;
-    MemoryFillMap(MemoryFillMap &&) = default;
     MemoryFillMap& operator=(const MemoryFillMap &) = default;
-    MemoryFillMap& operator=(MemoryFillMap &&) = default;
 
-    // TODO: Хорошо бы сделать кеш на чтение и на запись - хранить итератор, по которому было
-    // последнее обращение - при обращении к одной и той же "странице" будет исключаться поиск в map,
-    // а он логарифмический. Хотя, обычно прошивки от силы занимают несколько страниц, но всё равно,
-	    // на несколько сотен килобайт для каждого байта производить поиск - дорого
+    // Кеш у источника после перемещения надо сбросить, он ссылается на уже чужие страницы
+    MemoryFillMap(MemoryFillMap &&other)
+    : m_pageTable    (std::move(other.m_pageTable))
+    , m_pages        (std::move(other.m_pages))
+    , m_lastPageNum  (other.m_lastPageNum)
+    , m_lastPageEntry(other.m_lastPageEntry)
+    {
+        other.clear();
+    }
+
+    MemoryFillMap& operator=(MemoryFillMap &&other)
+    {
+        if (this!=&other)
+        {
+            m_pageTable     = std::move(other.m_pageTable);
+            m_pages         = std::move(other.m_pages);
+            m_lastPageNum   = other.m_lastPageNum;
+            m_lastPageEntry = other.m_lastPageEntry;
+            other.clear();
+        }
+        return *this;
+    }
+
+    bool empty() const { return m_pages.empty(); }
+
+    void clear()
+    {
+        m_pageTable.clear();
+        m_pages.clear();
+        m_lastPageEntry = 0;
+    }
 
 
     bool getFilled(address_t byteAddr) const
     {
-        address_t base = byteAddr&~0xFFFFu;
-        std::map<address_t, bit_vector_t >::const_iterator it = m_fillMap.find(base);
-        if (it==m_fillMap.end())
+        const bit_vector_t *pPage = findPage(getPageNum(byteAddr));
+        if (!pPage)
             return false;
 
-        return it->second.getBit(byteAddr&0xFFFFu);
+        return pPage->getBit(getPageOffset(byteAddr));
     }
 
     void setFilled(address_t byteAddr, bool bVal=true)
     {
-        address_t base   = byteAddr&~0xFFFFu;
-        address_t offset = byteAddr& 0xFFFFu;
-        auto &bv = m_fillMap[base];
-        bv.setBit(offset, bVal);
+        getPage(getPageNum(byteAddr)).setBit(getPageOffset(byteAddr), bVal);
+    }
+
+    //! Помечает заполненными size байт с адреса byteAddr (через конец 32-битного пространства - с нуля).
+    //! Возвращает true, если хоть один из них уже был заполнен. Работает страницами и целыми словами битов
+    bool testAndSetRange(address_t byteAddr, std::size_t size)
+    {
+        bool wasFilled = false;
+
+        while(size)
+        {
+            address_t   offset = getPageOffset(byteAddr);
+            std::size_t chunk  = 0x10000u-std::size_t(offset);
+            if (chunk>size)
+                chunk = size;
+
+            auto &bv = getPage(getPageNum(byteAddr));
+            if (bv.testAndSetRange(offset, address_t(offset+chunk)))
+                wasFilled = true;
+
+            byteAddr += address_t(chunk);
+            size     -= chunk;
+        }
+
+        return wasFilled;
     }
 
     template<typename StreamType>
     StreamType& printTo(StreamType &oss, bool bWide) const
     {
-        if (m_fillMap.empty())
+        if (m_pages.empty())
         {
             oss << "<EMPTY>\n";
             return oss;
@@ -91,22 +203,24 @@ public:
         const address_t lineWidth = bWide ? 128u : 64u;
 
         address_t lastChunkEndAddr = 0;
-        std::map<address_t, bit_vector_t >::const_iterator it = m_fillMap.begin();
-        for(; it!=m_fillMap.end(); ++it)
+        bool      firstPage        = true;
+        forEachPage([&](address_t pageBase, const bit_vector_t &bv)
         {
-            if (it!=m_fillMap.begin() && it->first!=lastChunkEndAddr)
+            if (!firstPage && pageBase!=lastChunkEndAddr)
             {
                 oss << "...\n";
             }
 
+            firstPage = false;
+
             address_t byteIdx = 0;
-            for(; byteIdx!=it->second.size(); ++byteIdx)
+            for(; byteIdx!=bv.size(); ++byteIdx)
             {
                 if ((byteIdx%lineWidth)==0)
                 {
                     if (byteIdx)
                         oss << "\n";
-                    auto addr = it->first+byteIdx;
+                    auto addr = pageBase+byteIdx;
                     std::string strAddr;
                     utils::address32ToHex(addr, std::back_inserter(strAddr));
                     oss << strAddr << " : ";
@@ -117,10 +231,10 @@ public:
                         oss << " ";
                 }
 
-                oss << (it->second.getBit(byteIdx)?"X":"-");
+                oss << (bv.getBit(byteIdx)?"X":"-");
             }
             
-            lastChunkEndAddr = it->first + it->second.size(); // + 1;
+            lastChunkEndAddr = pageBase + bv.size(); // + 1;
             // bool isSizeMultipleWidth = (it->second.size() % lineWidth)==0;
             // lastChunkEndAddr = it->second.size() / lineWidth;
             // if (!isSizeMultipleWidth)
@@ -131,7 +245,7 @@ public:
             // ++lastChunkEndAddr;
 
             oss << "\n"; 
-        }
+        });
 
         return oss;
 
@@ -140,11 +254,10 @@ public:
     std::vector<memory_range_t> makeRanges() const
     {
         std::vector<memory_range_t> resVec;
-        std::map<address_t, bit_vector_t >::const_iterator it = m_fillMap.begin();
-        for(; it!=m_fillMap.end(); ++it)
+        forEachPage([&](address_t pageBase, const bit_vector_t &bv)
         {
-            it->second.makeRanges(resVec, it->first);
-        }
+            bv.makeRanges(resVec, pageBase);
+        });
 
         return resVec;
     }
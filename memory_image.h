@@ -0,0 +1,306 @@
+/*! \file
+    \brief Sparse paged memory image holding actual byte contents
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include "bit_vector.h"
+#include "hex_entry.h"
+#include "hex_record_table.h"
+#include "utils.h"
+
+//----------------------------------------------------------------------------
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <utility>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/memory_image.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Образ памяти - сами байты плюс признак заполненности каждого байта. Хранится страницами по 64K,
+    как и MemoryFillMap (byteAddr&~0xFFFF). Страница заводится при первой записи в неё и сразу
+    заполняется байтом-заполнителем.
+
+    Запись HEX-записи в образ - это один memcpy на непрерывный кусок данных записи
+    (см. HexEntry::forEachDataSegment), а не поиск страницы на каждый байт.
+ */
+
+//----------------------------------------------------------------------------
+class MemoryImage
+{
+
+public:
+
+    using address_t      = std::uint32_t;
+    using bit_vector_t   = BitVector<address_t>;
+    using memory_range_t = typename bit_vector_t::bit_index_range_t;
+    using address_range_t = std::pair<std::uint64_t, std::uint64_t>; //!< [begin, end), конец может быть 0x100000000
+
+    static constexpr const std::size_t pageSize = 0x10000u;
+
+    struct Page
+    {
+        std::vector<std::uint8_t>   bytes ;
+        bit_vector_t                filled;
+    };
+
+
+protected:
+
+    std::map<address_t, Page>   m_pages;
+    std::uint8_t                m_fillByte = 0xFFu;
+
+    // Кеш последней страницы - обычно пишут подряд. Обновляется только при записи, константные методы
+    // его лишь читают - так чтение одного образа из нескольких потоков без синхронизации безопасно
+    address_t                   m_lastPageBase = 0;
+    Page                       *m_pLastPage    = 0;
+
+
+    static address_t getPageBase  (address_t addr) { return addr&~address_t(0xFFFFu); }
+    static address_t getPageOffset(address_t addr) { return addr& address_t(0xFFFFu); }
+
+    const Page* findPage(address_t pageBase) const
+    {
+        if (m_pLastPage && m_lastPageBase==pageBase)
+            return m_pLastPage;
+
+        std::map<address_t, Page>::const_iterator it = m_pages.find(pageBase);
+        return it!=m_pages.end() ? &it->second : 0;
+    }
+
+    Page& getPage(address_t pageBase)
+    {
+        if (m_pLastPage && m_lastPageBase==pageBase)
+            return *m_pLastPage;
+
+        Page &page = m_pages[pageBase];
+        if (page.bytes.empty())
+        {
+            page.bytes.assign(pageSize, m_fillByte);
+            page.filled.reserve(address_t(pageSize));
+        }
+
+        m_lastPageBase = pageBase;
+        m_pLastPage    = &page;
+        return page;
+    }
+
+
+public:
+
+    explicit MemoryImage(std::uint8_t fillByte=0xFFu) : m_fillByte(fillByte) {}
+
+    MemoryImage(const MemoryImage &other) : m_pages(other.m_pages), m_fillByte(other.m_fillByte) {}
+    MemoryImage(MemoryImage &&other) : m_pages(std::move(other.m_pages)), m_fillByte(other.m_fillByte) { other.m_pLastPage = 0; }
+
+    MemoryImage& operator=(const MemoryImage &other)
+    {
+        if (this!=&other)
+        {
+            m_pages     = other.m_pages;
+            m_fillByte  = other.m_fillByte;
+            m_pLastPage = 0;
+        }
+        return *this;
+    }
+
+    MemoryImage& operator=(MemoryImage &&other)
+    {
+        if (this!=&other)
+        {
+            m_pages     = std::move(other.m_pages);
+            m_fillByte  = other.m_fillByte;
+            m_pLastPage = 0;
+            other.m_pLastPage = 0;
+        }
+        return *this;
+    }
+
+    std::uint8_t getFillByte() const { return m_fillByte; }
+    bool         empty()       const { return m_pages.empty(); }
+    std::size_t  getPagesCount() const { return m_pages.size(); }
+
+    const std::map<address_t, Page>& getPages() const { return m_pages; }
+
+    void clear()
+    {
+        m_pages.clear();
+        m_pLastPage = 0;
+    }
+
+
+    //! Пишет size байт с адреса addr. Если данные переходят через конец 32-битного адресного пространства, продолжаются с нуля
+    void write(address_t addr, const std::uint8_t *pData, std::size_t size)
+    {
+        while(size)
+        {
+            const address_t   offset = getPageOffset(addr);
+            std::size_t       chunk  = pageSize-std::size_t(offset);
+            if (chunk>size)
+                chunk = size;
+
+            Page &page = getPage(getPageBase(addr));
+            std::memcpy(&page.bytes[offset], pData, chunk);
+            page.filled.testAndSetRange(offset, address_t(offset+chunk));
+
+            addr  += address_t(chunk);
+            pData += chunk;
+            size  -= chunk;
+        }
+    }
+
+    //! ByteSpanType - что-то с data() и size(): std::vector<std::uint8_t>, byte_vector, std::basic_string<std::uint8_t> и т.п.
+    template<typename ByteSpanType>
+    void write(address_t addr, const ByteSpanType &bytes)
+    {
+        write(addr, (const std::uint8_t*)bytes.data(), std::size_t(bytes.size()));
+    }
+
+    //! Читает size байт с адреса addr. Незаполненные байты читаются как байт-заполнитель.
+    //! Возвращает true, если все прочитанные байты были заполнены
+    bool read(address_t addr, std::uint8_t *pBuf, std::size_t size) const
+    {
+        bool allFilled = true;
+
+        while(size)
+        {
+            const address_t   offset = getPageOffset(addr);
+            std::size_t       chunk  = pageSize-std::size_t(offset);
+            if (chunk>size)
+                chunk = size;
+
+            const Page *pPage = findPage(getPageBase(addr));
+            if (!pPage)
+            {
+                std::memset(pBuf, m_fillByte, chunk);
+                allFilled = false;
+            }
+            else
+            {
+                std::memcpy(pBuf, &pPage->bytes[offset], chunk);
+                if (allFilled)
+                    allFilled = pPage->filled.isRangeSet(offset, address_t(offset+chunk));
+            }
+
+            addr += address_t(chunk);
+            pBuf += chunk;
+            size -= chunk;
+        }
+
+        return allFilled;
+    }
+
+    std::vector<std::uint8_t> read(address_t addr, std::size_t size) const
+    {
+        std::vector<std::uint8_t> res(size);
+        if (size)
+            read(addr, res.data(), size);
+        return res;
+    }
+
+    std::uint8_t getByte(address_t addr) const
+    {
+        const Page *pPage = findPage(getPageBase(addr));
+        return pPage ? pPage->bytes[getPageOffset(addr)] : m_fillByte;
+    }
+
+    bool isFilled(address_t addr) const
+    {
+        const Page *pPage = findPage(getPageBase(addr));
+        return pPage ? pPage->filled.getBit(getPageOffset(addr)) : false;
+    }
+
+
+    //! Заполненные диапазоны адресов [begin, end), смежные диапазоны соседних страниц сливаются.
+    //! Границы 64-битные - диапазон, доходящий до конца 32-битного пространства, кончается на 0x100000000
+    std::vector<address_range_t> makeRanges() const
+    {
+        std::vector<address_range_t> resVec;
+        std::vector<memory_range_t>  pageRanges;
+        for(const auto &kv : m_pages)
+        {
+            pageRanges.clear();
+            kv.second.filled.makeRanges(pageRanges, 0); // Индексы внутри страницы - с базой последняя страница переполнила бы 32 бита
+
+            for(const auto &r : pageRanges)
+            {
+                const std::uint64_t b = std::uint64_t(kv.first)+r.first;
+                const std::uint64_t e = std::uint64_t(kv.first)+r.second;
+                if (!resVec.empty() && resVec.back().second==b)
+                    resVec.back().second = e;
+                else
+                    resVec.emplace_back(b, e);
+            }
+        }
+
+        return resVec;
+    }
+
+    //! Вызывает fn(address_t addr, const std::uint8_t *pData, std::size_t size) для каждого непрерывного заполненного куска,
+    //! по порядку адресов. Кусок, проходящий через границу страниц, выдаётся двумя вызовами
+    template<typename RangeHandler>
+    void forEachRange(RangeHandler fn) const
+    {
+        std::vector<memory_range_t> pageRanges;
+        for(const auto &kv : m_pages)
+        {
+            pageRanges.clear();
+            kv.second.filled.makeRanges(pageRanges, 0);
+            for(const auto &r : pageRanges)
+                fn(address_t(kv.first+r.first), &kv.second.bytes[r.first], std::size_t(r.second-r.first));
+        }
+    }
+
+
+    //! Запись должна быть с заполненной адресной информацией (updateHexEntriesAddressAndMode)
+    void addRecord(const HexEntry &he)
+    {
+        he.forEachDataSegment([&](address_t addr, std::size_t dataOffset, std::size_t size)
+        {
+            write(addr, he.data.data()+dataOffset, size);
+        });
+    }
+
+    void addRecords(const std::vector<HexEntry> &heVec)
+    {
+        for(const auto &he : heVec)
+            addRecord(he);
+    }
+
+    void addRecords(const HexRecordTable &tbl)
+    {
+        for(std::size_t idx=0; idx!=tbl.size(); ++idx)
+        {
+            const std::uint8_t *pData = tbl.getData(idx);
+            tbl.forEachDataSegment(idx, [&](address_t addr, std::size_t dataOffset, std::size_t size)
+            {
+                write(addr, pData+dataOffset, size);
+            });
+        }
+    }
+
+}; // class MemoryImage
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/memory_image.h
+
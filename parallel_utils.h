@@ -0,0 +1,105 @@
+/*! \file
+    \brief Simple helpers for running tasks on multiple threads
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/parallel_utils.h
+// marty::hex::utils::
+namespace marty{
+namespace hex{
+namespace utils {
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+inline
+std::size_t getHardwareThreadsCount()
+{
+    std::size_t n = std::size_t(std::thread::hardware_concurrency());
+    return n ? n : 1u;
+}
+
+//----------------------------------------------------------------------------
+//! Выполняет taskFn(taskIdx) для taskIdx из [0, numTasks) на numThreads потоках (0 - по числу ядер).
+//! Потоки разбирают задачи по одной через атомарный счётчик. Первое пойманное исключение
+//! пробрасывается в вызывающий поток после завершения всех потоков
+template<typename TaskFn>
+void parallelFor(std::size_t numTasks, std::size_t numThreads, TaskFn taskFn)
+{
+    if (!numThreads)
+        numThreads = getHardwareThreadsCount();
+
+    if (numThreads>numTasks)
+        numThreads = numTasks;
+
+    if (numThreads<=1)
+    {
+        for(std::size_t taskIdx=0; taskIdx!=numTasks; ++taskIdx)
+            taskFn(taskIdx);
+        return;
+    }
+
+    std::atomic<std::size_t> nextTask(0);
+    std::exception_ptr       firstException;
+    std::mutex               exceptionMutex;
+
+    auto worker = [&]()
+    {
+        for(;;)
+        {
+            std::size_t taskIdx = nextTask.fetch_add(1u);
+            if (taskIdx>=numTasks)
+                break;
+
+            try
+            {
+                taskFn(taskIdx);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (!firstException)
+                    firstException = std::current_exception();
+                nextTask.store(numTasks); // Остальные задачи не запускаем
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads-1u);
+    for(std::size_t i=1; i!=numThreads; ++i)
+        threads.emplace_back(worker);
+
+    worker(); // Текущий поток тоже работает
+
+    for(auto &t : threads)
+        t.join();
+
+    if (firstException)
+        std::rethrow_exception(firstException);
+}
+
+//----------------------------------------------------------------------------
+
+} // namespace utils
+} // namespace hex
+} // namespace marty
+// marty::hex::utils::
+// marty_hex/parallel_utils.h
+
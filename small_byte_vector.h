@@ -0,0 +1,379 @@
+/*! \file
+    \brief Byte container with inline (small buffer) storage
+ */
+
+#pragma once
+
+//----------------------------------------------------------------------------
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+// marty_hex/small_byte_vector.h
+// marty::hex::
+namespace marty{
+namespace hex{
+
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+/*
+    Вектор байт, который до InlineCapacity байт хранит прямо в себе, и только сверх этого лезет в кучу.
+    Интерфейс - подмножество std::vector/std::basic_string, которым пользуются HexEntry и прочие.
+    Итераторы - простые указатели.
+
+    Копия выделяет память ровно под size() (или не выделяет вовсе, если помещается в InlineCapacity).
+ */
+
+//----------------------------------------------------------------------------
+template<std::size_t InlineCapacity>
+class SmallByteVector
+{
+    static_assert(InlineCapacity>0, "SmallByteVector: InlineCapacity must be greater than zero");
+
+public:
+
+    using value_type      = std::uint8_t;
+    using size_type       = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference       = std::uint8_t&;
+    using const_reference = const std::uint8_t&;
+    using pointer         = std::uint8_t*;
+    using const_pointer   = const std::uint8_t*;
+    using iterator        = std::uint8_t*;
+    using const_iterator  = const std::uint8_t*;
+
+    static constexpr const std::size_t inline_capacity = InlineCapacity;
+
+
+protected:
+
+    std::uint8_t   *m_pData    = m_inline;
+    std::size_t     m_size     = 0;
+    std::size_t     m_capacity = InlineCapacity;
+    std::uint8_t    m_inline[InlineCapacity];
+
+
+public:
+
+    SmallByteVector() {}
+
+    ~SmallByteVector() { freeHeap(); }
+
+    SmallByteVector(const SmallByteVector &other)
+    {
+        assign(other.begin(), other.end());
+    }
+
+    SmallByteVector(SmallByteVector &&other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    SmallByteVector& operator=(const SmallByteVector &other)
+    {
+        if (this!=&other)
+            assign(other.begin(), other.end());
+        return *this;
+    }
+
+    SmallByteVector& operator=(SmallByteVector &&other) noexcept
+    {
+        if (this!=&other)
+        {
+            freeHeap();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    explicit SmallByteVector(std::size_t n, std::uint8_t b=0)
+    {
+        resize(n, b);
+    }
+
+    SmallByteVector(std::initializer_list<std::uint8_t> il)
+    {
+        assign(il.begin(), il.end());
+    }
+
+    template< typename InputIterator
+            , typename std::enable_if<!std::is_integral<InputIterator>::value, int>::type = 0
+            >
+    SmallByteVector(InputIterator b, InputIterator e)
+    {
+        assign(b, e);
+    }
+
+
+    std::size_t size()     const { return m_size; }
+    std::size_t capacity() const { return m_capacity; }
+    bool        empty()    const { return m_size==0; }
+    bool        isInline() const { return m_pData==m_inline; }
+
+    std::uint8_t*       data()       { return m_pData; }
+    const std::uint8_t* data() const { return m_pData; }
+
+    iterator       begin()       { return m_pData; }
+    iterator       end()         { return m_pData+m_size; }
+    const_iterator begin() const { return m_pData; }
+    const_iterator end()   const { return m_pData+m_size; }
+    const_iterator cbegin() const { return m_pData; }
+    const_iterator cend()   const { return m_pData+m_size; }
+
+    std::uint8_t&       operator[](std::size_t idx)       { return m_pData[idx]; }
+    const std::uint8_t& operator[](std::size_t idx) const { return m_pData[idx]; }
+
+    std::uint8_t& at(std::size_t idx)
+    {
+        if (idx>=m_size)
+            throw std::out_of_range("SmallByteVector::at");
+        return m_pData[idx];
+    }
+
+    const std::uint8_t& at(std::size_t idx) const
+    {
+        if (idx>=m_size)
+            throw std::out_of_range("SmallByteVector::at");
+        return m_pData[idx];
+    }
+
+    std::uint8_t&       front()       { return m_pData[0]; }
+    const std::uint8_t& front() const { return m_pData[0]; }
+    std::uint8_t&       back()        { return m_pData[m_size-1]; }
+    const std::uint8_t& back()  const { return m_pData[m_size-1]; }
+
+
+    //! Ёмкость не трогаем - как у std::vector
+    void clear() { m_size = 0; }
+
+    void reserve(std::size_t n)
+    {
+        if (n>m_capacity)
+            reallocate(n);
+    }
+
+    //! Если данные помещаются во встроенный буфер, уходим из кучи
+    void shrink_to_fit()
+    {
+        if (isInline() || m_size==m_capacity)
+            return;
+        reallocate(m_size);
+    }
+
+    void resize(std::size_t n)
+    {
+        if (n>m_capacity)
+            grow(n);
+        m_size = n;
+    }
+
+    void resize(std::size_t n, std::uint8_t b)
+    {
+        if (n>m_capacity)
+            grow(n);
+        if (n>m_size)
+            std::memset(m_pData+m_size, b, n-m_size);
+        m_size = n;
+    }
+
+    void push_back(std::uint8_t b)
+    {
+        if (m_size==m_capacity)
+            grow(m_size+1u);
+        m_pData[m_size++] = b;
+    }
+
+    std::uint8_t& emplace_back(std::uint8_t b)
+    {
+        push_back(b);
+        return back();
+    }
+
+    void pop_back() { --m_size; }
+
+    SmallByteVector& append(std::size_t n, std::uint8_t b)
+    {
+        resize(m_size+n, b);
+        return *this;
+    }
+
+    SmallByteVector& append(const std::uint8_t *p, std::size_t n)
+    {
+        if (!n)
+            return *this;
+        if (m_size+n>m_capacity)
+            grow(m_size+n);
+        std::memcpy(m_pData+m_size, p, n);
+        m_size += n;
+        return *this;
+    }
+
+    template< typename InputIterator
+            , typename std::enable_if<!std::is_integral<InputIterator>::value, int>::type = 0
+            >
+    void assign(InputIterator b, InputIterator e)
+    {
+        m_size = 0;
+        reserve(std::size_t(std::distance(b, e)));
+        for(; b!=e; ++b)
+            m_pData[m_size++] = std::uint8_t(*b);
+    }
+
+    void assign(const std::uint8_t *b, const std::uint8_t *e)
+    {
+        const std::size_t n = std::size_t(e-b);
+        m_size = 0;
+        reserve(n);
+        if (n)
+            std::memmove(m_pData, b, n);
+        m_size = n;
+    }
+
+    void assign(std::size_t n, std::uint8_t b)
+    {
+        m_size = 0;
+        resize(n, b);
+    }
+
+    //! Удаляет sz байт, начиная с offs - как std::basic_string::erase
+    SmallByteVector& erase(std::size_t offs, std::size_t sz)
+    {
+        if (offs>m_size)
+            throw std::out_of_range("SmallByteVector::erase");
+        if (sz>m_size-offs)
+            sz = m_size-offs;
+        std::memmove(m_pData+offs, m_pData+offs+sz, m_size-offs-sz);
+        m_size -= sz;
+        return *this;
+    }
+
+    iterator erase(const_iterator b, const_iterator e)
+    {
+        const std::size_t offs = std::size_t(b-m_pData);
+        erase(offs, std::size_t(e-b));
+        return m_pData+offs;
+    }
+
+    iterator insert(const_iterator pos, const std::uint8_t *b, const std::uint8_t *e)
+    {
+        const std::size_t offs = std::size_t(pos-m_pData);
+        const std::size_t n    = std::size_t(e-b);
+        if (m_size+n>m_capacity)
+            grow(m_size+n); // b/e не должны указывать внутрь нас
+        std::memmove(m_pData+offs+n, m_pData+offs, m_size-offs);
+        if (n)
+            std::memcpy(m_pData+offs, b, n);
+        m_size += n;
+        return m_pData+offs;
+    }
+
+    void swap(SmallByteVector &other) noexcept
+    {
+        SmallByteVector tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+
+    friend bool operator==(const SmallByteVector &v1, const SmallByteVector &v2)
+    {
+        return v1.m_size==v2.m_size && (v1.m_size==0 || std::memcmp(v1.m_pData, v2.m_pData, v1.m_size)==0);
+    }
+
+    friend bool operator!=(const SmallByteVector &v1, const SmallByteVector &v2)
+    {
+        return !(v1==v2);
+    }
+
+    friend bool operator<(const SmallByteVector &v1, const SmallByteVector &v2)
+    {
+        const std::size_t n = v1.m_size<v2.m_size ? v1.m_size : v2.m_size;
+        const int cmp = n ? std::memcmp(v1.m_pData, v2.m_pData, n) : 0;
+        return cmp<0 || (cmp==0 && v1.m_size<v2.m_size);
+    }
+
+
+protected:
+
+    void freeHeap()
+    {
+        if (!isInline())
+            delete[] m_pData;
+        m_pData    = m_inline;
+        m_capacity = InlineCapacity;
+    }
+
+    void moveFrom(SmallByteVector &other)
+    {
+        if (other.isInline())
+        {
+            if (other.m_size)
+                std::memcpy(m_inline, other.m_inline, other.m_size);
+            m_pData    = m_inline;
+            m_size     = other.m_size;
+            m_capacity = InlineCapacity;
+        }
+        else
+        {
+            m_pData    = other.m_pData;
+            m_size     = other.m_size;
+            m_capacity = other.m_capacity;
+            other.m_pData    = other.m_inline;
+            other.m_capacity = InlineCapacity;
+        }
+
+        other.m_size = 0;
+    }
+
+    void grow(std::size_t minCapacity)
+    {
+        std::size_t newCapacity = m_capacity*2u;
+        if (newCapacity<minCapacity)
+            newCapacity = minCapacity;
+        reallocate(newCapacity);
+    }
+
+    //! Переносит данные в буфер ёмкостью newCapacity (не меньше size()). Если помещаемся во встроенный буфер - переносим туда
+    void reallocate(std::size_t newCapacity)
+    {
+        std::uint8_t *pNewData = m_inline;
+        if (newCapacity>InlineCapacity)
+            pNewData = new std::uint8_t[newCapacity];
+        else
+            newCapacity = InlineCapacity;
+
+        if (pNewData==m_pData)
+            return;
+
+        if (m_size)
+            std::memcpy(pNewData, m_pData, m_size);
+
+        if (!isInline())
+            delete[] m_pData;
+
+        m_pData    = pNewData;
+        m_capacity = newCapacity;
+    }
+
+}; // class SmallByteVector
+
+//----------------------------------------------------------------------------
+
+} // namespace hex
+} // namespace marty
+// marty::hex::
+// marty_hex/small_byte_vector.h
+
@@ -5,6 +5,7 @@
 #pragma once
 
 //----------------------------------------------------------------------------
+#include "small_byte_vector.h"
 #include "utils.h"
 //
 #include <string>
@@ -26,14 +27,17 @@ namespace hex{
 
 
 //----------------------------------------------------------------------------
-// Для отладки используем вектор - в нём отладчик нормас отображает значения произвольных целых типов в векторе (особенно в MSVC)
-// Для релиза используем строку - у ней есть SSO, не лазает постоянно в память, короткие байтовые последовательности в ней хранить сам доктор прописал
-#if defined(_DEBUG) || defined(DEBUG)
-    using byte_vector = std::vector<std::uint8_t>;
-#else
-    using byte_vector = std::basic_string<std::uint8_t>;
+// Раньше для отладки был вектор, а для релиза - строка с её SSO. Но SSO заканчивается на 15 байтах,
+// и стандартные записи по 16 и 32 байта всё равно лезли в кучу. Теперь и в отладке, и в релизе
+// одно и то же - свой вектор со встроенным буфером, так что и замеры в отладке что-то значат.
+// Во время разбора в data лежат данные и КС, так что для 32-байтных записей надо минимум 33.
+// Максимум имеет смысл 255+5 - вся запись целиком
+#if !defined(MARTY_HEX_BYTE_VECTOR_INLINE_CAPACITY)
+    #define MARTY_HEX_BYTE_VECTOR_INLINE_CAPACITY 40
 #endif
 
+using byte_vector = SmallByteVector<MARTY_HEX_BYTE_VECTOR_INLINE_CAPACITY>;
+
 //----------------------------------------------------------------------------
 
 
@@ -52,6 +56,13 @@ void intVectorEraseHelper( std::vector<std::uint8_t> &vec, std::size_t offs, std
     vec.erase(vec.begin()+std::ptrdiff_t(offs), vec.begin()+std::ptrdiff_t(offs+sz));
 }
 
+//------------------------------
+template<std::size_t InlineCapacity>
+void intVectorEraseHelper( SmallByteVector<InlineCapacity> &vec, std::size_t offs, std::size_t sz)
+{
+    vec.erase(offs, sz);
+}
+
 //----------------------------------------------------------------------------
 
 
@@ -70,6 +81,13 @@ void intVectorAppendHelper( std::vector<std::uint8_t> &vec, std::uint8_t b)
     vec.emplace_back(b);
 }
 
+//------------------------------
+template<std::size_t InlineCapacity>
+void intVectorAppendHelper( SmallByteVector<InlineCapacity> &vec, std::uint8_t b)
+{
+    vec.push_back(b);
+}
+
 //----------------------------------------------------------------------------
 
 
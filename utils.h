@@ -6,9 +6,16 @@
 
 #include "enums.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <iterator>
 #include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
 
 //----------------------------------------------------------------------------
 
@@ -23,6 +30,114 @@ namespace utils {
 
 
 
+//----------------------------------------------------------------------------
+//! Номер младшего установленного бита. Для нуля результат не определён - проверяем снаружи
+inline
+unsigned countTrailingZeros32(std::uint32_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long idx = 0;
+    _BitScanForward(&idx, (unsigned long)v);
+    return (unsigned)idx;
+#elif defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(v);
+#else
+    unsigned idx = 0;
+    while((v&1u)==0) { v >>= 1; ++idx; }
+    return idx;
+#endif
+}
+
+//------------------------------
+//! Номер младшего установленного бита. Для нуля результат не определён - проверяем снаружи
+inline
+unsigned countTrailingZeros64(std::uint64_t v)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long idx = 0;
+    _BitScanForward64(&idx, (unsigned __int64)v);
+    return (unsigned)idx;
+#elif defined(_MSC_VER)
+    const std::uint32_t lo = std::uint32_t(v);
+    return lo ? countTrailingZeros32(lo) : 32u+countTrailingZeros32(std::uint32_t(v>>32));
+#elif defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctzll((unsigned long long)v);
+#else
+    unsigned idx = 0;
+    while((v&1u)==0) { v >>= 1; ++idx; }
+    return idx;
+#endif
+}
+
+//------------------------------
+//! Количество установленных битов
+inline
+unsigned popCount64(std::uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_popcountll((unsigned long long)v);
+#else
+    // MSVC __popcnt64 требует POPCNT от процессора, а проверять это ради битовых карт не хочется
+    v = v - ((v>>1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v>>2) & 0x3333333333333333ull);
+    v = (v + (v>>4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (unsigned)((v*0x0101010101010101ull)>>56);
+#endif
+}
+
+//------------------------------
+/*! Устойчивая LSD поразрядная сортировка по 32-битному ключу, по байту за проход. Ключ getKey(item) считается
+    один раз на элемент и на проход, сравнений нет вообще, время линейное. Проход, в котором у всех элементов
+    один и тот же байт ключа (обычно старшие байты адреса), пропускается. Элементы переносятся через std::move
+ */
+template<typename ItemType, typename KeyGetter>
+void radixSortByKey32(std::vector<ItemType> &items, KeyGetter getKey)
+{
+    if (items.size()<2)
+        return;
+
+    std::size_t counts[4][256] = {};
+    for(const auto &item : items)
+    {
+        const std::uint32_t key = getKey(item);
+        ++counts[0][ key     &0xFFu];
+        ++counts[1][(key>>8 )&0xFFu];
+        ++counts[2][(key>>16)&0xFFu];
+        ++counts[3][(key>>24)&0xFFu];
+    }
+
+    std::vector<ItemType> tmp(items.size());
+
+    for(unsigned pass=0; pass!=4u; ++pass)
+    {
+        const unsigned shift = pass*8u;
+        std::size_t *passCounts = counts[pass];
+
+        if (passCounts[(getKey(items[0])>>shift)&0xFFu]==items.size())
+            continue; // Все в одной корзине - порядок не меняется
+
+        std::size_t offs = 0;
+        for(unsigned b=0; b!=256u; ++b)
+        {
+            const std::size_t cnt = passCounts[b];
+            passCounts[b] = offs;
+            offs += cnt;
+        }
+
+        for(auto &item : items)
+        {
+            const std::size_t pos = passCounts[(getKey(item)>>shift)&0xFFu]++;
+            tmp[pos] = std::move(item);
+        }
+
+        items.swap(tmp);
+    }
+}
+
+//----------------------------------------------------------------------------
+
+
+
 //----------------------------------------------------------------------------
 inline 
 void prepareTextChunkForParsing(std::string &inputText)
@@ -58,6 +173,113 @@ char digitToChar(int d, bool bLower=false)
     return char((bLower?'a':'A')+d-10);
 }
 
+//----------------------------------------------------------------------------
+//! Таблица "байт -> две шестнадцатеричные цифры", 256 пар подряд. Вместо двух вызовов digitToChar на байт - одно чтение пары
+struct HexDigitPairs
+{
+    char chars[512];
+
+    constexpr explicit HexDigitPairs(bool bLower) : chars{}
+    {
+        for(unsigned b=0; b!=256u; ++b)
+        {
+            const unsigned hi = b>>4;
+            const unsigned lo = b&0xFu;
+            chars[2u*b   ] = char(hi<10u ? '0'+hi : (bLower?'a':'A')+hi-10u);
+            chars[2u*b+1u] = char(lo<10u ? '0'+lo : (bLower?'a':'A')+lo-10u);
+        }
+    }
+
+}; // struct HexDigitPairs
+
+inline constexpr const HexDigitPairs hexDigitPairsUpper = HexDigitPairs(false);
+inline constexpr const HexDigitPairs hexDigitPairsLower = HexDigitPairs(true );
+
+//------------------------------
+inline
+const char* getHexDigitPairs(bool bLower=false)
+{
+    return bLower ? &hexDigitPairsLower.chars[0] : &hexDigitPairsUpper.chars[0];
+}
+
+//------------------------------
+//! Максимальная длина текста записи без перевода строки: двоеточие, 4 байта заголовка, 255 байт данных и КС
+inline constexpr const std::size_t maxHexRecordTextSize = 1u + 2u*(4u+255u+1u);
+
+//------------------------------
+//! Размер текста записи без перевода строки
+inline
+std::size_t calcHexRecordTextSize(std::size_t dataSize, bool dontPrependColon=false)
+{
+    return (dontPrependColon ? 0u : 1u) + 2u*(4u+dataSize+1u);
+}
+
+//------------------------------
+/*! Форматирует запись в pDst (места - calcHexRecordTextSize), КС считается в том же проходе.
+    Для записей не-данных длина и адрес фиксированы типом записи, как и положено, данные пишутся как есть.
+    Возвращает указатель за последним записанным символом
+ */
+inline
+char* formatHexRecord( char *pDst
+                     , HexRecordType recordType
+                     , std::uint16_t address
+                     , const std::uint8_t *pData
+                     , std::size_t dataSize
+                     , const char *pDigitPairs
+                     , bool dontPrependColon=false
+                     )
+{
+    std::uint8_t header[4] = { 0, 0, 0, std::uint8_t(recordType) };
+
+    switch(recordType)
+    {
+        case HexRecordType::data:
+             header[0] = std::uint8_t(dataSize); // Переменное количество байт данных
+             header[1] = std::uint8_t(address>>8);
+             header[2] = std::uint8_t(address   );
+             break;
+
+        case HexRecordType::extendedSegmentAddress:
+        case HexRecordType::extendedLinearAddress:
+             header[0] = 2u; // Два байта данных всегда
+             break;
+
+        case HexRecordType::startSegmentAddress:
+        case HexRecordType::startLinearAddress:
+             header[0] = 4u; // Четыре байта данных всегда
+             break;
+
+        default: break; // EOF - нет данных всегда
+    }
+
+    if (!dontPrependColon)
+        *pDst++ = ':';
+
+    unsigned cs = 0;
+
+    for(auto b : header)
+    {
+        cs += b;
+        pDst[0] = pDigitPairs[2u*b   ];
+        pDst[1] = pDigitPairs[2u*b+1u];
+        pDst += 2;
+    }
+
+    for(std::size_t i=0; i!=dataSize; ++i)
+    {
+        const unsigned b = pData[i];
+        cs += b;
+        pDst[0] = pDigitPairs[2u*b   ];
+        pDst[1] = pDigitPairs[2u*b+1u];
+        pDst += 2;
+    }
+
+    const unsigned csByte = (0u-cs)&0xFFu;
+    pDst[0] = pDigitPairs[2u*csByte   ];
+    pDst[1] = pDigitPairs[2u*csByte+1u];
+    return pDst+2;
+}
+
 //----------------------------------------------------------------------------
 template<typename OutputIterator>
 OutputIterator byteToHex(std::uint8_t b, OutputIterator oit, bool bLower=false)